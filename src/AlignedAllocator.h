@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <new>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+///	Standard allocator returning memory aligned to <param ref="Alignment" /> bytes.
+/// The default keeps arrays on cache line boundaries.
+template<typename T, size_t Alignment = 64>
+class AlignedAllocator
+{
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	template<typename U>
+	struct rebind
+	{
+		typedef AlignedAllocator<U, Alignment> other;
+	};
+
+	AlignedAllocator()
+	{
+	}
+
+	template<typename U>
+	AlignedAllocator(const AlignedAllocator<U, Alignment>&)
+	{
+	}
+
+	T* allocate(size_t n)
+	{
+		if(n == 0) return nullptr;
+		void* p = nullptr;
+#ifdef _MSC_VER
+		p = _aligned_malloc(n * sizeof(T), Alignment);
+#else
+		if(posix_memalign(&p, Alignment, n * sizeof(T)) != 0) p = nullptr;
+#endif
+		if(p == nullptr) throw std::bad_alloc();
+		return static_cast<T*>(p);
+	}
+
+	void deallocate(T* p, size_t)
+	{
+#ifdef _MSC_VER
+		_aligned_free(p);
+#else
+		free(p);
+#endif
+	}
+
+	template<typename U>
+	bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+
+	template<typename U>
+	bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
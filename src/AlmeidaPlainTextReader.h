@@ -5,6 +5,7 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
 #include "IFsaReader.h"
+#include "FsaBuilder.h"
 
 template<typename TFsa>
 class AlmeidaPlainTextReader : public IFsaReader<TFsa>
@@ -52,7 +53,9 @@ public:
 		getline(str, line);
 		trim_left(line);
 
-		TFsa fsa(alpha, states);
+		FsaBuilder<TFsa> fsa(alpha, states);
+		typename FsaBuilder<TFsa>::TEdgeBatch edges;
+		edges.reserve(static_cast<size_t>(alpha) * states);
 
 		bool reading_finals = false;
 		auto n = line.begin();
@@ -72,7 +75,7 @@ public:
 			else 
 			{
 				auto qt = lexical_cast<TFsa::TSymbol>(token);
-				fsa.SetTransition(qs, a, qt);					
+				edges.emplace_back(qs, a, qt);
 				if(a++ == alpha - 1)
 				{
 					a = 0;
@@ -98,8 +101,9 @@ public:
 		}
 
 		fsa.SetInitial(0);
+		fsa.AddEdges(move(edges));
 
-		return fsa;
+		return fsa.Build();
 	}
 
 };
\ No newline at end of file
@@ -0,0 +1,249 @@
+#pragma once
+
+#include "Set.h"
+#include "Span.h"
+#include "Dfa.h"
+#include "InverseIndex.h"
+#include "AlignedAllocator.h"
+#include <vector>
+#include <stdexcept>
+#include <tuple>
+#include <limits>
+#include <type_traits>
+#include <cassert>
+
+/// Order of the transition table of CompactDfa
+enum class DfaLayout
+{
+	/// successors of one state are contiguous, best for forward walks
+	StateMajor,
+	/// successors of every state consuming one symbol are contiguous, best for partition refinement
+	SymbolMajor
+};
+
+///	Immutable Deterministic Finite Automata tuned for minimization.
+/// The transition table and the inverse function are built once, both 64-byte aligned,
+/// and states are stored using <param ref="TStorage" />, which may be narrower than <param ref="TState" />.
+/// It has the read-only interface of Dfa, so minimization algorithms can be instantiated on it.
+/// Every transition is defined, partial DFAs must be completed first.
+///	<param ref="TState" /> is the integer type representing states.
+///	<param ref="TSymbol" /> is the integer type representing symbols.
+///	<param ref="Layout" /> selects the transition table order.
+///	<param ref="TStorage" /> is the integer type used to store states, it must hold every state.
+///	<param ref="TToken" /> is the integer type used in order to manage internal storage of BitSets.
+template<typename _TState, typename _TSymbol, DfaLayout _Layout = DfaLayout::SymbolMajor, typename _TStorage = _TState, typename _TToken = uint64_t>
+class CompactDfa
+{
+public:
+	typedef _TState TState;
+	typedef _TSymbol TSymbol;
+	typedef _TStorage TStorage;
+	typedef _TToken TToken;
+	typedef BitSet<TState, TToken> TSet;
+	typedef std::tuple<TState,TSymbol,TState> TEdge;
+	typedef std::vector<TStorage, AlignedAllocator<TStorage>> TTable;
+	typedef InverseIndex<TStorage, TSymbol, AlignedAllocator<TStorage>> TInverseIndex;
+	typedef typename TInverseIndex::TSpan TStateSpan;
+	typedef Span<TStorage> TSuccessorSpan;
+	typedef Dfa<TState, TSymbol, TToken> TDfa;
+
+	static const DfaLayout Layout = _Layout;
+
+private:
+	/// number of symbols in alphabet
+	TSymbol Alphabet;
+
+	/// states back field
+	TState States;
+
+	/// Initial states set
+	TSet Initial;
+
+	/// Final states set
+	TSet Final;
+
+	/// Function to calculate next state, ordered by Layout
+	TTable Succesors;
+
+	/// Inverse function
+	TInverseIndex Predecessors;
+
+	size_t Index(TState source, TSymbol symbol) const
+	{
+		if(Layout == DfaLayout::SymbolMajor) return static_cast<size_t>(symbol) * States + source;
+		return static_cast<size_t>(source) * Alphabet + symbol;
+	}
+
+	void CheckLimits() const
+	{
+		assert(States < std::numeric_limits<TState>::max());
+		assert(States < std::numeric_limits<TStorage>::max());
+		assert(Alphabet < std::numeric_limits<TSymbol>::max());
+	}
+
+	void BuildPredecessors()
+	{
+		const TStorage* succ = Succesors.data();
+		const TSymbol alpha = Alphabet;
+		const TState states = States;
+		Predecessors.Build(alpha, static_cast<TStorage>(states), [succ, alpha, states](TStorage qs, TSymbol a) -> TStorage
+		{
+			if(Layout == DfaLayout::SymbolMajor) return succ[static_cast<size_t>(a) * states + qs];
+			return succ[static_cast<size_t>(qs) * alpha + a];
+		});
+	}
+
+	template<typename TOtherDfa>
+	void CopyTable(const TOtherDfa& dfa)
+	{
+		Succesors.resize(static_cast<size_t>(States) * Alphabet);
+		for(TState qs=0; qs<States; qs++)
+		{
+			for(TSymbol a=0; a<Alphabet; a++)
+			{
+				Succesors[Index(qs, a)] = static_cast<TStorage>(dfa.GetSuccessor(qs, a));
+			}
+		}
+		BuildPredecessors();
+	}
+
+	/// Same table type and order, both arrays are taken from the DFA
+	void TakeTable(TDfa& dfa, std::true_type)
+	{
+		dfa.Release(Succesors, Predecessors);
+	}
+
+	void TakeTable(TDfa& dfa, std::false_type)
+	{
+		CopyTable(dfa);
+	}
+
+public:
+
+	const TSet& GetInitials() const
+	{
+		return Initial;
+	}
+
+	const TSet& GetFinals() const
+	{
+		return Final;
+	}
+
+	/// Creates the DFA with every transition in <param ref="edges" />, in any order.
+	/// Missing transitions go to state zero.
+	/// O(edges + states * alphabet)
+	CompactDfa(TSymbol alpha, TState states, const TSet& initials, const TSet& finals, const std::vector<TEdge>& edges)
+		: States(states), Alphabet(alpha), Initial(initials), Final(finals), Succesors(static_cast<size_t>(alpha) * states)
+	{
+		CheckLimits();
+		for(const auto& e : edges)
+		{
+			assert(std::get<0>(e) < States);
+			assert(std::get<1>(e) < Alphabet);
+			assert(std::get<2>(e) < States);
+			Succesors[Index(std::get<0>(e), std::get<1>(e))] = static_cast<TStorage>(std::get<2>(e));
+		}
+		BuildPredecessors();
+	}
+
+	/// Copies <param ref="dfa" /> into this layout
+	/// O(states * alphabet)
+	template<typename TOtherDfa>
+	explicit CompactDfa(const TOtherDfa& dfa)
+		: States(dfa.GetStates()), Alphabet(dfa.GetAlphabetLength()), Initial(dfa.GetInitials()), Final(dfa.GetFinals())
+	{
+		if(!dfa.IsComplete()) throw std::invalid_argument("partial DFA, complete it first");
+		CheckLimits();
+		CopyTable(dfa);
+	}
+
+	/// Converts <param ref="dfa" />, which is left without states.
+	/// Zero-copy when the layout is StateMajor and TStorage is TState, O(states * alphabet) otherwise.
+	explicit CompactDfa(TDfa&& dfa)
+		: States(dfa.GetStates()), Alphabet(dfa.GetAlphabetLength()), Initial(dfa.GetInitials()), Final(dfa.GetFinals())
+	{
+		if(!dfa.IsComplete()) throw std::invalid_argument("partial DFA, complete it first");
+		CheckLimits();
+		TakeTable(dfa, std::integral_constant<bool, Layout == DfaLayout::StateMajor && std::is_same<TStorage, TState>::value>());
+	}
+
+	/// Get the number of symbols in alphabet
+	/// O(1)
+	TSymbol GetAlphabetLength() const { return Alphabet; }
+
+	/// Get maximum number of states of this DFA
+	/// O(1)
+	TState GetStates() const { return States; }
+
+	/// Always true, see Dfa
+	bool IsComplete() const { return true; }
+
+	/// Get the target state transitioned from <param ref="source" /> consuming <param ref="symbol" />
+	/// O(1)
+	TState GetSuccessor(TState source, TSymbol symbol) const
+	{
+		assert(source < States);
+		assert(symbol < Alphabet);
+
+		return Succesors[Index(source, symbol)];
+	}
+
+	/// Asks the cache for the transitions of <param ref="source" />, a search calls it ahead of GetSuccessor.
+	/// Only a hint, the symbol major layout fetches the first letter only. O(1)
+	void PrefetchSuccessors(TState source) const
+	{
+		assert(source < States);
+		BITSET_KERNELS_PREFETCH(Succesors.data() + Index(source, 0));
+	}
+
+	/// Get the targets of every state consuming <param ref="symbol" />, indexed by source state.
+	/// Only available on the SymbolMajor layout.
+	/// O(1)
+	TSuccessorSpan GetSymbolSuccessors(TSymbol symbol) const
+	{
+		static_assert(Layout == DfaLayout::SymbolMajor, "GetSymbolSuccessors requires the SymbolMajor layout");
+		assert(symbol < Alphabet);
+
+		const TStorage* base = Succesors.data() + static_cast<size_t>(symbol) * States;
+		return TSuccessorSpan(base, base + States);
+	}
+
+	/// Get the source states transitioned to <param ref="target" /> consuming <param ref="symbol"/>
+	/// The span is sorted.
+	/// O(1)
+	TStateSpan GetPredecessors(TState target, TSymbol symbol) const
+	{
+		assert(target < States);
+		assert(symbol < Alphabet);
+
+		return Predecessors.Get(static_cast<TStorage>(target), symbol);
+	}
+
+	/// Check if state <param ref="target" /> is reach from state <param ref="source" /> consuming symbol <param ref="symbol" />
+	/// O(1)
+	bool IsSuccessor(TState source, TSymbol symbol, TState target) const
+	{
+		assert(target < States);
+
+		return GetSuccessor(source, symbol) == target;
+	}
+
+	/// Indicates if <param ref="state" /> is a Final State
+	/// O(1)
+	bool IsFinal(TState state) const
+	{
+		assert(state < States);
+
+		return Final.Contains(state);
+	}
+
+	/// Indicates if <param ref="state" /> is an Initial State
+	/// O(1)
+	bool IsInitial(TState state) const
+	{
+		assert(state < States);
+
+		return Initial.Contains(state);
+	}
+};
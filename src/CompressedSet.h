@@ -0,0 +1,768 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <stdint.h>
+#include <assert.h>
+#include <boost/functional/hash.hpp>
+#include "dynamic_bitset.h"
+
+///	Set of integers in [0, elements) whose memory grows with its contents instead of its capacity.
+/// Elements are grouped in chunks of 2^16 values sharing the high bits, every non-empty chunk is a container
+/// holding the low 16 bits in the cheapest of three forms (Roaring bitmaps, Lemire et al.):
+/// a sorted array for sparse chunks, a 2^16 bits bitmap for dense chunks, or a list of runs of consecutive values.
+/// It has the interface of BitSet, so it can be used as the TSet of Nfa, Determinization and MinimizationAtomic.
+///	<param ref="TElement" /> is the integer type of the elements.
+template<typename _TElement>
+class CompressedSet
+{
+public:
+	typedef _TElement TElement;
+	typedef CompressedSet<TElement> TSet;
+
+private:
+	/// values per chunk
+	static const size_t ChunkBits = 16;
+	static const size_t ChunkSize = size_t(1) << ChunkBits;
+	/// blocks of a bitmap container
+	static const size_t BitmapWords = ChunkSize / 64;
+	/// arrays bigger than this take more room than a full bitmap
+	static const size_t ArrayMax = 4096;
+
+	enum class Kind : uint8_t
+	{
+		Array,
+		Bitmap,
+		Run
+	};
+
+	struct Container
+	{
+		size_t Key;
+		Kind Type;
+		uint32_t Cardinality;
+		/// blocks of the bitmap form, fewer than BitmapWords when the set ends inside this chunk
+		uint32_t Width;
+		/// Array: sorted values, Run: pairs (start, length - 1) sorted by start
+		std::vector<uint16_t> Values;
+		/// Bitmap: Width blocks
+		std::vector<uint64_t> Words;
+
+		Container(size_t key, size_t width)
+			: Key(key), Type(Kind::Array), Cardinality(0), Width(static_cast<uint32_t>(width))
+		{
+		}
+
+		/// arrays bigger than this take more room than the bitmap
+		size_t ArrayLimit() const
+		{
+			return std::min<size_t>(ArrayMax, Width * 4);
+		}
+
+		size_t Runs() const
+		{
+			return Values.size() / 2;
+		}
+
+		bool Contains(uint16_t v) const
+		{
+			switch(Type)
+			{
+			case Kind::Array:
+				return std::binary_search(Values.begin(), Values.end(), v);
+			case Kind::Bitmap:
+				return (Words[v >> 6] >> (v & 63)) & 1;
+			default:
+				{
+					const size_t r = FindRun(v);
+					return r < Runs() && v >= Values[2 * r] && v - Values[2 * r] <= Values[2 * r + 1];
+				}
+			}
+		}
+
+		/// Last run starting at or before <param ref="v" />, Runs() if there is none
+		size_t FindRun(uint16_t v) const
+		{
+			size_t lo = 0, hi = Runs();
+			while(lo < hi)
+			{
+				const size_t mid = (lo + hi) / 2;
+				if(Values[2 * mid] <= v) lo = mid + 1;
+				else hi = mid;
+			}
+			return lo == 0 ? Runs() : lo - 1;
+		}
+
+		/// Adds the container to the bitmap <param ref="words" />
+		void Decode(uint64_t* words) const
+		{
+			switch(Type)
+			{
+			case Kind::Array:
+				for(auto v : Values) words[v >> 6] |= uint64_t(1) << (v & 63);
+				break;
+			case Kind::Bitmap:
+				for(size_t i=0; i<Width; i++) words[i] |= Words[i];
+				break;
+			default:
+				for(size_t r=0; r<Runs(); r++)
+				{
+					const size_t b = Values[2 * r], e = b + Values[2 * r + 1];
+					for(size_t v=b; v<=e; v++) words[v >> 6] |= uint64_t(1) << (v & 63);
+				}
+				break;
+			}
+		}
+
+		/// Stores <param ref="words" /> in the smallest form
+		void Encode(const uint64_t* words)
+		{
+			uint32_t card = 0;
+			size_t runs = 0;
+			for(size_t i=0; i<Width; i++)
+			{
+				const uint64_t w = words[i];
+				card += static_cast<uint32_t>(Popcount(w));
+				// a run starts at every 1 preceded by a 0
+				const uint64_t prev = (w << 1) | (i > 0 ? words[i - 1] >> 63 : 0);
+				runs += Popcount(w & ~prev);
+			}
+			Cardinality = card;
+			Values.clear();
+			Words.clear();
+			if(runs * 4 < std::min<size_t>(card * 2, Width * 8))
+			{
+				Type = Kind::Run;
+				Values.reserve(runs * 2);
+				const size_t end = Width * 64;
+				for(size_t v=0; v<end; )
+				{
+					if(!((words[v >> 6] >> (v & 63)) & 1)) { v++; continue; }
+					const size_t b = v;
+					while(v < end && ((words[v >> 6] >> (v & 63)) & 1)) v++;
+					Values.push_back(static_cast<uint16_t>(b));
+					Values.push_back(static_cast<uint16_t>(v - 1 - b));
+				}
+			}
+			else if(card <= ArrayLimit())
+			{
+				Type = Kind::Array;
+				Values.reserve(card);
+				for(size_t i=0; i<Width; i++)
+				{
+					for(uint64_t w = words[i]; w; w &= w - 1) Values.push_back(static_cast<uint16_t>(i * 64 + LowestBit(w)));
+				}
+			}
+			else
+			{
+				Type = Kind::Bitmap;
+				Words.assign(words, words + Width);
+			}
+		}
+
+		/// Switches a sorted array to runs when they are smaller
+		void Compact()
+		{
+			if(Type != Kind::Array || Values.empty()) return;
+			size_t runs = 1;
+			for(size_t i=1; i<Values.size(); i++) if(Values[i] != Values[i - 1] + 1) runs++;
+			if(runs * 4 >= Values.size() * 2) return;
+			std::vector<uint16_t> pairs;
+			pairs.reserve(runs * 2);
+			for(size_t i=0; i<Values.size(); )
+			{
+				size_t j = i + 1;
+				while(j < Values.size() && Values[j] == Values[j - 1] + 1) j++;
+				pairs.push_back(Values[i]);
+				pairs.push_back(static_cast<uint16_t>(j - 1 - i));
+				i = j;
+			}
+			Values.swap(pairs);
+			Type = Kind::Run;
+		}
+
+		/// Turns a run container into an array or a bitmap so it can be modified in place
+		void Expand()
+		{
+			if(Type != Kind::Run) return;
+			if(Cardinality <= ArrayLimit())
+			{
+				std::vector<uint16_t> values;
+				values.reserve(Cardinality);
+				for(size_t r=0; r<Runs(); r++)
+				{
+					const size_t b = Values[2 * r], e = b + Values[2 * r + 1];
+					for(size_t v=b; v<=e; v++) values.push_back(static_cast<uint16_t>(v));
+				}
+				Values.swap(values);
+				Type = Kind::Array;
+			}
+			else
+			{
+				std::vector<uint64_t> words(Width, 0);
+				Decode(words.data());
+				Values.clear();
+				Words.swap(words);
+				Type = Kind::Bitmap;
+			}
+		}
+
+		/// Returns true if <param ref="v" /> was not present
+		bool Add(uint16_t v)
+		{
+			Expand();
+			if(Type == Kind::Bitmap)
+			{
+				uint64_t& w = Words[v >> 6];
+				const uint64_t m = uint64_t(1) << (v & 63);
+				if(w & m) return false;
+				w |= m;
+				Cardinality++;
+				return true;
+			}
+			auto i = std::lower_bound(Values.begin(), Values.end(), v);
+			if(i != Values.end() && *i == v) return false;
+			if(Cardinality == ArrayLimit())
+			{
+				std::vector<uint64_t> words(Width, 0);
+				Decode(words.data());
+				words[v >> 6] |= uint64_t(1) << (v & 63);
+				Values.clear();
+				Words.swap(words);
+				Type = Kind::Bitmap;
+			}
+			else
+			{
+				Values.insert(i, v);
+			}
+			Cardinality++;
+			return true;
+		}
+
+		/// Returns true if <param ref="v" /> was present
+		bool Remove(uint16_t v)
+		{
+			Expand();
+			if(Type == Kind::Bitmap)
+			{
+				uint64_t& w = Words[v >> 6];
+				const uint64_t m = uint64_t(1) << (v & 63);
+				if(!(w & m)) return false;
+				w &= ~m;
+				// back to an array once it is clearly smaller
+				if(--Cardinality <= ArrayLimit() / 2)
+				{
+					std::vector<uint64_t> words;
+					words.swap(Words);
+					Encode(words.data());
+				}
+				return true;
+			}
+			auto i = std::lower_bound(Values.begin(), Values.end(), v);
+			if(i == Values.end() || *i != v) return false;
+			Values.erase(i);
+			Cardinality--;
+			return true;
+		}
+
+		bool Equals(const Container& other) const
+		{
+			if(Key != other.Key || Cardinality != other.Cardinality) return false;
+			if(Type == other.Type) return Values == other.Values && Words == other.Words;
+			std::vector<uint64_t> a(Width, 0), b(Width, 0);
+			Decode(a.data());
+			other.Decode(b.data());
+			return a == b;
+		}
+	};
+
+	/// Capacity, kept for compatibility with BitSet
+	TElement Elements;
+
+	/// non-empty containers sorted by key
+	std::vector<Container> Containers;
+
+	static size_t Popcount(uint64_t x)
+	{
+		return bitset_kernels::scalar_popcnt(x);
+	}
+
+	/// <param ref="x" /> must not be zero
+	static size_t LowestBit(uint64_t x)
+	{
+		return bitutil<uint64_t, size_t>::ctz(x);
+	}
+
+	static size_t KeyOf(TElement e)
+	{
+		return static_cast<size_t>(e) >> ChunkBits;
+	}
+
+	static uint16_t LowOf(TElement e)
+	{
+		return static_cast<uint16_t>(static_cast<size_t>(e) & (ChunkSize - 1));
+	}
+
+	/// Blocks of a bitmap holding the values of the chunk <param ref="key" /> below Elements
+	size_t WidthOf(size_t key) const
+	{
+		const size_t rest = static_cast<size_t>(Elements) - (key << ChunkBits);
+		return std::min<size_t>(BitmapWords, (rest + 63) / 64);
+	}
+
+	/// Index of the container with <param ref="key" /> or where it would be inserted
+	size_t Find(size_t key) const
+	{
+		size_t lo = 0, hi = Containers.size();
+		while(lo < hi)
+		{
+			const size_t mid = (lo + hi) / 2;
+			if(Containers[mid].Key < key) lo = mid + 1;
+			else hi = mid;
+		}
+		return lo;
+	}
+
+	static Container Union(const Container& a, const Container& b)
+	{
+		assert(a.Width == b.Width);
+		Container r(a.Key, a.Width);
+		if(a.Type == Kind::Array && b.Type == Kind::Array && a.Cardinality + b.Cardinality <= a.ArrayLimit())
+		{
+			r.Values.resize(a.Values.size() + b.Values.size());
+			auto e = std::set_union(a.Values.begin(), a.Values.end(), b.Values.begin(), b.Values.end(), r.Values.begin());
+			r.Values.erase(e, r.Values.end());
+			r.Cardinality = static_cast<uint32_t>(r.Values.size());
+			r.Compact();
+			return r;
+		}
+		std::vector<uint64_t> words(a.Width, 0);
+		a.Decode(words.data());
+		b.Decode(words.data());
+		r.Encode(words.data());
+		return r;
+	}
+
+	static Container Intersect(const Container& a, const Container& b)
+	{
+		assert(a.Width == b.Width);
+		Container r(a.Key, a.Width);
+		if(a.Type == Kind::Array || b.Type == Kind::Array)
+		{
+			const Container& small = a.Type == Kind::Array ? a : b;
+			const Container& other = a.Type == Kind::Array ? b : a;
+			for(auto v : small.Values) if(other.Contains(v)) r.Values.push_back(v);
+			r.Cardinality = static_cast<uint32_t>(r.Values.size());
+			r.Compact();
+			return r;
+		}
+		std::vector<uint64_t> x(a.Width, 0), y(a.Width, 0);
+		a.Decode(x.data());
+		b.Decode(y.data());
+		for(size_t i=0; i<a.Width; i++) x[i] &= y[i];
+		r.Encode(x.data());
+		return r;
+	}
+
+	static Container Difference(const Container& a, const Container& b)
+	{
+		assert(a.Width == b.Width);
+		Container r(a.Key, a.Width);
+		if(a.Type == Kind::Array)
+		{
+			for(auto v : a.Values) if(!b.Contains(v)) r.Values.push_back(v);
+			r.Cardinality = static_cast<uint32_t>(r.Values.size());
+			r.Compact();
+			return r;
+		}
+		std::vector<uint64_t> x(a.Width, 0), y(a.Width, 0);
+		a.Decode(x.data());
+		b.Decode(y.data());
+		for(size_t i=0; i<a.Width; i++) x[i] &= ~y[i];
+		r.Encode(x.data());
+		return r;
+	}
+
+	static const TSet& Deref(const TSet& set) { return set; }
+	static const TSet& Deref(const TSet* set) { return *set; }
+
+public:
+
+	struct hash
+	{
+		size_t operator()(const TSet& _Keyval) const
+		{
+			// depends only on the elements, not on the form of each container
+			size_t seed = 0;
+			for(auto i=_Keyval.GetIterator(); !i.IsEnd(); i.MoveNext())
+			{
+				boost::hash_combine(seed, static_cast<size_t>(i.GetCurrent()));
+			}
+			return seed;
+		}
+	};
+
+	explicit CompressedSet(TElement elements)
+		: Elements(elements)
+	{
+	}
+
+	void Clear()
+	{
+		Containers.clear();
+	}
+
+	/// O(log chunks + chunk elements)
+	void Add(const TElement& element)
+	{
+		TestAndAdd(element);
+	}
+
+	void Remove(const TElement& element)
+	{
+		TestAndRemove(element);
+	}
+
+	bool TestAndAdd(const TElement& element)
+	{
+		assert(static_cast<size_t>(element) < static_cast<size_t>(Elements));
+		const size_t key = KeyOf(element);
+		const size_t i = Find(key);
+		if(i == Containers.size() || Containers[i].Key != key)
+		{
+			Containers.insert(Containers.begin() + i, Container(key, WidthOf(key)));
+		}
+		return !Containers[i].Add(LowOf(element));
+	}
+
+	bool TestAndRemove(const TElement& element)
+	{
+		const size_t key = KeyOf(element);
+		const size_t i = Find(key);
+		if(i == Containers.size() || Containers[i].Key != key) return false;
+		const bool was = Containers[i].Remove(LowOf(element));
+		if(Containers[i].Cardinality == 0) Containers.erase(Containers.begin() + i);
+		return was;
+	}
+
+	/// O(log chunks + log chunk elements)
+	bool Contains(const TElement& element) const
+	{
+		const size_t key = KeyOf(element);
+		const size_t i = Find(key);
+		return i < Containers.size() && Containers[i].Key == key && Containers[i].Contains(LowOf(element));
+	}
+
+	bool IsEmpty() const
+	{
+		return Containers.empty();
+	}
+
+	TElement Count() const
+	{
+		size_t c = 0;
+		for(const auto& ct : Containers) c += ct.Cardinality;
+		return static_cast<TElement>(c);
+	}
+
+	/// Get the number of bytes held by the containers
+	size_t GetMemoryUsage() const
+	{
+		size_t bytes = Containers.capacity() * sizeof(Container);
+		for(const auto& ct : Containers) bytes += ct.Values.capacity() * sizeof(uint16_t) + ct.Words.capacity() * sizeof(uint64_t);
+		return bytes;
+	}
+
+	TElement GetElementAt(TElement pos) const
+	{
+		auto i = GetIterator();
+		while(pos--) i.MoveNext();
+		return i.GetCurrent();
+	}
+
+	void UnionWith(const TSet& other)
+	{
+		std::vector<Container> r;
+		r.reserve(Containers.size() + other.Containers.size());
+		size_t i = 0, j = 0;
+		while(i < Containers.size() || j < other.Containers.size())
+		{
+			if(j == other.Containers.size() || (i < Containers.size() && Containers[i].Key < other.Containers[j].Key))
+			{
+				r.push_back(std::move(Containers[i++]));
+			}
+			else if(i == Containers.size() || other.Containers[j].Key < Containers[i].Key)
+			{
+				r.push_back(other.Containers[j++]);
+			}
+			else
+			{
+				r.push_back(Union(Containers[i++], other.Containers[j++]));
+			}
+		}
+		Containers.swap(r);
+	}
+
+	/// Adds every set of [<param ref="first" />, <param ref="last" />), a range of sets or of pointers to sets.
+	/// O(inputs * elements)
+	template<typename TIterator>
+	void UnionWithMany(TIterator first, TIterator last)
+	{
+		for(; first != last; ++first) UnionWith(Deref(*first));
+	}
+
+	/// Replaces this set with the union of [<param ref="first" />, <param ref="last" />), a range of sets or of pointers to sets.
+	/// Returns the number of elements of the result if <param ref="count" /> is set, zero otherwise.
+	/// O(inputs * elements)
+	template<typename TIterator>
+	TElement UnionOf(TIterator first, TIterator last, bool count = false)
+	{
+		Clear();
+		UnionWithMany(first, last);
+		return count ? Count() : 0;
+	}
+
+	void IntersectWith(const TSet& other)
+	{
+		std::vector<Container> r;
+		size_t i = 0, j = 0;
+		while(i < Containers.size() && j < other.Containers.size())
+		{
+			if(Containers[i].Key < other.Containers[j].Key) i++;
+			else if(other.Containers[j].Key < Containers[i].Key) j++;
+			else
+			{
+				Container c = Intersect(Containers[i++], other.Containers[j++]);
+				if(c.Cardinality) r.push_back(std::move(c));
+			}
+		}
+		Containers.swap(r);
+	}
+
+	void DifferenceWith(const TSet& other)
+	{
+		std::vector<Container> r;
+		r.reserve(Containers.size());
+		size_t j = 0;
+		for(size_t i=0; i<Containers.size(); i++)
+		{
+			while(j < other.Containers.size() && other.Containers[j].Key < Containers[i].Key) j++;
+			if(j == other.Containers.size() || other.Containers[j].Key != Containers[i].Key)
+			{
+				r.push_back(std::move(Containers[i]));
+				continue;
+			}
+			Container c = Difference(Containers[i], other.Containers[j]);
+			if(c.Cardinality) r.push_back(std::move(c));
+		}
+		Containers.swap(r);
+	}
+
+	static TSet Union(const TSet& lh, const TSet& rh)
+	{
+		TSet new_set(lh);
+		new_set.UnionWith(rh);
+		return new_set;
+	}
+
+	static TSet Intersect(const TSet& lh, const TSet& rh)
+	{
+		TSet new_set(lh);
+		new_set.IntersectWith(rh);
+		return new_set;
+	}
+
+	static TSet Difference(const TSet& lh, const TSet& rh)
+	{
+		TSet new_set(lh);
+		new_set.DifferenceWith(rh);
+		return new_set;
+	}
+
+	/// Forward iterator over the elements in increasing order
+	class Iterator
+	{
+	private:
+		const std::vector<Container>* containers;
+		size_t ci;
+		/// position in Values (array, run) or block index (bitmap)
+		size_t pos;
+		/// offset inside the current run, for bitmaps it is set once word holds block pos
+		size_t offset;
+		/// remaining bits of the current bitmap block
+		uint64_t word;
+		TElement current;
+
+		explicit Iterator(const std::vector<Container>* _containers)
+			: containers(_containers), ci(0), pos(0), offset(0), word(0)
+		{
+			Load();
+		}
+
+		friend TSet;
+
+		/// Positions on the first element at or after the current location
+		void Load()
+		{
+			for(; ci < containers->size(); ci++, pos = 0, offset = 0, word = 0)
+			{
+				const Container& c = (*containers)[ci];
+				const size_t base = c.Key << ChunkBits;
+				switch(c.Type)
+				{
+				case Kind::Array:
+					if(pos < c.Values.size())
+					{
+						current = static_cast<TElement>(base + c.Values[pos]);
+						return;
+					}
+					break;
+				case Kind::Run:
+					if(pos < c.Values.size())
+					{
+						current = static_cast<TElement>(base + c.Values[pos] + offset);
+						return;
+					}
+					break;
+				default:
+					if(!offset)
+					{
+						word = c.Words[pos];
+						offset = 1;
+					}
+					while(!word && ++pos < c.Width) word = c.Words[pos];
+					if(word)
+					{
+						current = static_cast<TElement>(base + pos * 64 + LowestBit(word));
+						return;
+					}
+					break;
+				}
+			}
+		}
+
+	public:
+		void MoveNext()
+		{
+			const Container& c = (*containers)[ci];
+			switch(c.Type)
+			{
+			case Kind::Array:
+				pos++;
+				break;
+			case Kind::Run:
+				if(++offset > c.Values[pos + 1])
+				{
+					offset = 0;
+					pos += 2;
+				}
+				break;
+			default:
+				word &= word - 1;
+				break;
+			}
+			Load();
+		}
+
+		bool IsEnd() const
+		{
+			return ci == containers->size();
+		}
+
+		TElement GetCurrent() const
+		{
+			return current;
+		}
+
+		bool Equals(const Iterator& rh) const
+		{
+			return rh.ci == ci && (IsEnd() || rh.current == current);
+		}
+
+		bool operator ==(const Iterator& rh) const
+		{
+			return Equals(rh);
+		}
+
+		bool operator !=(const Iterator& rh) const
+		{
+			return !Equals(rh);
+		}
+	};
+
+	Iterator GetIterator() const
+	{
+		return Iterator(&Containers);
+	}
+
+	/// Writes every element into <param ref="out" /> in increasing order and returns how many were written.
+	/// <param ref="out" /> must have room for Count() elements.
+	/// O(containers + count)
+	TElement ExtractTo(TElement* out) const
+	{
+		TElement* const first = out;
+		for(const auto& c : Containers)
+		{
+			const TElement base = static_cast<TElement>(c.Key << ChunkBits);
+			switch(c.Type)
+			{
+			case Kind::Array:
+				for(auto v : c.Values) *out++ = static_cast<TElement>(base + v);
+				break;
+			case Kind::Bitmap:
+				out += blockutil<uint64_t>::extract(c.Words.data(), c.Width, base, out);
+				break;
+			default:
+				for(size_t r=0; r<c.Runs(); r++)
+				{
+					const size_t b = c.Values[2 * r], e = b + c.Values[2 * r + 1];
+					for(size_t v=b; v<=e; v++) *out++ = static_cast<TElement>(base + v);
+				}
+				break;
+			}
+		}
+		return static_cast<TElement>(out - first);
+	}
+
+	bool operator==(const TSet& rh) const
+	{
+		if(Containers.size() != rh.Containers.size()) return false;
+		for(size_t i=0; i<Containers.size(); i++)
+		{
+			if(!Containers[i].Equals(rh.Containers[i])) return false;
+		}
+		return true;
+	}
+
+	bool operator!=(const TSet& rh) const
+	{
+		return !(*this == rh);
+	}
+
+	std::string to_string() const
+	{
+		std::string str("{");
+		bool b = false;
+		for(auto i=GetIterator(); !i.IsEnd(); i.MoveNext())
+		{
+			if(b) str.append(", ");
+			b = true;
+			str.append(std::to_string(static_cast<size_t>(i.GetCurrent())));
+		}
+		str.append("}");
+		return str;
+	}
+};
+
+template<typename _TElement>
+const size_t CompressedSet<_TElement>::ChunkBits;
+
+template<typename _TElement>
+const size_t CompressedSet<_TElement>::ChunkSize;
+
+template<typename _TElement>
+const size_t CompressedSet<_TElement>::BitmapWords;
+
+template<typename _TElement>
+const size_t CompressedSet<_TElement>::ArrayMax;
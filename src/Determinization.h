@@ -2,10 +2,12 @@
 #pragma once
 
 #include <vector>
+#include <list>
 #include <algorithm>
 #include <unordered_map>
 #include <map>
 #include <tuple>
+#include "FsaBuilder.h"
 
 template<typename TDfa, typename TNfa, typename TSet=typename TNfa::TSet, typename TSetHash=typename TSet::hash>
 class Determinization
@@ -55,18 +57,16 @@ public:
 		}
 		
 		TSet next(nfa.GetStates());
+		// estados del conjunto actual, se decodifican una vez para todos los simbolos
+		vector<TNfaState> sources(nfa.GetStates());
 		
 		TDfaState current_state_index = 0;
 		for(auto current_it=new_states_lst.cbegin(); current_it != new_states_lst.cend(); current_it++)
 		{			
+			const TNfaState* const sources_end = sources.data() + current_it->ExtractTo(sources.data());
 			for(TSymbol c=0; c<nfa.GetAlphabetLength(); c++)
 			{				
-				next.Clear();
-				for(auto s=current_it->GetIterator(); !s.IsEnd(); s.MoveNext())
-				{
-					TNfaState qs = s.GetCurrent();
-					next.UnionWith(nfa.GetSuccessors(qs, c));
-				}
+				nfa.GatherSuccessors(sources.data(), sources_end, c, next);
 				TDfaState target_state_index = static_cast<TDfaState>(new_states_lst.size());
 				// intenta insertar el conjunto de estados, si ya lo contiene no hace nada
 				auto fn = new_states_map.insert(typename TStatesMap::value_type(next, target_state_index));
@@ -97,20 +97,14 @@ public:
 	{
 		using namespace std;
 		// el dfa solo puede ser creado aqui porque no es mutable
-		TDfa dfa(symbols, states);
+		FsaBuilder<TDfa> dfa(symbols, states);
 		if(states > 0) dfa.SetInitial(0);
 		for(auto f : final_states)
 		{
 			dfa.SetFinal(f);
 		}
-		for(auto edge : new_edges)
-		{
-			TDfaState qs, qt;
-			TSymbol c;
-			tie(qs, c, qt) = edge;
-			dfa.SetTransition(qs, c, qt);
-		}
-		return dfa;
+		dfa.AddEdges(new_edges);
+		return dfa.Build();
 	}
 
 	TDfa Determinize(TNfa nfa)
@@ -2,7 +2,10 @@
 #pragma once
 
 #include "Set.h"
+#include "InverseIndex.h"
+#include "AlignedAllocator.h"
 #include <vector>
+#include <tuple>
 #include <limits>
 #include <cassert>
 #include <functional>
@@ -14,6 +17,7 @@
 /// Represenation:
 /// Each state is a zero-based integer index.
 /// Each symbol is a zero-based integer index.
+/// The DFA may be partial, an undefined transition targets <see cref="None" />.
 template<typename _TState, typename _TSymbol, typename _TToken = uint64_t>
 class Dfa
 {
@@ -22,6 +26,13 @@ public:
 	typedef _TSymbol TSymbol;
 	typedef _TToken TToken;
 	typedef BitSet<TState, TToken> TSet;
+	typedef std::vector<TState, AlignedAllocator<TState>> TTable;
+	typedef InverseIndex<TState, TSymbol, AlignedAllocator<TState>> TInverseIndex;
+	typedef typename TInverseIndex::TSpan TStateSpan;
+	typedef std::tuple<TState,TSymbol,TState> TEdge;
+
+	/// Target of an undefined transition
+	static const TState None = std::numeric_limits<TState>::max();
 
 private:
 	/// number of symbols in alphabet
@@ -36,12 +47,18 @@ private:
 	/// Final states set
 	TSet Final;	
 
-public:
-	/// Function to calculate next state
-	std::vector<TState> Succesors;
+	/// Inverse function, built on demand from Succesors
+	mutable TInverseIndex Predecessors;
+
+	/// Indicates if Predecessors reflects the current Succesors
+	mutable bool PredecessorsReady;
 
-	/// Inverse function
-	std::vector<TSet> Predecessors;
+	/// Number of transitions going to None
+	size_t Undefined;
+
+public:
+	/// Function to calculate next state, state-major and cache line aligned
+	TTable Succesors;
 
 	const TSet& GetInitials() const 
 	{
@@ -54,20 +71,38 @@ public:
 	}
 
 	/// <param ref="alpha" /> is the number of symbols in alphabet.	
-	Dfa(TSymbol alpha, TState states)
-		: States(states), Alphabet(alpha), Succesors(alpha*states), Predecessors(alpha * states, TSet(states)), Initial(states), Final(states)
+	/// <param ref="partial" /> leaves every transition undefined instead of going to state zero.
+	Dfa(TSymbol alpha, TState states, bool partial = false)
+		: States(states), Alphabet(alpha), Succesors(static_cast<size_t>(alpha)*states, partial ? None : 0), PredecessorsReady(false), Initial(states), Final(states),
+		Undefined(partial ? static_cast<size_t>(alpha)*states : 0)
 	{
 		assert(states < std::numeric_limits<TState>::max());
 		assert(alpha < std::numeric_limits<TSymbol>::max());
 
-		// At boot, each state go to state zero with every symbol
-		for(TSymbol sym=0; sym<alpha; sym++)
+		// At boot, each state go to state zero (or None) with every symbol,
+		// the inverse function is built on demand
+	}
+
+	/// Creates the DFA with every transition in <param ref="edges" />, in any order.
+	/// Missing transitions are left undefined, so a partial DFA stays partial. The inverse function is built at once.
+	/// O(edges + states * alphabet)
+	Dfa(TSymbol alpha, TState states, const TSet& initials, const TSet& finals, std::vector<TEdge> edges)
+		: States(states), Alphabet(alpha), Succesors(static_cast<size_t>(alpha)*states, None), PredecessorsReady(false), Initial(initials), Final(finals),
+		Undefined(static_cast<size_t>(alpha)*states)
+	{
+		assert(states < std::numeric_limits<TState>::max());
+		assert(alpha < std::numeric_limits<TSymbol>::max());
+
+		for(const auto& e : edges)
 		{
-			for(TState qs=0; qs<states; qs++)
-			{
-				Predecessors[sym].Add(qs);
-			}
+			assert(std::get<0>(e) < States);
+			assert(std::get<1>(e) < Alphabet);
+			assert(std::get<2>(e) < States);
+			TState& target = Succesors[Alphabet * std::get<0>(e) + std::get<1>(e)];
+			if(target == None) Undefined--;
+			target = std::get<2>(e);
 		}
+		BuildPredecessors();
 	}
 		
 	/// Get the number of symbols in alphabet
@@ -78,6 +113,14 @@ public:
 	/// O(1)
 	TState GetStates() const { return States; }
 
+	/// Indicates if every transition is defined
+	/// O(1)
+	bool IsComplete() const { return Undefined == 0; }
+
+	/// Get the number of defined transitions
+	/// O(1)
+	size_t GetTransitionCount() const { return Succesors.size() - Undefined; }
+
 	/// Set or unset one state as Final
 	/// O(1)
 	void SetFinal(TState state, bool st = true)
@@ -99,25 +142,25 @@ public:
 	}
 
 	/// Adjust the transition from <param ref="source_state" /> consuming <param ref="symbol" /> to <param ref="target_state" />
+	/// None as <param ref="target_state" /> makes the transition undefined.
+	/// The inverse function is invalidated and rebuilt on next GetPredecessors call.
 	/// O(1)
 	void SetTransition(TState source_state, TSymbol symbol, TState target_state)
 	{
 		assert(source_state < States);
-		assert(target_state < States);
+		assert(target_state < States || target_state == None);
 		assert(symbol < Alphabet);
 
 		auto index1 = Alphabet * source_state + symbol;
-		auto prev_target = Succesors[index1];
-		Succesors[index1] = target_state;
-		
-		auto index2 = Alphabet * prev_target + symbol;
-		Predecessors[index2].Remove(source_state);
-
-		auto index3 = Alphabet * target_state + symbol;				
-		Predecessors[index3].Add(source_state);
+		TState& target = Succesors[index1];
+		if(target == None) Undefined--;
+		if(target_state == None) Undefined++;
+		target = target_state;
+		PredecessorsReady = false;
 	}
 	
-	/// Get the target state transitioned from <param ref="source" /> consuming <param ref="symbol" />
+	/// Get the target state transitioned from <param ref="source" /> consuming <param ref="symbol" />,
+	/// None if it is undefined
 	/// O(1)
 	const TState& GetSuccessor(TState source, TSymbol symbol) const
 	{
@@ -128,15 +171,70 @@ public:
 		return Succesors[index];
 	}
 
-	/// Get the source state transitioned to <param ref="target" /> consuming <param ref="symbol"/>
-	/// O(1)
-	const TSet& GetPredecessors(TState target, TSymbol symbol) const
+	/// Asks the cache for the transitions of <param ref="source" />, a search calls it ahead of GetSuccessor.
+	/// Only a hint, O(1)
+	void PrefetchSuccessors(TState source) const
+	{
+		assert(source < States);
+		BITSET_KERNELS_PREFETCH(Succesors.data() + static_cast<size_t>(source) * Alphabet);
+	}
+
+	/// Builds the inverse function if it is not up to date, undefined transitions are left out.
+	/// Call it before sharing this DFA between threads, GetPredecessors builds it lazily otherwise.
+	/// O(states * alphabet)
+	void BuildPredecessors() const
+	{
+		if(PredecessorsReady) return;
+		const TState* succ = Succesors.data();
+		const TSymbol alpha = Alphabet;
+		Predecessors.Build(Alphabet, States, [succ, alpha](TState qs, TSymbol a) { return succ[alpha * qs + a]; });
+		PredecessorsReady = true;
+	}
+
+	/// Moves the transition table and the inverse function out of this DFA, which is left without states.
+	/// O(1) if the inverse function is up to date, O(states * alphabet) otherwise
+	void Release(TTable& succesors, TInverseIndex& predecessors)
+	{
+		BuildPredecessors();
+		succesors.swap(Succesors);
+		predecessors = std::move(Predecessors);
+		Succesors.clear();
+		Predecessors.Clear();
+		PredecessorsReady = false;
+		States = 0;
+		Initial = TSet(0);
+		Final = TSet(0);
+		Undefined = 0;
+	}
+
+	/// Copy of this DFA where every undefined transition goes to a new non final sink state,
+	/// numbered after the others. A complete DFA is copied as it is.
+	/// O(states * alphabet)
+	Dfa Complete() const
+	{
+		if(IsComplete()) return *this;
+		const TState sink = States;
+		Dfa dfa(Alphabet, States + 1);
+		for(auto i=Initial.GetIterator(); !i.IsEnd(); i.MoveNext()) dfa.Initial.Add(i.GetCurrent());
+		for(auto i=Final.GetIterator(); !i.IsEnd(); i.MoveNext()) dfa.Final.Add(i.GetCurrent());
+		for(size_t i=0; i<Succesors.size(); i++)
+		{
+			dfa.Succesors[i] = Succesors[i] == None ? sink : Succesors[i];
+		}
+		for(TSymbol a=0; a<Alphabet; a++) dfa.Succesors[Alphabet * static_cast<size_t>(sink) + a] = sink;
+		return dfa;
+	}
+
+	/// Get the source states transitioned to <param ref="target" /> consuming <param ref="symbol"/>
+	/// The span is sorted and remains valid until next SetTransition call.
+	/// O(1) amortized, first call after a modification takes O(states * alphabet)
+	TStateSpan GetPredecessors(TState target, TSymbol symbol) const
 	{
 		assert(target < States);
 		assert(symbol < Alphabet);
 
-		auto index = target * Alphabet + symbol;
-		return Predecessors[index];
+		BuildPredecessors();
+		return Predecessors.Get(target, symbol);
 	}
 
 	/// Check if state <param ref="target" /> is reach from state <param ref="source" /> consuming symbol <param ref="symbol" />
@@ -170,3 +268,5 @@ public:
 	}
 };
 
+template<typename _TState, typename _TSymbol, typename _TToken>
+const _TState Dfa<_TState, _TSymbol, _TToken>::None;
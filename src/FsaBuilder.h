@@ -0,0 +1,147 @@
+#pragma once
+
+#include <vector>
+#include <tuple>
+#include <mutex>
+#include <limits>
+#include <algorithm>
+#include <cassert>
+
+///	Collects the states and transitions of a Finite Automata in order to create it in one pass.
+/// Edges are accepted in any order and in batches, optionally from several threads.
+/// The number of states grows in order to hold every state seen.
+/// Build hands the edges to the bulk constructor of <param ref="TFsa" />, which
+/// fills the transition table and its inverse at once instead of per edge.
+///	<param ref="TFsa" /> is Dfa, Nfa or SparseNfa.
+template<typename _TFsa>
+class FsaBuilder
+{
+public:
+	typedef _TFsa TFsa;
+	typedef typename TFsa::TState TState;
+	typedef typename TFsa::TSymbol TSymbol;
+	typedef typename TFsa::TSet TSet;
+	typedef std::tuple<TState,TSymbol,TState> TEdge;
+	typedef std::vector<TEdge> TEdgeBatch;
+
+private:
+	/// Protects every field
+	std::mutex Lock;
+
+	/// number of symbols in alphabet
+	TSymbol Alphabet;
+
+	/// number of states seen so far
+	TState States;
+
+	std::vector<TState> Initials;
+	std::vector<TState> Finals;
+	TEdgeBatch Edges;
+
+	/// Grows the number of states in order to include <param ref="state" />
+	void Include(TState state)
+	{
+		assert(state < std::numeric_limits<TState>::max() - 1);
+		if(state >= States) States = state + 1;
+	}
+
+	/// Grows the number of states and symbols in order to include <param ref="edge" />
+	void Include(const TEdge& edge)
+	{
+		Include(std::get<0>(edge));
+		Include(std::get<2>(edge));
+		if(std::get<1>(edge) >= Alphabet) Alphabet = std::get<1>(edge) + 1;
+	}
+
+public:
+
+	/// <param ref="alpha" /> and <param ref="states" /> are lower bounds, they grow with the edges added.
+	FsaBuilder(TSymbol alpha = 0, TState states = 0)
+		: Alphabet(alpha), States(states)
+	{
+	}
+
+	/// Get the number of symbols seen so far
+	TSymbol GetAlphabetLength()
+	{
+		std::lock_guard<std::mutex> guard(Lock);
+		return Alphabet;
+	}
+
+	/// Get the number of states seen so far
+	TState GetStates()
+	{
+		std::lock_guard<std::mutex> guard(Lock);
+		return States;
+	}
+
+	/// Reserve room for <param ref="edges" /> transitions
+	void Reserve(size_t edges)
+	{
+		std::lock_guard<std::mutex> guard(Lock);
+		Edges.reserve(edges);
+	}
+
+	void SetInitial(TState state)
+	{
+		std::lock_guard<std::mutex> guard(Lock);
+		Include(state);
+		Initials.push_back(state);
+	}
+
+	void SetFinal(TState state)
+	{
+		std::lock_guard<std::mutex> guard(Lock);
+		Include(state);
+		Finals.push_back(state);
+	}
+
+	/// Adds one transition, prefer AddEdges for many of them
+	/// O(1) amortized
+	void AddEdge(TState source_state, TSymbol symbol, TState target_state)
+	{
+		std::lock_guard<std::mutex> guard(Lock);
+		const TEdge edge(source_state, symbol, target_state);
+		Include(edge);
+		Edges.push_back(edge);
+	}
+
+	/// Adds a batch of transitions in any order, <param ref="TEdges" /> is a container of (source, symbol, target) tuples
+	/// O(batch)
+	template<typename TEdges>
+	void AddEdges(const TEdges& batch)
+	{
+		std::lock_guard<std::mutex> guard(Lock);
+		for(const auto& e : batch)
+		{
+			const TEdge edge(std::get<0>(e), std::get<1>(e), std::get<2>(e));
+			Include(edge);
+			Edges.push_back(edge);
+		}
+	}
+
+	/// Adds a batch of transitions, it is taken without copy when no other edges were added
+	/// O(batch)
+	void AddEdges(TEdgeBatch&& batch)
+	{
+		std::lock_guard<std::mutex> guard(Lock);
+		for(const auto& e : batch) Include(e);
+		if(Edges.empty()) Edges.swap(batch);
+		else Edges.insert(Edges.end(), batch.begin(), batch.end());
+	}
+
+	/// Creates the automata and leaves this builder empty
+	/// O(edges + states * alphabet)
+	TFsa Build()
+	{
+		std::lock_guard<std::mutex> guard(Lock);
+		TSet initials(States), finals(States);
+		for(auto q : Initials) initials.Add(q);
+		for(auto q : Finals) finals.Add(q);
+		TFsa fsa(Alphabet, States, initials, finals, std::move(Edges));
+		Initials.clear();
+		Finals.clear();
+		Edges.clear();
+		return fsa;
+	}
+};
@@ -9,6 +9,7 @@
 #include <boost/lexical_cast.hpp>
 #include <stdint.h>
 #include "IFsaReader.h"
+#include "FsaBuilder.h"
 
 template<typename TFsa>
 class FsaFormatReader : public IFsaReader<TFsa>
@@ -203,7 +204,7 @@ public:
 		}
 
 		unsigned alpha_size = (unsigned)alphabet.size();
-		TFsa fsm(alpha_size, number_states);
+		FsaBuilder<TFsa> fsm(alpha_size, number_states);
 		for(auto i : initial_states) fsm.SetInitial(i);
 		for(auto j : final_states) fsm.SetFinal(j);
 		int l = 0;
@@ -211,11 +212,14 @@ public:
 		{
 			alphabet[k.first] = l++;
 		}
+		typename FsaBuilder<TFsa>::TEdgeBatch edges;
+		edges.reserve(transitions.size());
 		for(auto m : transitions)
 		{
-			fsm.SetTransition(get<0>(m), alphabet[get<1>(m)], get<2>(m));
+			edges.emplace_back(get<0>(m), alphabet[get<1>(m)], get<2>(m));
 		}
+		fsm.AddEdges(move(edges));
 
-		return fsm;
+		return fsm.Build();
 	}
 };
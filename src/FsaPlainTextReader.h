@@ -8,6 +8,7 @@
 #include <boost/algorithm/string/trim.hpp>
 #include <boost/algorithm/string/classification.hpp>
 #include "IFsaReader.h"
+#include "FsaBuilder.h"
 
 template<typename TFsa>
 class FsaPlainTextReader : IFsaReader<TFsa>
@@ -52,7 +53,8 @@ public:
 		}
 
 		// initialization
-		TFsa dfa(static_cast<TSymbol>(alpha), static_cast<TState>(states));
+		FsaBuilder<TFsa> dfa(static_cast<TSymbol>(alpha), static_cast<TState>(states));
+		typename FsaBuilder<TFsa>::TEdgeBatch edges;
 
 		// initial
 		getline(str, line);
@@ -102,11 +104,12 @@ public:
 			TSymbol c = (TSymbol)stol(col[1]);
 			TState qt = (TState)stol(col[2]);
 			
-			dfa.SetTransition(qs, c, qt);
+			edges.emplace_back(qs, c, qt);
 			transitionsRead++;
 		}
 
-		return dfa;
+		dfa.AddEdges(move(edges));
+		return dfa.Build();
 	}
 };
 
@@ -158,7 +161,8 @@ public:
 		}
 
 		// initialization
-		TFsa dfa(static_cast<TSymbol>(alpha), static_cast<TState>(states));
+		FsaBuilder<TFsa> dfa(static_cast<TSymbol>(alpha), static_cast<TState>(states));
+		typename FsaBuilder<TFsa>::TEdgeBatch edges;
 				
 		dfa.SetInitial(0);
 
@@ -197,10 +201,11 @@ public:
 			TSymbol c = (TSymbol)stol(col[1]);
 			TState qt = (TState)stol(col[2]);
 			
-			dfa.SetTransition(qs-1, c-1, qt-1);
+			edges.emplace_back(qs-1, c-1, qt-1);
 			transitionsRead++;
 		}
 
-		return dfa;
+		dfa.AddEdges(move(edges));
+		return dfa.Build();
 	}
 };
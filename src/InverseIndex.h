@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Span.h"
+#include <vector>
+#include <memory>
+#include <assert.h>
+
+///	Compact inverse of a deterministic transition function.
+/// Sources entering each (target, symbol) pair are stored in one flat array, grouped by symbol
+/// and then by target (CSR layout). Every symbol owns at most <param ref="states" /> sources,
+/// so offsets are stored relative to the symbol block using the state type itself.
+/// Memory: O(states * alphabet) instead of O(states^2 * alphabet) bits.
+///	<param ref="TAllocator" /> is the allocator of both arrays.
+template<typename _TState, typename _TSymbol, typename _TAllocator = std::allocator<_TState>>
+class InverseIndex
+{
+public:
+	typedef _TState TState;
+	typedef _TSymbol TSymbol;
+	typedef _TAllocator TAllocator;
+	typedef Span<TState> TSpan;
+
+private:
+	TSymbol Alphabet;
+	TState States;
+
+	/// Alphabet blocks of (States + 1) offsets
+	std::vector<TState, TAllocator> Offsets;
+
+	/// Alphabet blocks of States sources
+	std::vector<TState, TAllocator> Sources;
+
+public:
+
+	InverseIndex()
+		: Alphabet(0), States(0)
+	{
+	}
+
+	/// Builds the index with one counting sort pass over the transitions.
+	/// <param ref="successor" /> is a callable (TState source, TSymbol symbol) -> TState target,
+	/// a target not below <param ref="states" /> is an undefined transition and is left out.
+	/// O(states * alphabet)
+	template<typename TSuccessor>
+	void Build(TSymbol alpha, TState states, TSuccessor successor)
+	{
+		Alphabet = alpha;
+		States = states;
+		const size_t row = static_cast<size_t>(states) + 1;
+		Offsets.assign(row * alpha, 0);
+		Sources.resize(static_cast<size_t>(states) * alpha);
+
+		// count incoming transitions per (symbol, target)
+		for(TState qs=0; qs<states; qs++)
+		{
+			for(TSymbol a=0; a<alpha; a++)
+			{
+				TState qt = successor(qs, a);
+				if(qt >= states) continue;
+				Offsets[a * row + qt + 1]++;
+			}
+		}
+
+		// prefix sums inside each symbol block
+		for(TSymbol a=0; a<alpha; a++)
+		{
+			TState* o = &Offsets[a * row];
+			for(size_t t=1; t<row; t++) o[t] += o[t-1];
+		}
+
+		// scatter, sources are visited in ascending order so each run stays sorted
+		for(TState qs=0; qs<states; qs++)
+		{
+			for(TSymbol a=0; a<alpha; a++)
+			{
+				TState qt = successor(qs, a);
+				if(qt >= states) continue;
+				TState& cursor = Offsets[a * row + qt];
+				Sources[a * static_cast<size_t>(states) + cursor] = qs;
+				cursor++;
+			}
+		}
+
+		// scatter advanced every offset to the next run, shift them back
+		for(TSymbol a=0; a<alpha; a++)
+		{
+			TState* o = &Offsets[a * row];
+			for(size_t t=row-1; t>0; t--) o[t] = o[t-1];
+			o[0] = 0;
+		}
+	}
+
+	void Clear()
+	{
+		Alphabet = 0;
+		States = 0;
+		Offsets.clear();
+		Sources.clear();
+	}
+
+	/// Sources transitioned to <param ref="target" /> consuming <param ref="symbol" />
+	/// O(1)
+	TSpan Get(TState target, TSymbol symbol) const
+	{
+		assert(target < States);
+		assert(symbol < Alphabet);
+
+		const size_t row = static_cast<size_t>(States) + 1;
+		const TState* base = Sources.data() + symbol * static_cast<size_t>(States);
+		const TState* o = &Offsets[symbol * row + target];
+		return TSpan(base + o[0], base + o[1]);
+	}
+};
@@ -11,6 +11,9 @@ enum class MinimizationAlgorithm
 	Incremental,	
 	Hybrid,
 	Atomic,
+	Valmari,
+	Moore,
+	MooreParallel,
 };
 
 std::istream& operator>>(std::istream& in, MinimizationAlgorithm& fmt)
@@ -22,6 +25,9 @@ std::istream& operator>>(std::istream& in, MinimizationAlgorithm& fmt)
 	else if (token == "incremental") fmt = MinimizationAlgorithm::Incremental;
 	else if (token == "hybrid") fmt = MinimizationAlgorithm::Hybrid;
 	else if (token == "atomic") fmt = MinimizationAlgorithm::Atomic;
+	else if (token == "valmari") fmt = MinimizationAlgorithm::Valmari;
+	else if (token == "moore") fmt = MinimizationAlgorithm::Moore;
+	else if (token == "moore-parallel") fmt = MinimizationAlgorithm::MooreParallel;
 	else throw std::invalid_argument("unknown format");
 	return in;
 }
@@ -34,6 +40,9 @@ std::ostream& operator<<(std::ostream& on, const MinimizationAlgorithm& fmt)
 	else if(fmt == MinimizationAlgorithm::Incremental) token = "incremental";
 	else if(fmt == MinimizationAlgorithm::Hybrid) token = "hybrid";
 	else if(fmt == MinimizationAlgorithm::Atomic) token = "atomic";
+	else if(fmt == MinimizationAlgorithm::Valmari) token = "valmari";
+	else if(fmt == MinimizationAlgorithm::Moore) token = "moore";
+	else if(fmt == MinimizationAlgorithm::MooreParallel) token = "moore-parallel";
 	else throw std::invalid_argument("unknown format");    
 	return on << token;
 }
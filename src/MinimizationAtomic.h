@@ -4,24 +4,30 @@
 #include "Determinization.h"
 #include "Dfa.h"
 #include "Nfa.h"
+#include "Trace.h"
 #include <unordered_set>
 #include <unordered_map>
 #include <vector>
+#include <list>
 #include <tuple>
 #include <string>
 
 /// Atomic FSA Minimization Algorithm
-template<typename _TDfa>
+/// <param ref="TSet" /> stores the sets of states of the replica and the rows of the atomic NFA,
+/// CompressedSet keeps them proportional to their size instead of to the number of states.
+/// <param ref="_TTrace" /> receives the transitions of the replica, the default one discards them at compile time.
+template<typename _TDfa, typename _TSet = typename _TDfa::TSet, typename _TTrace = TraceNone>
 class MinimizationAtomic
 {
 public:	
 	typedef _TDfa TDfa;
-	typedef typename TDfa::TSet TSet;
+	typedef _TSet TSet;
+	typedef _TTrace TTrace;
 	typedef typename TDfa::TState TState;
 	typedef typename TDfa::TSymbol TSymbol;
 	typedef typename TDfa::TState TAtomicState;
 
-	typedef Nfa<TState, TSymbol> TNfa;
+	typedef Nfa<TState, TSymbol, uint64_t, TSet> TNfa;
 
 	typedef Determinization<TDfa, TNfa> TDeterminization;
 
@@ -29,10 +35,19 @@ public:
 	typedef typename TSetOfSets::iterator TSetOfSetsIterator;
 	typedef std::tuple<TSetOfSetsIterator, TSymbol, TSetOfSetsIterator> TTransition;
 
-	bool ShowConfiguration;
+	/// Receives the debugging events
+	TTrace Trace;
 
 private:
 
+	/// Copies a set of states of the DFA into a TSet
+	static TSet ToSet(const typename TDfa::TSet& states, TState count)
+	{
+		TSet set(count);
+		for(auto i=states.GetIterator(); !i.IsEnd(); i.MoveNext()) set.Add(i.GetCurrent());
+		return set;
+	}
+
 public:
 
 	template<typename T>
@@ -87,7 +102,7 @@ public:
 
 		QQ.clear();
 		QQ.reserve(fsa.GetStates()*2);
-		QQ.insert(fsa.GetFinals());
+		QQ.insert(ToSet(fsa.GetFinals(), fsa.GetStates()));
 		LL.push_back(QQ.begin());
 
 		FF.clear();
@@ -101,6 +116,9 @@ public:
 		transitions.clear();	
 		// los estados de la delta directa
 		TSet delta(fsa.GetStates());
+		const TSet initials = ToSet(fsa.GetInitials(), fsa.GetStates());
+		// estados de P, se extraen una vez para todos los simbolos
+		vector<TState> P_states(fsa.GetStates());
 		TSetOfSets PP, PP2;
 		
 		while(!LL.empty())
@@ -108,26 +126,17 @@ public:
 			const auto Piter = LL.front();
 			const auto& P = *Piter;
 
-			if(ShowConfiguration)
-			{
-				cout << "P = " << to_string(P) << endl;
-			}
+			const auto P_count = P.ExtractTo(P_states.data());
+			const TState* const P_end = P_states.data() + P_count;
 
 			for(auto a=0; a<fsa.GetAlphabetLength(); a++)
 			{
 				// paper line: 9
 				// calcular delta(P,a)
 				delta.Clear();
-				for(auto i=P.GetIterator(); !i.IsEnd(); i.MoveNext())
+				for(auto q=P_states.data(); q!=P_end; q++)
 				{
-					const auto q = i.GetCurrent();
-					const auto& d = fsa.GetPredecessors(q, a);
-					delta.UnionWith(d);
-				}
-
-				if(ShowConfiguration)
-				{
-					cout << "delta(P, a=" << static_cast<size_t>(a) << ") = " << to_string(delta) << endl;
+					for(auto d : fsa.GetPredecessors(*q, a)) delta.Add(d);
 				}
 
 				// paper line: 10, splits	
@@ -160,34 +169,17 @@ public:
 				{
 					const auto d = QQ.insert(*i);					
 					transitions.push_back(make_tuple(Piter, a, d.first));
-					if(ShowConfiguration) 
-					{
-						cout << to_string(P) << " -> " << static_cast<size_t>(a) << " -> " << to_string(*d.first) << endl;
-					}
+					if(TTrace::Enabled) Trace(TraceEvent::Transition, P_count, a, d.first->Count());
 					if(d.second) LL.push_back(d.first);
-					if(!TSet::Intersect(fsa.GetInitials(), *i).IsEmpty())
+					if(!TSet::Intersect(initials, *i).IsEmpty())
 					{
 						FF.push_back(d.first);
-						if(ShowConfiguration)
-						{
-							cout << "Final " << to_string(*d.first) << endl;
-						}
 					}
 				}
 			}
 			LL.pop_front();
-
-			if(ShowConfiguration)
-			{
-				cout << "Q = ";
-				for(auto i=QQ.begin(); i!=QQ.end(); i++)
-				{
-					cout << to_string(*i) << " ";
-				}
-				cout << endl;
-			}
 		}
-		if(ShowConfiguration) cout << "atomic done" << endl;
+		Trace(TraceEvent::Finished, QQ.size(), fsa.GetStates());
 	}
 
 	TDfa Minimize(const TDfa& fsa)
@@ -201,10 +193,10 @@ public:
 
 		ReplicaOfInverse(fsa, QQ, transitions, II);
 
-		TNfa fsa_i(fsa.GetAlphabetLength(), static_cast<TState>(QQ.size()));
-		fsa_i.SetFinal(0);
+		FsaBuilder<TNfa> builder(fsa.GetAlphabetLength(), static_cast<TState>(QQ.size()));
+		builder.SetFinal(0);
 
-		unordered_map<TSet, TAtomicState, TSet::hash> est;
+		unordered_map<TSet, TAtomicState, typename TSet::hash> est;
 
 		for(auto i=QQ.begin(); i!=QQ.end(); i++)
 		{
@@ -214,17 +206,21 @@ public:
 
 		for(auto i=II.begin(); i!=II.end(); i++)
 		{
-			fsa_i.SetInitial(est[**i]);
+			builder.SetInitial(est[**i]);
 		}
 
+		typename FsaBuilder<TNfa>::TEdgeBatch edges;
+		edges.reserve(transitions.size());
 		for(auto i=transitions.begin(); i!=transitions.end(); i++)
 		{
-			fsa_i.SetTransition(est[*get<2>(*i)], get<1>(*i), est[*get<0>(*i)]);
+			edges.emplace_back(est[*get<2>(*i)], get<1>(*i), est[*get<0>(*i)]);
 		}
+		builder.AddEdges(move(edges));
+		TNfa fsa_i = builder.Build();
 
-		TDeterminization::TDfaState dfaNewStates;
-		TDeterminization::TVectorDfaState dfaFinalStates;
-		TDeterminization::TVectorDfaEdge dfaEdges;
+		typename TDeterminization::TDfaState dfaNewStates;
+		typename TDeterminization::TVectorDfaState dfaFinalStates;
+		typename TDeterminization::TVectorDfaEdge dfaEdges;
 		det.Determinize(fsa_i, &dfaNewStates, dfaFinalStates, dfaEdges);
 		return det.BuildDfa(fsa_i.GetAlphabetLength(), dfaNewStates, dfaFinalStates, dfaEdges);
 	}
@@ -0,0 +1,654 @@
+#pragma once
+
+#include <stdint.h>
+#include <assert.h>
+#include <vector>
+#include <tuple>
+#include <limits>
+#include <utility>
+#include <unordered_map>
+#include <algorithm>
+#include <stdexcept>
+#include <iostream>
+#include "Dfa.h"
+#include "Partition.h"
+#include "FsaBuilder.h"
+#include "MinimizationHopcroft.h"
+#include "Trace.h"
+
+///	Keeps the equivalence partition of a DFA up to date while its transitions and final states are edited.
+/// Only the states that reach an edited state, the affected region, may change their language.
+/// Blocks are split from the previous partition with Hopcroft's refinement seeded by the edited states only,
+/// then every block of the affected region is tested against the blocks with its depth-limited Moore hash,
+/// equivalent blocks are merged. Without edits the partition is the one of the Myhill-Nerode equivalence.
+/// The DFA must be complete, the states and the alphabet are fixed.
+/// <param ref="_TTrace" /> receives an event per update, the default one discards them at compile time.
+template<typename _TDfa, typename _TTrace = TraceNone>
+class MinimizationDynamic
+{
+public:
+	typedef _TDfa TDfa;
+	typedef _TTrace TTrace;
+	typedef typename TDfa::TState TState;
+	typedef typename TDfa::TSymbol TSymbol;
+	typedef RefinablePartition<TState> NumericPartition;
+	typedef std::tuple<TState, TSymbol, TState> TEdge;
+
+	/// Depth of the Moore hash used to find merge candidates, equivalent states always share it
+	static const int HashDepth = 3;
+
+private:
+	static const TState None = std::numeric_limits<TState>::max();
+
+	/// Transition entering a state, stale once the source is redirected
+	struct Incoming
+	{
+		TState Source;
+		TSymbol Symbol;
+	};
+
+	TSymbol Alphabet;
+	TState States;
+	std::vector<TState> Succesors;
+	std::vector<bool> Final;
+	std::vector<bool> Initial;
+	/// Transitions entering every state, stale ones are dropped when the list is read
+	std::vector<std::vector<Incoming>> Predecessors;
+
+	/// Block of every state and members of every block, marked members are at the end
+	std::vector<TState> block_of;
+	std::vector<TState> position;
+	std::vector<std::vector<TState>> members;
+	std::vector<TState> marked;
+	std::vector<TState> touched;
+	/// Blocks waiting as splitters
+	std::vector<bool> waiting;
+	/// Block ids released by merges
+	std::vector<TState> free_blocks;
+	TState blocks;
+
+	/// Moore hash of every state at depth 0..HashDepth
+	std::vector<uint64_t> hashes[HashDepth + 1];
+	std::vector<uint64_t> weights;
+	/// Blocks by their hash, entries are checked against block_hash when read
+	std::unordered_map<uint64_t, std::vector<TState>> registry;
+	std::vector<uint64_t> block_hash;
+
+	/// Edits since the last Update: first previous target of each transition and first previous finality
+	std::unordered_map<size_t, TState> edited_transitions;
+	std::unordered_map<TState, bool> edited_finals;
+
+	/// Visit stamps of states and blocks, avoid clearing flags
+	std::vector<size_t> stamp;
+	std::vector<size_t> block_stamp;
+	size_t epoch;
+
+	static uint64_t Finish(uint64_t h)
+	{
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ULL;
+		h ^= h >> 33;
+		return h;
+	}
+
+	TState Successor(TState s, TSymbol a) const { return Succesors[static_cast<size_t>(s) * Alphabet + a]; }
+
+	/// Calls <param ref="f" />(source, symbol) for every live transition entering <param ref="t" />, stale ones are removed
+	template<typename TFunc>
+	void ForEachPredecessor(TState t, TFunc f)
+	{
+		auto& list = Predecessors[t];
+		size_t kept = 0;
+		for(size_t i=0; i<list.size(); i++)
+		{
+			const Incoming in = list[i];
+			if(Successor(in.Source, in.Symbol) != t) continue;
+			list[kept++] = in;
+			f(in.Source, in.Symbol);
+		}
+		list.resize(kept);
+	}
+
+	void ComputeHash(int level, TState s)
+	{
+		uint64_t h = Final[s] ? 0x9e3779b97f4a7c15ULL : 0x632be59bd9b4e019ULL;
+		if(level > 0)
+		{
+			for(TSymbol a=0; a<Alphabet; a++) h += hashes[level - 1][Successor(s, a)] * weights[a];
+		}
+		hashes[level][s] = Finish(h);
+	}
+
+	uint64_t GetBlockHash(TState b) const { return hashes[HashDepth][members[b].front()]; }
+
+	void Register(TState b)
+	{
+		block_hash[b] = GetBlockHash(b);
+		registry[block_hash[b]].push_back(b);
+	}
+
+	TState NewBlock()
+	{
+		blocks++;
+		if(!free_blocks.empty())
+		{
+			const TState b = free_blocks.back();
+			free_blocks.pop_back();
+			return b;
+		}
+		const TState b = static_cast<TState>(members.size());
+		members.emplace_back();
+		marked.push_back(0);
+		block_hash.push_back(0);
+		waiting.push_back(false);
+		block_stamp.push_back(0);
+		return b;
+	}
+
+	void Mark(TState s)
+	{
+		const TState b = block_of[s];
+		auto& m = members[b];
+		const TState first_marked = static_cast<TState>(m.size()) - marked[b];
+		if(position[s] >= first_marked) return;
+		if(marked[b] == 0) touched.push_back(b);
+		// exchange with the last unmarked member
+		const TState other = m[first_marked - 1];
+		m[first_marked - 1] = s;
+		m[position[s]] = other;
+		position[other] = position[s];
+		position[s] = first_marked - 1;
+		marked[b]++;
+	}
+
+	/// Separates the marked members of every touched block, the smaller part gets a new block
+	/// and on_split(new_block) is called. O(marked)
+	template<typename TSplitHandler>
+	void Split(TSplitHandler on_split)
+	{
+		for(auto b : touched)
+		{
+			auto& m = members[b];
+			const TState size = static_cast<TState>(m.size());
+			const TState count = marked[b];
+			marked[b] = 0;
+			if(count == size) continue;
+
+			const TState nb = NewBlock();
+			auto& moved = members[nb];
+			auto& rest = members[b];
+			if(count <= size - count)
+			{
+				// the marked suffix moves
+				moved.assign(rest.end() - count, rest.end());
+				rest.resize(size - count);
+			}
+			else
+			{
+				// the unmarked prefix moves, its place is filled with the last marked members
+				const TState unmarked = size - count;
+				moved.assign(rest.begin(), rest.begin() + unmarked);
+				for(TState i=0; i<unmarked; i++)
+				{
+					rest[i] = rest[size - 1 - i];
+					position[rest[i]] = i;
+				}
+				rest.resize(count);
+			}
+			for(TState i=0; i<static_cast<TState>(moved.size()); i++)
+			{
+				block_of[moved[i]] = nb;
+				position[moved[i]] = i;
+			}
+			on_split(b, nb);
+		}
+		touched.clear();
+	}
+
+	/// Joins two blocks, the smaller one is released. Returns the remaining block
+	TState Union(TState x, TState y)
+	{
+		if(x == y) return x;
+		if(members[x].size() < members[y].size()) std::swap(x, y);
+		for(auto s : members[y])
+		{
+			block_of[s] = x;
+			position[s] = static_cast<TState>(members[x].size());
+			members[x].push_back(s);
+		}
+		members[y].clear();
+		members[y].shrink_to_fit();
+		free_blocks.push_back(y);
+		blocks--;
+		return x;
+	}
+
+	/// Hopcroft and Karp's test on the quotient, the partition is stable so blocks have transitions.
+	/// Fills <param ref="pairs" /> with representative states of the blocks to join if they are equivalent.
+	bool Equivalent(TState x, TState y, std::vector<std::pair<TState, TState>>& pairs)
+	{
+		pairs.clear();
+		std::unordered_map<TState, TState> parent;
+		auto find = [&](TState b)
+		{
+			for(;;)
+			{
+				auto i = parent.find(b);
+				if(i == parent.end()) return b;
+				b = i->second;
+			}
+		};
+		parent[y] = x;
+		pairs.emplace_back(members[x].front(), members[y].front());
+		for(size_t i=0; i<pairs.size(); i++)
+		{
+			const TState p = pairs[i].first, q = pairs[i].second;
+			for(TSymbol a=0; a<Alphabet; a++)
+			{
+				const TState pa = Successor(p, a), qa = Successor(q, a);
+				const TState bp = find(block_of[pa]), bq = find(block_of[qa]);
+				if(bp == bq) continue;
+				if(Final[pa] != Final[qa] || block_hash[block_of[pa]] != block_hash[block_of[qa]]) return false;
+				parent[bq] = bp;
+				pairs.emplace_back(pa, qa);
+			}
+		}
+		return true;
+	}
+
+public:
+
+	/// Receives the debugging events
+	TTrace Trace;
+
+	/// Blocks split and merged by the last Update
+	size_t LastSplits, LastMerges;
+
+	/// States that reach an edited state in the last Update
+	size_t LastAffected;
+
+	/// Takes <param ref="dfa" /> and its equivalence partition <param ref="np" />, as computed by a minimization.
+	/// O(states * alphabet)
+	MinimizationDynamic(const TDfa& dfa, const NumericPartition& np)
+		: LastSplits(0), LastMerges(0), LastAffected(0)
+	{
+		Load(dfa, np);
+	}
+
+	/// Takes <param ref="dfa" /> and computes its equivalence partition with Hopcroft's algorithm
+	explicit MinimizationDynamic(const TDfa& dfa)
+		: LastSplits(0), LastMerges(0), LastAffected(0)
+	{
+		MinimizationHopcroft<TDfa> hopcroft;
+		NumericPartition np;
+		hopcroft.Minimize(dfa, np);
+		Load(dfa, np);
+	}
+
+	void Load(const TDfa& dfa, const NumericPartition& np)
+	{
+		if(!dfa.IsComplete()) throw std::invalid_argument("partial DFA, complete it or minimize it with MinimizationValmari");
+		assert(np.GetSize() <= dfa.GetStates());
+		Alphabet = dfa.GetAlphabetLength();
+		States = dfa.GetStates();
+		Succesors.resize(static_cast<size_t>(States) * Alphabet);
+		Final.assign(States, false);
+		Initial.assign(States, false);
+		Predecessors.assign(States, std::vector<Incoming>());
+		for(TState s=0; s<States; s++)
+		{
+			Final[s] = dfa.IsFinal(s);
+			Initial[s] = dfa.IsInitial(s);
+			for(TSymbol a=0; a<Alphabet; a++)
+			{
+				const TState t = dfa.GetSuccessor(s, a);
+				Succesors[static_cast<size_t>(s) * Alphabet + a] = t;
+				Predecessors[t].push_back(Incoming{ s, a });
+			}
+		}
+
+		blocks = np.GetSize();
+		block_of.resize(States);
+		position.resize(States);
+		members.assign(blocks, std::vector<TState>());
+		marked.assign(blocks, 0);
+		block_hash.assign(blocks, 0);
+		waiting.assign(blocks, false);
+		block_stamp.assign(blocks, 0);
+		touched.clear();
+		free_blocks.clear();
+		for(TState b=0; b<blocks; b++)
+		{
+			auto span = np.GetBlock(b);
+			members[b].assign(span.begin(), span.end());
+			for(TState i=0; i<static_cast<TState>(members[b].size()); i++)
+			{
+				block_of[members[b][i]] = b;
+				position[members[b][i]] = i;
+			}
+		}
+
+		weights.resize(Alphabet);
+		for(TSymbol a=0; a<Alphabet; a++) weights[a] = Finish(a + 1) | 1;
+		for(int level=0; level<=HashDepth; level++)
+		{
+			hashes[level].resize(States);
+			for(TState s=0; s<States; s++) ComputeHash(level, s);
+		}
+		registry.clear();
+		for(TState b=0; b<blocks; b++) Register(b);
+
+		stamp.assign(States, 0);
+		epoch = 0;
+		edited_transitions.clear();
+		edited_finals.clear();
+	}
+
+	TSymbol GetAlphabetLength() const { return Alphabet; }
+
+	TState GetStates() const { return States; }
+
+	/// Number of blocks, the states of the minimal DFA
+	TState GetSize() const { return blocks; }
+
+	/// Redirects a transition, the partition is updated by the next <see cref="Update" />. O(1)
+	void SetTransition(TState source, TSymbol symbol, TState target)
+	{
+		assert(source < States && symbol < Alphabet && target < States);
+		TState& current = Succesors[static_cast<size_t>(source) * Alphabet + symbol];
+		edited_transitions.insert(std::make_pair(static_cast<size_t>(source) * Alphabet + symbol, current));
+		if(current != target) Predecessors[target].push_back(Incoming{ source, symbol });
+		current = target;
+	}
+
+	/// Sets or unsets a final state, the partition is updated by the next <see cref="Update" />. O(1)
+	void SetFinal(TState state, bool final = true)
+	{
+		assert(state < States);
+		edited_finals.insert(std::make_pair(state, static_cast<bool>(Final[state])));
+		Final[state] = final;
+	}
+
+	/// Initial states do not take part in the equivalence
+	void SetInitial(TState state, bool initial = true)
+	{
+		assert(state < States);
+		Initial[state] = initial;
+	}
+
+	TState GetSuccessor(TState source, TSymbol symbol) const { return Successor(source, symbol); }
+
+	bool IsFinal(TState state) const { return Final[state]; }
+
+	/// Restores the equivalence partition after the edits.
+	/// O((affected states + their transitions) * alphabet) plus the Hopcroft refinement they trigger
+	void Update()
+	{
+		using namespace std;
+
+		// net edits, a transition or a finality set back to its value is no edit
+		vector<TState> sources, flipped;
+		vector<tuple<TState, TSymbol, TState>> moved;
+		for(const auto& e : edited_transitions)
+		{
+			const TState s = static_cast<TState>(e.first / Alphabet);
+			const TSymbol a = static_cast<TSymbol>(e.first % Alphabet);
+			if(Successor(s, a) == e.second) continue;
+			moved.emplace_back(s, a, e.second);
+			sources.push_back(s);
+		}
+		for(const auto& e : edited_finals)
+		{
+			if(Final[e.first] == e.second) continue;
+			flipped.push_back(e.first);
+			sources.push_back(e.first);
+		}
+		edited_transitions.clear();
+		edited_finals.clear();
+		LastSplits = LastMerges = LastAffected = 0;
+		if(sources.empty()) return;
+
+		// affected region: the states reaching an edited state
+		vector<TState> affected;
+		epoch++;
+		for(auto s : sources)
+		{
+			if(stamp[s] == epoch) continue;
+			stamp[s] = epoch;
+			affected.push_back(s);
+		}
+		for(size_t i=0; i<affected.size(); i++)
+		{
+			ForEachPredecessor(affected[i], [&](TState p, TSymbol)
+			{
+				if(stamp[p] == epoch) return;
+				stamp[p] = epoch;
+				affected.push_back(p);
+			});
+		}
+		LastAffected = affected.size();
+
+		// a redirected source whose new target is out of the block of the previous one leaves its block,
+		// grouped by letter, block and block of the new target, all before the first split
+		vector<tuple<TSymbol, TState, TState, TState>> redirected;
+		for(const auto& m : moved)
+		{
+			const TState s = get<0>(m);
+			const TSymbol a = get<1>(m);
+			const TState target_block = block_of[Successor(s, a)];
+			if(target_block != block_of[get<2>(m)]) redirected.emplace_back(a, block_of[s], target_block, s);
+		}
+		sort(redirected.begin(), redirected.end());
+
+		// blocks changed by the refinement, they are registered again with their new hash
+		vector<TState> changed;
+		vector<TState> wait_stack;
+		auto on_split = [&](TState b, TState nb)
+		{
+			LastSplits++;
+			changed.push_back(b);
+			changed.push_back(nb);
+			// the previous partition is stable, the smaller half is enough as for Hopcroft
+			if(!waiting[nb])
+			{
+				waiting[nb] = true;
+				wait_stack.push_back(nb);
+			}
+		};
+
+		// a flipped state leaves its block, every block had one finality
+		for(auto s : flipped) Mark(s);
+		Split(on_split);
+
+		for(size_t i=0; i<redirected.size(); )
+		{
+			size_t j = i;
+			for(; j<redirected.size() && get<0>(redirected[j]) == get<0>(redirected[i]) && get<1>(redirected[j]) == get<1>(redirected[i])
+				&& get<2>(redirected[j]) == get<2>(redirected[i]); j++) Mark(get<3>(redirected[j]));
+			Split(on_split);
+			i = j;
+		}
+
+		// Hopcroft's refinement from the seeds, every letter of a waiting block is processed at once
+		vector<vector<TState>> by_letter(Alphabet);
+		vector<TSymbol> letters;
+		while(!wait_stack.empty())
+		{
+			const TState b = wait_stack.back();
+			wait_stack.pop_back();
+			waiting[b] = false;
+			if(members[b].empty()) continue;
+
+			// the letters of the block as it is now, a union of blocks is still a valid splitter
+			letters.clear();
+			for(auto t : members[b])
+			{
+				ForEachPredecessor(t, [&](TState p, TSymbol a)
+				{
+					if(by_letter[a].empty()) letters.push_back(a);
+					by_letter[a].push_back(p);
+				});
+			}
+			for(auto a : letters)
+			{
+				for(auto p : by_letter[a]) Mark(p);
+				by_letter[a].clear();
+				Split(on_split);
+			}
+		}
+
+		// hashes may change within HashDepth transitions before an edited state
+		{
+			vector<TState> level_states;
+			vector<TState> next;
+			for(int level=0; level<=HashDepth; level++)
+			{
+				epoch++;
+				next.clear();
+				for(auto s : flipped)
+				{
+					if(stamp[s] != epoch) { stamp[s] = epoch; next.push_back(s); }
+				}
+				if(level > 0)
+				{
+					for(const auto& m : moved)
+					{
+						const TState s = get<0>(m);
+						if(stamp[s] != epoch) { stamp[s] = epoch; next.push_back(s); }
+					}
+					for(auto t : level_states)
+					{
+						ForEachPredecessor(t, [&](TState p, TSymbol)
+						{
+							if(stamp[p] != epoch) { stamp[p] = epoch; next.push_back(p); }
+						});
+					}
+				}
+				for(auto s : next) ComputeHash(level, s);
+				level_states.swap(next);
+			}
+		}
+
+		// merge candidates: the blocks of the affected region and the ones changed by the refinement
+		epoch++;
+		vector<TState> candidates;
+		auto add_candidate = [&](TState b)
+		{
+			if(members[b].empty()) return;
+			const TState s = members[b].front();
+			if(stamp[s] == epoch) return;
+			stamp[s] = epoch;
+			candidates.push_back(s);
+		};
+		for(auto s : affected) add_candidate(block_of[s]);
+		for(auto b : changed) add_candidate(b);
+		for(auto s : candidates) Register(block_of[s]);
+
+		vector<pair<TState, TState>> pairs;
+		for(auto s : candidates)
+		{
+			TState x = block_of[s];
+			const uint64_t h = block_hash[x];
+			auto& bucket = registry[h];
+			// drop the entries of merged or rehashed blocks and the repeated ones
+			epoch++;
+			size_t kept = 0;
+			for(size_t i=0; i<bucket.size(); i++)
+			{
+				const TState y = bucket[i];
+				if(members[y].empty() || block_hash[y] != h || block_stamp[y] == epoch) continue;
+				block_stamp[y] = epoch;
+				bucket[kept++] = y;
+			}
+			bucket.resize(kept);
+
+			for(size_t i=0; i<bucket.size(); i++)
+			{
+				const TState y = bucket[i];
+				x = block_of[s];
+				if(members[y].empty() || y == x || Final[members[y].front()] != Final[s]) continue;
+				if(!Equivalent(x, y, pairs)) continue;
+				for(const auto& p : pairs)
+				{
+					if(block_of[p.first] == block_of[p.second]) continue;
+					Union(block_of[p.first], block_of[p.second]);
+					LastMerges++;
+				}
+			}
+		}
+
+		Trace(TraceEvent::Update, LastAffected, LastSplits, LastMerges);
+	}
+
+	/// Applies a batch of edits, updates the partition and returns the new minimal DFA
+	TDfa Update(const std::vector<TEdge>& transitions, const std::vector<std::pair<TState, bool>>& finals)
+	{
+		for(const auto& e : transitions) SetTransition(std::get<0>(e), std::get<1>(e), std::get<2>(e));
+		for(const auto& f : finals) SetFinal(f.first, f.second);
+		Update();
+		return BuildDfa();
+	}
+
+	/// Equivalence partition of the edited DFA, blocks numbered from zero. O(states + blocks)
+	void GetPartition(NumericPartition& np) const
+	{
+		std::vector<TState> number(members.size(), None);
+		TState k = 0;
+		for(TState b=0; b<static_cast<TState>(members.size()); b++)
+		{
+			if(!members[b].empty()) number[b] = k++;
+		}
+		std::vector<TState> blocks_of(States);
+		for(TState s=0; s<States; s++) blocks_of[s] = number[block_of[s]];
+		np.Assign(blocks_of, k);
+	}
+
+	/// Minimal DFA of the edited one. O(blocks * alphabet)
+	TDfa BuildDfa() const
+	{
+		std::vector<TState> number(members.size(), None);
+		TState k = 0;
+		for(TState b=0; b<static_cast<TState>(members.size()); b++)
+		{
+			if(!members[b].empty()) number[b] = k++;
+		}
+		FsaBuilder<TDfa> ndfa(Alphabet, k);
+		typename FsaBuilder<TDfa>::TEdgeBatch edges;
+		edges.reserve(static_cast<size_t>(k) * Alphabet);
+		for(TState b=0; b<static_cast<TState>(members.size()); b++)
+		{
+			if(members[b].empty()) continue;
+			// every member of the block has the same transitions
+			const TState s = members[b].front();
+			for(TSymbol a=0; a<Alphabet; a++) edges.emplace_back(number[b], a, number[block_of[Successor(s, a)]]);
+			if(Final[s]) ndfa.SetFinal(number[b]);
+			for(auto st : members[b])
+			{
+				if(Initial[st]) ndfa.SetInitial(number[b]);
+			}
+		}
+		ndfa.AddEdges(std::move(edges));
+		return ndfa.Build();
+	}
+
+	/// The edited DFA. O(states * alphabet)
+	TDfa GetDfa() const
+	{
+		TDfa dfa(Alphabet, States);
+		for(TState s=0; s<States; s++)
+		{
+			if(Final[s]) dfa.SetFinal(s);
+			if(Initial[s]) dfa.SetInitial(s);
+			for(TSymbol a=0; a<Alphabet; a++) dfa.SetTransition(s, a, Successor(s, a));
+		}
+		return dfa;
+	}
+};
+
+template<typename _TDfa, typename _TTrace>
+const int MinimizationDynamic<_TDfa, _TTrace>::HashDepth;
+
+template<typename _TDfa, typename _TTrace>
+const typename MinimizationDynamic<_TDfa, _TTrace>::TState MinimizationDynamic<_TDfa, _TTrace>::None;
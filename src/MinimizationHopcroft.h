@@ -4,48 +4,60 @@
 #include "dynamic_bitset.h"
 #include <stdint.h>
 #include <assert.h>
-#include <list>
 #include <string>
 #include <algorithm>
+#include <stdexcept>
 #include <iostream>
 #include <unordered_set>
-#include <queue>
 #include "Dfa.h"
+#include "Partition.h"
+#include "FsaBuilder.h"
+#include "Trace.h"
 
 
 /// Hopcroft's DFA Minimization Algorithm.
-template<typename _TDfa>
+/// The waiting set holds (block, letter) splitters, giving the O(n k log n) bound.
+/// <param ref="_TTrace" /> receives the events of the refinement, the default one discards them at compile time.
+template<typename _TDfa, typename _TTrace = TraceNone>
 class MinimizationHopcroft
 {	
 public:	
 	typedef _TDfa TDfa;
+	typedef _TTrace TTrace;
 	typedef typename TDfa::TState TState;
 	typedef typename TDfa::TSymbol TSymbol;
 	typedef typename TDfa::TSet TSet;
-	typedef std::list<TState> TPartitionItem;
-	typedef std::vector<TPartitionItem> TPartition;
-	typedef std::vector<TState> TStateToPartition;
-
-private:
+	typedef RefinablePartition<TState> NumericPartition;
+	typedef typename NumericPartition::TSpan TPartitionItem;
+	/// Index of a (block, letter) splitter
+	typedef uint64_t TSplitterIndex;
 
+protected:
 
-public:
+	static TSplitterIndex GetSplitterIndex(TState block, TSymbol letter, TSymbol alpha)
+	{
+		return static_cast<TSplitterIndex>(block) * alpha + letter;
+	}
 
-	std::string to_string(const TPartition& P) const
+	/// Splits the finals from the non finals, returns the smaller block, the first splitter
+	TState InitialPartition(const TDfa& dfa, NumericPartition& np) const
 	{
-		using namespace std;
-		string str;
-		str.append("{");
-		for(TState i=0; i<P.size() && P[i].size()>0; i++)
+		// partial DFAs are minimized by MinimizationValmari or completed first
+		if(!dfa.IsComplete()) throw std::invalid_argument("partial DFA, complete it or minimize it with MinimizationValmari");
+		// Maximo puede exisitir una particion por cada estado, la particion reserva de esta forma
+		np.Clear(dfa.GetStates());
+
+		TState min_initial_partition_index = 0;
+		for(TState st=0; st<dfa.GetStates(); st++)
 		{
-			if(i > 0) str += ", ";
-			TPartitionItem pi = P[i];
-			str.append(to_string(pi));
+			if(dfa.IsFinal(st)) np.Mark(st);
 		}
-		str.append("}");
-		return str;
+		np.Split([&](TState, TState new_block) { min_initial_partition_index = new_block; });
+		return min_initial_partition_index;
 	}
 
+public:
+
 	std::string to_string(const TPartitionItem& p) const
 	{
 		using namespace std;
@@ -62,26 +74,18 @@ public:
 		return str;
 	}
 
-	class NumericPartition
+	std::string to_string(const NumericPartition& p) const
 	{
-	public:
-		std::vector<TState> state_to_partition;
-		std::vector<std::list<TState>> P;
-		TState new_index;
-
-		TState GetSize() const { return new_index; }
-		void Clear(TState ns)
+		using namespace std;
+		string str;
+		str.append("{");
+		for(TState i=0; i<p.GetSize(); i++)
 		{
-			P.resize(ns);
-			state_to_partition.resize(ns);
-			for(auto& i : P) i.clear();
-			new_index = 0;
+			if(i > 0) str += ", ";
+			str.append(to_string(p.GetBlock(i)));
 		}
-	};
-
-	std::string to_string(const NumericPartition& p) const
-	{
-		return to_string(p.P);
+		str.append("}");
+		return str;
 	}
 
 	std::string to_string(const TSet& s) const
@@ -100,188 +104,154 @@ public:
 		return str;
 	}
 
-	/// Controls the debugging info output
-	bool ShowConfiguration;
-
-	MinimizationHopcroft()
-		:ShowConfiguration(true)
+	/// Buffers of Minimize, they grow to the biggest DFA minimized with them and every run leaves them empty.
+	/// Concurrent minimizations need a workspace each.
+	class Workspace
 	{
-	}
+		friend class MinimizationHopcroft;
+
+		/// Blocks with waiting letters
+		std::vector<TState> wait_stack;
+		/// Waiting (block, letter) splitters
+		BitSet<TSplitterIndex> waiting;
+		/// Blocks in wait_stack
+		TSet stacked;
+		/// Members of the current splitter
+		std::vector<TState> splitter_states;
+		TSplitterIndex splitters;
+		TState states;
+
+		void Reserve(TState states_needed, TSymbol alpha)
+		{
+			const TSplitterIndex splitters_needed = static_cast<TSplitterIndex>(states_needed) * alpha;
+			if(splitters_needed > splitters)
+			{
+				waiting = BitSet<TSplitterIndex>(splitters_needed);
+				splitters = splitters_needed;
+			}
+			if(states_needed > states)
+			{
+				stacked = TSet(states_needed);
+				states = states_needed;
+				wait_stack.reserve(states_needed);
+				splitter_states.reserve(states_needed);
+			}
+		}
+
+	public:
+		Workspace() : waiting(0), stacked(0), splitters(0), states(0)
+		{
+		}
+	};
+
+private:
+	/// Workspace of the calls without one
+	Workspace work;
+
+public:
+	/// Receives the debugging events, a minimizer shared between threads needs a trace without state
+	mutable TTrace Trace;
 
 	TDfa BuildDfa(const TDfa& dfa, const NumericPartition& partitions)
 	{
-		TDfa ndfa(dfa.GetAlphabetLength(), partitions.GetSize());
+		FsaBuilder<TDfa> ndfa(dfa.GetAlphabetLength(), partitions.GetSize());
+		typename FsaBuilder<TDfa>::TEdgeBatch edges;
+		edges.reserve(static_cast<size_t>(partitions.GetSize()) * dfa.GetAlphabetLength());
 		for(TState i=0; i<partitions.GetSize(); i++)
 		{
-			auto& pi = partitions.P[i];
-			assert(pi.size() > 0);
-			for(auto is=pi.begin(); is!=pi.end(); is++)
+			const auto pi = partitions.GetBlock(i);
+			assert(!pi.IsEmpty());
+			// every member of the block has the same transitions
+			const auto s = *pi.begin();
+			for(TSymbol sym=0; sym<dfa.GetAlphabetLength(); sym++)
 			{
-				const auto s = *is;
-				for(TSymbol sym=0; sym<dfa.GetAlphabetLength(); sym++)
-				{
-					TState tgt = dfa.GetSuccessor(s, sym);
-					TState ptgt = partitions.state_to_partition[tgt];
-					ndfa.SetTransition(i, sym, ptgt);
-				}
-				if(dfa.IsInitial(s)) ndfa.SetInitial(i);
-				if(dfa.IsFinal(s)) ndfa.SetFinal(i);
+				TState tgt = dfa.GetSuccessor(s, sym);
+				TState ptgt = partitions.Find(tgt);
+				edges.emplace_back(i, sym, ptgt);
+			}
+			for(auto st : pi)
+			{
+				if(dfa.IsInitial(st)) ndfa.SetInitial(i);
+				if(dfa.IsFinal(st)) ndfa.SetFinal(i);
 			}
 		}
-		return ndfa;
+		ndfa.AddEdges(std::move(edges));
+		return ndfa.Build();
 	}
 
-	void Minimize(const TDfa& dfa, NumericPartition& np)
+	/// Minimizes with the buffers of <param ref="ws" />, without allocating once they are big enough.
+	/// Other threads may minimize with the same minimizer and workspaces of their own.
+	void Minimize(const TDfa& dfa, NumericPartition& np, Workspace& ws) const
 	{
 		using namespace std;
 
-		TState final_states_count = 0;
-		TState non_final_states_count = 0;
-				
-		// Maximo puede exisitir una particion por cada estado, por ello reservamos de esta forma
-		np.Clear(dfa.GetStates());
-
-		// Inicializa funcion inversa para obtener la particion a la que pertenece un estado		
-
-		auto it_f = back_inserter(np.P[0]);
-		auto it_nf = back_inserter(np.P[1]);
-		for(TState st=0; st<dfa.GetStates(); st++)
+		// finals are split from the non finals, the smaller one is the first splitter
+		const TState min_initial_partition_index = InitialPartition(dfa, np);
+		Trace(TraceEvent::Initial, np.GetSize(), dfa.GetStates());
+
+		// (block, letter) splitters waiting to be processed, one membership flag per pair.
+		// The blocks with waiting letters are kept in a stack, the letters of a block are processed together.
+		const TSymbol alpha = dfa.GetAlphabetLength();
+		ws.Reserve(dfa.GetStates(), alpha);
+		vector<TState>& wait_stack = ws.wait_stack;
+		BitSet<TSplitterIndex>& wait_set_membership = ws.waiting;
+		TSet& stacked_blocks = ws.stacked;
+		auto push = [&](TState block, TSymbol letter)
 		{
-			if(dfa.IsFinal(st)) { final_states_count++; *it_f++ = st; }
-			else { non_final_states_count++; *it_nf++ = st;  }
-			np.state_to_partition[st] = dfa.IsFinal(st) ? 0 : 1;
-		}
-
-		// partitions count
-		np.new_index = 0;
-		if(!np.P[1].empty()) np.new_index++;
-		if(!np.P[0].empty()) np.new_index++; 
-		else 
-		{ 
-			swap(np.P[0], np.P[1]);
-			replace(np.state_to_partition.begin(), np.state_to_partition.end(), 1, 0);
-		}
-		
-		if(ShowConfiguration)
+			wait_set_membership.Add(GetSplitterIndex(block, letter, alpha));
+			if(!stacked_blocks.TestAndAdd(block)) wait_stack.push_back(block);
+		};
+		// with a single block there is nothing to split
+		if(np.GetSize() > 1)
 		{
-			cout << "Initial P=" << to_string(np) << endl;
+			for(TSymbol a=0; a<alpha; a++) push(min_initial_partition_index, a);
 		}
 
-		TState min_initial_partition_index = final_states_count < non_final_states_count ? 0 : 1;
-		if(final_states_count == 0 || non_final_states_count == 0) min_initial_partition_index = 0;
+		// members of the splitter, marking reorders the blocks and the splitter may be one of them
+		vector<TState>& splitter_states = ws.splitter_states;
 
-		// set containing the next partitions to be processed
-		TSet wait_set_membership(dfa.GetStates());
-		wait_set_membership.Add(min_initial_partition_index);
-		
-		// set containing the already processed partitions
-		TSet partitions_to_split(dfa.GetStates());
-
-		// conjunto de predecesores
-		TSet predecessors(dfa.GetStates());
-
-		// worst case is when WaitSet has one entry per state
-		for(auto splitter_set=wait_set_membership.GetIterator(); !splitter_set.IsEnd(); splitter_set=wait_set_membership.GetIterator())
+		// every state enters O(log n) splitters per letter, the workspace is empty again at the end
+		while(!wait_stack.empty())
 		{
-			assert(np.new_index <= dfa.GetStates());
+			assert(np.GetSize() <= dfa.GetStates());
 
-			// current splitter partition
-			const auto& splitter_partition = np.P[splitter_set.GetCurrent()];
+			const TState splitter_partition = wait_stack.back();
+			wait_stack.pop_back();
+			stacked_blocks.Remove(splitter_partition);
 
-			if(ShowConfiguration)
+			// Per symbol loop, the splitter may shrink with a letter and keep its index for the next ones
+			for(TSymbol splitter_letter=0; splitter_letter<alpha; splitter_letter++)
 			{
-				cout << "Spliter=" << to_string(splitter_partition) << endl;
-			}
-
-			// Per symbol loop
-			for(TSymbol splitter_letter=0; splitter_letter<dfa.GetAlphabetLength(); splitter_letter++)
-			{								
-				predecessors.Clear();
-				bool was_split = false;
-
-				// recorre elementos de la particion
-				for(auto pii=splitter_partition.begin(); pii!=splitter_partition.end(); pii++)
-				{
-					const TState state = *pii;
-					predecessors.UnionWith(dfa.GetPredecessors(state, splitter_letter));
-				}
+				if(!wait_set_membership.TestAndRemove(GetSplitterIndex(splitter_partition, splitter_letter, alpha))) continue;
 
-				if(ShowConfiguration)
-				{
-					cout << "delta_inv (" << static_cast<size_t>(splitter_letter) << ") = " << to_string(predecessors) << endl;
-				}
+				auto splitter_block = np.GetBlock(splitter_partition);
+				splitter_states.assign(splitter_block.begin(), splitter_block.end());
 
-				partitions_to_split.Clear();
+				Trace(TraceEvent::Splitter, splitter_partition, splitter_letter);
 
 				// let a=splitter_letter, B belongs P
-				// O(card(a^{-1}.B))				
-				for(auto ss=predecessors.GetIterator(); !ss.IsEnd(); ss.MoveNext())
+				// marking counts the touched states of each block and lists the touched blocks,
+				// the split only moves marked states, O(card(a^{-1}.B))
+				for(auto state : splitter_states)
 				{
-					// state ss belongs to partition indicated with partition_index
-					TState partition_index = np.state_to_partition[ss.GetCurrent()];
-
-					// Is this partition already processed?
-					if(partitions_to_split.TestAndAdd(partition_index)) continue;
-
-					auto& old_part = np.P[partition_index];
-
-					// Imposible to divide a single state partition
-					if(old_part.size() == 1) continue;
-
-					auto& new_part = np.P[np.new_index];
-
-					for(auto k=old_part.begin(); k!=old_part.end();)
-					{
-						// al menos una vez estara k en predecessors
-						// al menos una vez, no se hara el interior de este if
-						auto l = k++;
-						if(!predecessors.Contains(*l))
-						{
-							np.state_to_partition[*l] = np.new_index;
-							new_part.splice(new_part.end(), old_part, l);
-						}
-					}
-
-					assert(old_part.size() > 0);
-
-					// si no hubo nada que dividir
-					if(new_part.size() == 0) continue;
-					was_split = true;
-					
-					if(ShowConfiguration)
-					{
-						cout << "pred state=" << static_cast<size_t>(ss.GetCurrent()) << " in partition " << static_cast<size_t>(partition_index) << endl;
-					}
-
-					if(wait_set_membership.Contains(partition_index)) 
-					{
-						wait_set_membership.Add(np.new_index);						
-					} 
-					else 
-					{
-						auto add_index = old_part.size() < new_part.size() ? partition_index : np.new_index;
-						wait_set_membership.Add(add_index);
-						// wait_set_letter[add_index] = 0; // is already zero
-					}
-
-					// If we are here, split was done
-					// new partition index must increment
-					np.new_index++;
+					for(auto q : dfa.GetPredecessors(state, splitter_letter)) np.Mark(q);
 				}
-				if(ShowConfiguration && was_split)
+
+				np.Split([&](TState partition_index, TState new_index)
 				{
-					cout << "P=" << to_string(np) << endl;
-					cout << "Waiting=" << to_string(wait_set_membership) << endl;
-				}
+					Trace(TraceEvent::Split, partition_index, new_index);
+					// the new block is the smaller half: if (old, a) is waiting both halves must wait
+					// and the old index already does, otherwise only the smaller half is needed
+					for(TSymbol a=0; a<alpha; a++) push(new_index, a);
+				});
 			}
-			// remove current
-			wait_set_membership.Remove(splitter_set.GetCurrent());
 		}		
-		if(ShowConfiguration)
-		{
-			cout << "Final P=" << to_string(np) << endl;
-			cout << "Finished, " << np.new_index << " states of " << dfa.GetStates() << endl;
-		}
+		Trace(TraceEvent::Finished, np.GetSize(), dfa.GetStates());
+	}
+
+	void Minimize(const TDfa& dfa, NumericPartition& np)
+	{
+		Minimize(dfa, np, work);
 	}
 
 	TDfa Minimize(const TDfa& dfa)
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "MinimizationHopcroft.h"
+#include "ThreadPool.h"
+#include <vector>
+#include <thread>
+
+///	Hopcroft's DFA Minimization Algorithm gathering inverse images on several threads.
+/// All the waiting letters of a splitter block are taken at once. The inverse images a^{-1}.B of
+/// those letters are gathered concurrently, in chunks of the block, then marked and split
+/// serially in letter order. The resulting partition, numbering included, does not depend on the thread count.
+template<typename _TDfa, typename _TTrace = TraceNone>
+class MinimizationHopcroftParallel : public MinimizationHopcroft<_TDfa, _TTrace>
+{
+public:
+	typedef MinimizationHopcroft<_TDfa, _TTrace> TBase;
+	typedef typename TBase::TDfa TDfa;
+	typedef typename TBase::TState TState;
+	typedef typename TBase::TSymbol TSymbol;
+	typedef typename TBase::TSet TSet;
+	typedef typename TBase::NumericPartition NumericPartition;
+	typedef typename TBase::TSplitterIndex TSplitterIndex;
+
+	/// Threads used, the calling one included
+	unsigned Threads;
+
+	/// Splitter states gathered by one task, smaller splitters are gathered without the pool
+	size_t Grain;
+
+	MinimizationHopcroftParallel()
+		: Threads(std::max(1u, std::thread::hardware_concurrency())), Grain(1024)
+	{
+	}
+
+	void Minimize(const TDfa& dfa, NumericPartition& np)
+	{
+		using namespace std;
+
+		const TState min_initial_partition_index = this->InitialPartition(dfa, np);
+		this->Trace(TraceEvent::Initial, np.GetSize(), dfa.GetStates());
+
+		const TSymbol alpha = dfa.GetAlphabetLength();
+		// the lazy inverse function of Dfa is built before the workers share it
+		if(dfa.GetStates() > 0 && alpha > 0) dfa.GetPredecessors(0, 0);
+
+		vector<TState> wait_stack;
+		wait_stack.reserve(dfa.GetStates());
+		BitSet<TSplitterIndex> wait_set_membership(static_cast<TSplitterIndex>(dfa.GetStates()) * alpha);
+		TSet stacked_blocks(dfa.GetStates());
+		auto push = [&](TState block, TSymbol letter)
+		{
+			wait_set_membership.Add(TBase::GetSplitterIndex(block, letter, alpha));
+			if(!stacked_blocks.TestAndAdd(block)) wait_stack.push_back(block);
+		};
+		if(np.GetSize() > 1)
+		{
+			for(TSymbol a=0; a<alpha; a++) push(min_initial_partition_index, a);
+		}
+
+		ThreadPool pool(Threads);
+		vector<TState> splitter_states;
+		splitter_states.reserve(dfa.GetStates());
+		vector<TSymbol> letters;
+		letters.reserve(alpha);
+		// one buffer per (letter, chunk) task, in commit order
+		vector<vector<TState>> images;
+
+		while(!wait_stack.empty())
+		{
+			const TState splitter_partition = wait_stack.back();
+			wait_stack.pop_back();
+			stacked_blocks.Remove(splitter_partition);
+
+			letters.clear();
+			for(TSymbol a=0; a<alpha; a++)
+			{
+				if(wait_set_membership.TestAndRemove(TBase::GetSplitterIndex(splitter_partition, a, alpha))) letters.push_back(a);
+			}
+			if(letters.empty()) continue;
+
+			// every letter uses the block as it is now, splits by the first letters only add
+			// the new halves to the waiting set, a union of blocks is still a valid splitter
+			auto splitter_block = np.GetBlock(splitter_partition);
+			splitter_states.assign(splitter_block.begin(), splitter_block.end());
+
+			const size_t chunks = (splitter_states.size() + Grain - 1) / Grain;
+			const size_t tasks = chunks * letters.size();
+			if(images.size() < tasks) images.resize(tasks);
+			auto gather = [&](size_t task)
+			{
+				const TSymbol a = letters[task / chunks];
+				const size_t first = (task % chunks) * Grain;
+				const size_t last = std::min(first + Grain, splitter_states.size());
+				auto& image = images[task];
+				image.clear();
+				for(size_t i=first; i<last; i++)
+				{
+					for(auto q : dfa.GetPredecessors(splitter_states[i], a)) image.push_back(q);
+				}
+			};
+			if(splitter_states.size() * letters.size() < Grain) for(size_t t=0; t<tasks; t++) gather(t);
+			else pool.Run(tasks, gather);
+
+			// serial commit, letter by letter
+			for(size_t l=0; l<letters.size(); l++)
+			{
+				this->Trace(TraceEvent::Splitter, splitter_partition, letters[l]);
+				for(size_t t=l*chunks; t<(l+1)*chunks; t++)
+				{
+					for(auto q : images[t]) np.Mark(q);
+				}
+				np.Split([&](TState partition_index, TState new_index)
+				{
+					this->Trace(TraceEvent::Split, partition_index, new_index);
+					for(TSymbol a=0; a<alpha; a++) push(new_index, a);
+				});
+			}
+		}
+		this->Trace(TraceEvent::Finished, np.GetSize(), dfa.GetStates());
+	}
+
+	TDfa Minimize(const TDfa& dfa)
+	{
+		NumericPartition p;
+		Minimize(dfa, p);
+		return this->BuildDfa(dfa, p);
+	}
+};
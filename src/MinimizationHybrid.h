@@ -2,71 +2,113 @@
 #pragma once
 
 #include <vector>
-#include <list>
 #include <algorithm>
+#include <stdexcept>
 #include "Set.h"
+#include "Partition.h"
+#include "PairTable.h"
+#include "FsaBuilder.h"
+#include "Trace.h"
 
 // Incremental Almeida et al. Minimization Algorithm.
-template<typename _TDfa>
+// Every test reaches each pair once, a distinguishable pair splits the blocks back along the pairs that reached it
+// and a test ending without one merges every pair it reached, they are closed under the successors.
+// <param ref="_TTrace" /> receives the events of the minimization, the default one discards them at compile time.
+template<typename _TDfa, typename _TTrace = TraceNone>
 class MinimizationHybrid
 {
 public:
 	typedef _TDfa TDfa;
+	typedef _TTrace TTrace;
 	typedef typename TDfa::TState TState;
 	typedef typename TDfa::TSymbol TSymbol;
 	typedef uint64_t TPairIndex;
 	typedef std::tuple<TState, TState> TStatePair;
 	typedef std::tuple<TState, TState, TSymbol> TSplitter;
-	typedef std::vector<TState> TStateToPartition;
-	typedef std::vector<std::list<TState>> TPartitionSet;
 	typedef std::vector<std::vector<TSplitter>> TDelta;
+	typedef RefinablePartition<TState> NumericPartition;
+	typedef MergeablePartition<TState> TEquivalencePartition;
 
-	// TODO: More partition details isolated from algoritmhs
-	// in order to not expose internal members
-	class NumericPartition
+	/// Buffers of Minimize, they grow to the biggest DFA minimized with them and every run leaves them empty.
+	/// Only the pairs reached by the current test are stored, the memory follows the test instead of the (n*n-n)/2 pairs.
+	/// Concurrent minimizations need a workspace each.
+	class Workspace
 	{
-	public:
-		TStateToPartition state_to_partition;
-		TState new_index;
-		TPartitionSet P;
+		friend class MinimizationHybrid;
+
+		/// Pairs known to be equivalent
+		TEquivalencePartition ro;
+		/// Pairs reached by the current test to their column of delta, numbered in order of arrival
+		PairTable<uint32_t> tocheck;
+		std::vector<TPairIndex> touched;
+		/// Pairs reaching each pair of the current test, the columns are kept for the next tests
+		TDelta delta;
+		std::vector<TStatePair> expl;
+		std::vector<TStatePair> todolist;
+		/// Buffers of Split
+		BitSet<TState> pred_states;
+		std::vector<TState> pred_list;
+		/// Members of the current block before it is split
+		std::vector<TState> members;
+		TState states;
+
+		void Reserve(TState states_needed)
+		{
+			if(states_needed > states)
+			{
+				pred_states = BitSet<TState>(states_needed);
+				pred_list.resize(states_needed);
+				members.reserve(states_needed);
+				states = states_needed;
+			}
+		}
 
-		TState GetSize() const { return new_index; }
+		/// Adds the pair to the current test and returns its column of delta
+		std::vector<TSplitter>& Touch(TPairIndex pair)
+		{
+			bool inserted;
+			return Touch(pair, inserted);
+		}
 
-		void Clear(TState states)
+		std::vector<TSplitter>& Touch(TPairIndex pair, bool& inserted)
 		{
-			state_to_partition.resize(states);
-			P.resize(states);
-			for (auto i = P.begin(); i != P.end(); i++) i->clear();
-			new_index = 0;
+			uint32_t& column = tocheck.Insert(pair, inserted);
+			if(inserted)
+			{
+				column = static_cast<uint32_t>(touched.size());
+				touched.push_back(pair);
+				if(delta.size() < touched.size()) delta.resize(touched.size());
+			}
+			return delta[column];
 		}
 
-		TState Find(TState st) const
+		/// Empties the pairs of the current test
+		void ClearTest()
 		{
-			return state_to_partition[st];
+			for(size_t i=0; i<touched.size(); i++) delta[i].clear();
+			tocheck.Clear();
+			touched.clear();
 		}
 
-		std::list<TState>& GetPartition(TState st)
+	public:
+		Workspace() : pred_states(0), states(0)
 		{
-			return P[st];
 		}
 	};
 
 private:
 
+	/// Workspace of the calls without one
+	Workspace work;
+
 	TPairIndex GetPairIndex(TState p, TState q) const
 	{
-		assert(p < q);
-		return (q*q - q) / 2 + p;
+		return PairIndexing::GetIndex(p, q);
 	}
 
 	std::tuple<TState, TState> GetPairFromIndex(TPairIndex index) const
 	{
-		TState q = static_cast<TState>(sqrt((1 + 8 * index) / 4.0f) + 0.5f);
-		TState p = static_cast<TState>(index - (q*q - q) / 2);
-		assert(p < q);
-		assert(index == GetPairIndex(p, q));
-
-		return make_tuple(p, q);
+		return PairIndexing::GetPair<TState>(index);
 	}
 
 	std::tuple<TState, TState> NormalizedPair(TState p, TState q) const
@@ -75,117 +117,49 @@ private:
 		return make_pair(min(p, q), max(p, q));
 	}
 
-	TState Merge(NumericPartition& part, TState p, TState q) const
+	TState Merge(TEquivalencePartition& part, TState p, TState q) const
 	{
-		using namespace std;
-		TState cp = part.Find(p);
-		TState cq = part.Find(q);
-		TState t = cp < cq ? cp : cq;
-		TState s = cp < cq ? cq : cp;
-		auto& pt = part.GetPartition(t);
-		auto& ps = part.GetPartition(s);
-		for (auto i = ps.begin(); i != ps.end(); i++)
-		{
-			part.state_to_partition[*i] = t;
-		}
-		pt.splice(pt.begin(), ps);
-		if (ShowConfiguration) cout << "merged blocks for states " << p << " & " << q << endl;
+		TState t = part.Union(p, q);
+		Trace(TraceEvent::Merge, p, q);
 		return t;
 	}
 
 	// Try splits all block partition using the splitter indicated by partition index and letter.
-	// If split is performed on specific block, it modifies two iterators in order to be able to continue
-	// iteration on next item inside original partition
-	void Split(const TDfa& dfa, NumericPartition& part, TState splitter_partition_idx, TSymbol splitter_letter, typename std::vector<std::list<TState>>::iterator cur_part, typename std::list<TState>::iterator& i_p, typename std::list<TState>::iterator& i_q, bool* advanced) const
+	// Split blocks keep their index for one of the halves, the other one gets a new index.
+	void Split(const TDfa& dfa, NumericPartition& part, TState splitter_partition_idx, TSymbol splitter_letter, Workspace& ws) const
 	{
 		using namespace std;
+		BitSet<TState>& pred_states = ws.pred_states;
+		std::vector<TState>& pred_list = ws.pred_list;
 
 		// calcula d_inverse para el conjunto de estados y letra indicado
-		BitSet<TState> pred_states(dfa.GetStates());
-		BitSet<TState> block_split(dfa.GetStates());
-		auto& splitter_part = part.GetPartition(splitter_partition_idx);
-		for (auto i = splitter_part.begin(); i != splitter_part.end(); i++)
+		pred_states.Clear();
+		for (auto st : part.GetBlock(splitter_partition_idx))
 		{
-			TState st = *i;
-			const auto& pred_local = dfa.GetPredecessors(st, splitter_letter);
-			pred_states.UnionWith(pred_local);
+			for (auto q : dfa.GetPredecessors(st, splitter_letter)) pred_states.Add(q);
 		}
-		if (ShowConfiguration)
-		{
-			cout << "split " << to_string(splitter_part) << "|" << static_cast<size_t>(splitter_letter);
-			cout << " <- " << to_string(pred_states) << endl;
-		}
-
-		auto old_part_begin = part.P.begin();
-		auto old_part_end = next(old_part_begin, part.new_index);
-		// we ignore new partitions (new ones created inside this loop)
-		for (auto j = pred_states.GetIterator(); !j.IsEnd(); j.MoveNext())
-		{
-			TState st = j.GetCurrent();
-			TState block = part.Find(st);
-			if (block_split.TestAndAdd(block)) continue;
-
-			auto& old_part = part.P[block];
+		Trace(TraceEvent::Splitter, splitter_partition_idx, splitter_letter);
 
-			assert(old_part.size() > 0);
-			if (old_part.size() < 2) continue;
-
-			auto& new_part = part.P[part.new_index];
-
-			for (auto j = old_part.begin(); j != old_part.end();)
-			{
-				auto k = j++;
-				// el bloque al menos contiene una vez un miembro de pred_states
-				if (!pred_states.Contains(*k))
-				{
-					// Q necesita estar por delante de P					
-					if (part.P.begin() + block == cur_part)
-					{
-						if (k == i_p)
-						{
-							i_p = j;
-							if (i_p != cur_part->end()) i_q = next(i_p, 1);
-							*advanced = true;
-						}
-						else if (k == i_q)
-						{
-							i_q = j;
-							*advanced = true;
-						}
-						assert(i_p != k);
-						assert(i_q != k);
-					}
-					part.state_to_partition[*k] = part.new_index;
-					new_part.splice(new_part.end(), old_part, k);
-
-					// p -> q  === !p || q
-					assert(!(i_p == i_q) || (i_p == cur_part->end() && i_q == cur_part->end()));
-					assert(!(i_p != i_q) || (distance(i_p, i_q) > 0));
-				}
-			}
-
-			assert(old_part.size() > 0);
-
-			// If we are here, split was done
-			// new partition index must increment
-			if (new_part.size() > 0)	part.new_index++;
-		}
+		// marking reorders the blocks, the splitter included, so predecessors are extracted first
+		const auto count = pred_states.ExtractTo(pred_list.data());
+		for (size_t i = 0; i < count; i++) part.Mark(pred_list[i]);
+		part.Split([&](TState b, TState new_block) { Trace(TraceEvent::Split, b, new_block); });
 	}
 
 	// False
 	// True, return eq
 	bool AreEquivalent(TState p, TState q,
 		const TDfa& dfa,
-		const NumericPartition& pi, const NumericPartition& ro,
-		std::vector<TStatePair>& expl,
-		BitSet<TPairIndex>& states,
-		TDelta& delta,
-		TStatePair* out_pair)
+		const NumericPartition& pi,
+		Workspace& ws,
+		TStatePair* out_pair) const
 	{
 		assert(p < q);
 		using namespace std;
+		const TEquivalencePartition& ro = ws.ro;
+		std::vector<TStatePair>& expl = ws.expl;
 
-		states.Add(GetPairIndex(p, q));
+		ws.Touch(GetPairIndex(p, q));
 				
 		expl.clear();
 		expl.push_back(make_tuple(p, q));
@@ -198,24 +172,15 @@ private:
 			
 			for (TSymbol a = 0; a < dfa.GetAlphabetLength(); a++)
 			{
-				if (ShowConfiguration) cout << "Test equiv ((" << p << ", " << q << "), " << a << ")";
-
 				TState p2 = dfa.GetSuccessor(p1, a); TState q2 = dfa.GetSuccessor(q1, a);
-
-				if (ShowConfiguration) cout << " => (" << p2 << ", " << q2 << ")";
+				Trace(TraceEvent::Step, p2, q2, a);
 
 				tie(p2, q2) = NormalizedPair(p2, q2);
 
-				TState ro_p = ro.Find(p2); TState ro_q = ro.Find(q2);
-
-				if (ShowConfiguration) cout << " rho blks: " << ro_p << ", " << ro_q << endl;
-
-				if (ro_p == ro_q) continue;
+				if (ro.SameBlock(p2, q2)) continue;
 
-				auto p2_q2 = GetPairIndex(p2, q2);
-				states.Add(p2_q2);
-
-				auto& col = delta[p2_q2];
+				bool inserted;
+				auto& col = ws.Touch(GetPairIndex(p2, q2), inserted);
 				bool found = false;
 				for (auto r : col)
 				{
@@ -226,13 +191,12 @@ private:
 
 				if (pi.Find(p2) != pi.Find(q2)) 
 				{
+					Trace(TraceEvent::Distinct, p2, q2);
 					*out_pair = make_tuple(p2, q2);
 					return false;
 				}
-				if (ro.Find(p2) != ro.Find(q2))
-				{
-					expl.push_back(make_tuple(p2, q2)); // ojo, muchas veces?
-				}
+				// every pair is expanded once, cycles end on the pairs already reached
+				if (inserted) expl.push_back(make_tuple(p2, q2));
 			}
 		}
 		return true;
@@ -240,7 +204,7 @@ private:
 
 public:
 
-	std::string to_string(const std::list<TState>& part) const
+	std::string to_string(const typename NumericPartition::TSpan& part) const
 	{
 		using namespace std;
 		string str;
@@ -277,170 +241,176 @@ public:
 	{
 		using namespace std;
 		string str;
-		TState cnt = 0;
 		str.append("{");
 		for (TState cnt = 0; cnt<P.GetSize(); cnt++)
 		{
 			if (cnt > 0) str.append(", ");
-			str.append(to_string(P.P[cnt]));
+			str.append(to_string(P.GetBlock(cnt)));
 		}
 		str.append("}");
 		return str;
 	}
 
-	bool ShowConfiguration;
-
-	MinimizationHybrid() : ShowConfiguration(false)
+	std::string to_string(const TEquivalencePartition& P) const
 	{
+		using namespace std;
+		string str;
+		str.append("{");
+		TState cnt = 0;
+		for (TState b = 0; b<P.GetCapacity(); b++)
+		{
+			if (P.IsEmpty(b)) continue;
+			if (cnt++ > 0) str.append(", ");
+			str.append("{");
+			TState k = 0;
+			P.ForEach(b, [&](TState i)
+			{
+				if (k++ > 0) str += ", ";
+				str.append(std::to_string(static_cast<size_t>(i)));
+			});
+			str.append("}");
+		}
+		str.append("}");
+		return str;
 	}
 
-	void Minimize(const TDfa& dfa, NumericPartition& part)
+	/// Receives the debugging events, a minimizer shared between threads needs a trace without state
+	mutable TTrace Trace;
+
+	/// Minimizes with the buffers of <param ref="ws" />, without allocating once they are big enough.
+	/// Other threads may minimize with the same minimizer and workspaces of their own.
+	void Minimize(const TDfa& dfa, NumericPartition& part, Workspace& ws) const
 	{
 		using namespace std;
 
+		// partial DFAs are minimized by MinimizationValmari or completed first
+		if(!dfa.IsComplete()) throw std::invalid_argument("partial DFA, complete it or minimize it with MinimizationValmari");
 		TState states = dfa.GetStates();
 		part.Clear(states);
-		NumericPartition ro;
+		ws.Reserve(states);
+		TEquivalencePartition& ro = ws.ro;
 		ro.Clear(states);
 
-		// Inicializa funcion inversa para obtener la particion a la que pertenece un estado
-		const int finalsBlock = 1;
-		const int nonFinalsBlock = 0;
-		assert(finalsBlock != nonFinalsBlock);
-		auto it_f = back_inserter(part.P[finalsBlock]), it_nf = back_inserter(part.P[nonFinalsBlock]);
+		// finals are split from the non finals
 		for (TState st = 0; st < states; st++)
 		{
-			auto f = dfa.IsFinal(st);
-			if (f) *it_f++ = st;	else *it_nf++ = st;
-			part.state_to_partition[st] = f ? finalsBlock : nonFinalsBlock;
-
-			ro.state_to_partition[st] = st;
-			ro.P[st].push_back(st);
-		}
-		// partitions count, are all finals?
-		part.new_index = 0;
-		ro.new_index = states;
-		if (!part.P[1].empty()) part.new_index++;
-		if (!part.P[0].empty()) part.new_index++;
-		else {
-			swap(part.P[0], part.P[1]);
-			replace(part.state_to_partition.begin(), part.state_to_partition.end(), 1, 0);
+			if (dfa.IsFinal(st)) part.Mark(st);
 		}
+		part.Split();
+		Trace(TraceEvent::Initial, part.GetSize(), states);
 
 		// El numero de pares de estados sin repetir es el
 		// numero de componentes en una matriz triangular
 		// El area de un triangulo
-		BitSet<TPairIndex> tocheck((states*states - states) / 2);
-		vector<TStatePair> expl;
-		vector<TStatePair> todolist;
-		expl.reserve((states*states - states) / 2);		
-		todolist.reserve((states*states - states) / 2);
-		TDelta delta((states*states - states) / 2, vector<TSplitter>());
-
-		for (auto cur_part = part.P.begin(); cur_part != next(part.P.begin(), part.new_index); cur_part++)
-		{
-			assert(cur_part->size() > 0);
-			if (cur_part->size() < 2) continue;
+		vector<TStatePair>& todolist = ws.todolist;
+		vector<TState>& members = ws.members;
 
-			auto i_p = cur_part->begin();
-			auto i_q = next(i_p, 1);
-			while (i_p != cur_part->end() && i_q != cur_part->end())
+		// blocks created by the splits are appended and visited too
+		for (TState cur_part = 0; cur_part < part.GetSize(); cur_part++)
+		{
+			assert(part.GetBlockSize(cur_part) > 0);
+			if (part.GetBlockSize(cur_part) < 2) continue;
+
+			// splits reorder the block, pairs are taken from a copy and
+			// the states that left the block are skipped, they are visited with their new block
+			auto block = part.GetBlock(cur_part);
+			members.assign(block.begin(), block.end());
+			for (size_t i_p = 0; i_p < members.size(); i_p++)
 			{
-				assert(distance(i_p, i_q) > 0);
+				if (part.Find(members[i_p]) != cur_part) continue;
+				for (size_t i_q = i_p + 1; i_q < members.size(); i_q++)
+				{
+					if (part.Find(members[i_q]) != cur_part) continue;
+					if (part.Find(members[i_p]) != cur_part) break;
 
-				TState p, q;
-				tie(p, q) = NormalizedPair(*i_p, *i_q);
+					TState p, q;
+					tie(p, q) = NormalizedPair(members[i_p], members[i_q]);
 
-				assert(p < q);
-				assert(dfa.IsFinal(p) == dfa.IsFinal(q));
-				assert(part.Find(p) == part.Find(q));
-				
-				bool splitAdvancedIterators = false;
-				
-				if (ShowConfiguration)
-				{
-					cout << "pair: " << *i_p << ", " << *i_q << endl;
-					cout << "Pi=" << to_string(part) << endl;
-					cout << "Rho=" << to_string(ro) << endl;
-				}
+					assert(p < q);
+					assert(dfa.IsFinal(p) == dfa.IsFinal(q));
+					assert(part.Find(p) == part.Find(q));
+
+					if (ro.SameBlock(p, q)) continue;
+
+					Trace(TraceEvent::Test, p, q);
 								
-				todolist.clear();
-				tocheck.Clear();
-				for (auto& v : delta) v.clear();
+					todolist.clear();
 
-				TStatePair neq_pair;
-				bool isEquiv = AreEquivalent(p, q, dfa, part, ro, expl, tocheck, delta, &neq_pair);
-				if (!isEquiv)
-				{
-					todolist.push_back(neq_pair);
-					while (!todolist.empty())
+					TStatePair neq_pair;
+					bool isEquiv = AreEquivalent(p, q, dfa, part, ws, &neq_pair);
+					if (!isEquiv)
 					{
-						TState p1, q1; tie(p1, q1) = todolist.back();
-						todolist.pop_back();
-						auto p1_q1_idx = GetPairIndex(p1, q1);
-						tocheck.Add(p1_q1_idx);
-						for (TSplitter s : delta[p1_q1_idx])
+						todolist.push_back(neq_pair);
+						while (!todolist.empty())
 						{
-							TState p2, q2; TSymbol a;
-							tie(p2, q2, a) = s;
-							TPairIndex p2_q2_idx = GetPairIndex(p2, q2);
-							if (!tocheck.Contains(p2_q2_idx)) continue;
-							if (part.Find(p2) != part.Find(q2))
+							TState p1, q1; tie(p1, q1) = todolist.back();
+							todolist.pop_back();
+							// p1 and q1 are in different blocks, every pair reaching them is split by the smaller one.
+							// nothing is touched while the column is read, it stays in place and is emptied once read
+							auto& col = ws.Touch(GetPairIndex(p1, q1));
+							for (TSplitter s : col)
 							{
-								TState b_p2 = part.Find(p2); TState b_q2 = part.Find(q2);
-								TState min_part = part.GetPartition(b_p2).size() < part.GetPartition(b_q2).size() ? b_p2 : b_q2;
-								Split(dfa, part, min_part, a, cur_part, i_p, i_q, &splitAdvancedIterators);
+								TState p2, q2; TSymbol a;
+								tie(p2, q2, a) = s;
+								if (part.Find(p2) == part.Find(q2))
+								{
+									TState b_p1 = part.Find(p1); TState b_q1 = part.Find(q1);
+									TState min_part = part.GetBlockSize(b_p1) < part.GetBlockSize(b_q1) ? b_p1 : b_q1;
+									Split(dfa, part, min_part, a, ws);
+								}
+								todolist.push_back(make_tuple(p2, q2));
 							}
-							todolist.push_back(make_tuple(p2, q2));
+							col.clear();
 						}
 					}
-				}
-				for (auto it = tocheck.GetIterator(); !it.IsEnd(); it.MoveNext())
-				{
-					// merge equivalent states
-					TState p1, q1; tie(p1, q1) = GetPairFromIndex(it.GetCurrent());
-					TState b_p1 = ro.Find(p1); TState b_q1 = ro.Find(q1);
-					Merge(ro, b_p1, b_q1);
-					if (ShowConfiguration) cout << "Rho=" << to_string(ro) << endl;
-				}
-				// advance logic
-				if (!splitAdvancedIterators) i_q++;
-				if (i_q == cur_part->end()) // advance then is in the end?
-				{
-					i_q = ++i_p; // advance p
-					if (i_p != cur_part->end()) // p is safe?
+					else
 					{
-						i_q++; // set q to next one
+						// the pairs reached are closed under the successors and never split: they are equivalent
+						for (auto idx : ws.touched)
+						{
+							TState p1, q1; tie(p1, q1) = GetPairFromIndex(idx);
+							Merge(ro, p1, q1);
+						}
 					}
+
+					// only the pairs of this test are cleared
+					ws.ClearTest();
 				}
 			}
 		}
-		if (ShowConfiguration)
-		{
-			cout << "Finished " << part.GetSize() << " states of " << dfa.GetStates() << endl;
-		}
+		Trace(TraceEvent::Finished, part.GetSize(), dfa.GetStates());
+	}
+
+	void Minimize(const TDfa& dfa, NumericPartition& part)
+	{
+		Minimize(dfa, part, work);
 	}
 
 	TDfa BuildDfa(const TDfa& dfa, const NumericPartition& partitions)
 	{
-		TDfa ndfa(dfa.GetAlphabetLength(), partitions.GetSize());
-		int pidx = 0;
-		for (const auto& p : partitions.P)
+		FsaBuilder<TDfa> ndfa(dfa.GetAlphabetLength(), partitions.GetSize());
+		typename FsaBuilder<TDfa>::TEdgeBatch edges;
+		edges.reserve(static_cast<size_t>(partitions.GetSize()) * dfa.GetAlphabetLength());
+		for (TState pidx = 0; pidx < partitions.GetSize(); pidx++)
 		{
+			const auto p = partitions.GetBlock(pidx);
+			if (p.IsEmpty()) continue;
+			// every member of the block has the same transitions
+			const TState s = *p.begin();
+			for (TSymbol sym = 0; sym < dfa.GetAlphabetLength(); sym++)
+			{
+				TState tgt = dfa.GetSuccessor(s, sym);
+				TState ptgt = partitions.Find(tgt);
+				edges.emplace_back(pidx, sym, ptgt);
+			}
 			for (TState s : p)
 			{
-				for (TSymbol sym = 0; sym < dfa.GetAlphabetLength(); sym++)
-				{
-					TState tgt = dfa.GetSuccessor(s, sym);
-					TState ptgt = partitions.state_to_partition[tgt];
-					ndfa.SetTransition(pidx, sym, ptgt);
-				}
 				if (dfa.IsInitial(s)) ndfa.SetInitial(pidx);
 				if (dfa.IsFinal(s)) ndfa.SetFinal(pidx);
 			}
-			pidx++;
 		}
-		return ndfa;
+		ndfa.AddEdges(std::move(edges));
+		return ndfa.Build();
 	}
 
 	TDfa Minimize(const TDfa& dfa)
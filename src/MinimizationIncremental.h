@@ -3,178 +3,287 @@
 
 #include <vector>
 #include <algorithm>
+#include <stdexcept>
+#include <limits>
+#include <chrono>
+#include <atomic>
 #include "Set.h"
+#include "Partition.h"
+#include "PairTable.h"
+#include "FsaBuilder.h"
+#include "Trace.h"
 
 // Incremental Almeida et al. Minimization Algorithm.
-template<typename _TDfa>
+// <param ref="_TTrace" /> receives the events of the minimization, the default one discards them at compile time.
+template<typename _TDfa, typename _TTrace = TraceNone>
 class MinimizationIncremental
 {
 public:
 	typedef _TDfa TDfa;
+	typedef _TTrace TTrace;
 	typedef typename TDfa::TState TState;
 	typedef typename TDfa::TSymbol TSymbol;
 	typedef uint64_t TPairIndex;
 
-	class NumericPartition
-	{
-	public:
-		typedef TState TElement;
-		typedef std::vector<std::list<TElement>> TStore;
+	typedef MergeablePartition<TState> NumericPartition;
 
-	private:
-		std::vector<TElement> membership;
-		TStore storage;
-		TElement size;
+	/// Limits of an anytime minimization, the default one never stops it.
+	/// A stopped minimization leaves a partition joining only equivalent states, its quotient is a DFA
+	/// of the same language that may not be minimal.
+	struct Budget
+	{
+		/// Steps allowed, a step is a pair tested or a letter followed from a pair
+		uint64_t Steps;
+		/// Read every CheckInterval steps and once per state
+		std::chrono::steady_clock::time_point Deadline;
+		/// Set from any thread to stop, read as the deadline
+		const std::atomic<bool>* Cancel;
 
-	public:
-		NumericPartition(TElement size_)
-			: membership(size_), storage(size_)
+		Budget()
+			: Steps(std::numeric_limits<uint64_t>::max()), Deadline(std::chrono::steady_clock::time_point::max()), Cancel(nullptr)
 		{
-			Clear(size);
 		}
+	};
+
+	/// Steps between two reads of the clock and the cancellation flag
+	static const uint64_t CheckInterval = 1024;
+
+	/// Buffers of Minimize, they grow to the biggest DFA minimized with them and every run leaves them empty.
+	/// Up to DenseLimit pairs the sets are bitsets over every pair. Bigger DFAs only store the pairs reached in
+	/// hash tables, the distinguishable pairs are a cache of at most DistinctLimit pairs emptied when full,
+	/// forgetting them costs tests again but not correctness. Clearing costs the pairs added in both cases.
+	/// Concurrent minimizations need a workspace each.
+	class Workspace
+	{
+		friend class MinimizationIncremental;
 
-		NumericPartition() 
-			: size(0)
+		static const uint8_t Equiv = 1;
+		static const uint8_t Path = 2;
+
+		bool dense;
+		/// Pairs known to be distinguishable, assumed equivalent by the current test and on its current path
+		BitSet<TPairIndex> neq_bits, equiv_bits, path_bits;
+		/// Pairs known to be distinguishable and flags of the pairs of the current test, without bitsets
+		PairTable<uint8_t> neq_table, test_table;
+		std::vector<TPairIndex> neq_list, equiv_list, path_list;
+		TPairIndex pairs;
+
+		/// Limits of the running minimization, the steps done and the step of the next check
+		const Budget* budget;
+		uint64_t steps, next_check;
+		bool stopped;
+
+		/// Pair expanded by the search of EquivP and its next letter, for every ancestor of the current pair
+		struct Frame
+		{
+			TState p, q;
+			TSymbol next;
+		};
+		std::vector<Frame> stack;
+
+		void Reserve(TPairIndex pairs_needed)
 		{
+			dense = pairs_needed <= DenseLimit;
+			if(!dense || pairs_needed <= pairs) return;
+			neq_bits = BitSet<TPairIndex>(pairs_needed);
+			equiv_bits = BitSet<TPairIndex>(pairs_needed);
+			path_bits = BitSet<TPairIndex>(pairs_needed);
+			pairs = pairs_needed;
 		}
 
-		void Clear(TElement size_)
+		BitSet<TPairIndex>& GetBits(uint8_t flag) { return flag == Equiv ? equiv_bits : path_bits; }
+
+		bool IsDistinct(TPairIndex pair) const { return dense ? neq_bits.Contains(pair) : neq_table.Contains(pair); }
+
+		void AddDistinct(TPairIndex pair)
 		{
-			using namespace std;
-			size = size_;
-			membership.resize(size);
-			storage.resize(size);
-			for(TElement i=0; i<size; i++)
+			if(!dense)
 			{
-				membership[i] = i;
-				storage[i].clear();
-				storage[i].emplace_back(i);
-			}			
+				if(neq_table.GetSize() >= DistinctLimit) neq_table.Clear();
+				neq_table.TestAndAdd(pair);
+			}
+			else if(!neq_bits.TestAndAdd(pair)) neq_list.push_back(pair);
+		}
+
+		/// Sets <param ref="flag" /> on the pair and returns if it was already set
+		bool TestAndMark(TPairIndex pair, uint8_t flag)
+		{
+			if(dense) return GetBits(flag).TestAndAdd(pair);
+			bool inserted;
+			uint8_t& flags = test_table.Insert(pair, inserted);
+			const bool marked = (flags & flag) != 0;
+			flags |= flag;
+			return marked;
 		}
 
-		TElement Find(TElement e) const
+		void Unmark(TPairIndex pair, uint8_t flag)
 		{
-			return membership[e];
+			if(dense) return GetBits(flag).Remove(pair);
+			uint8_t* flags = test_table.Find(pair);
+			if(flags) *flags &= ~flag;
 		}
 
-		TElement Union(TElement i, TElement j)
+		bool IsMarked(TPairIndex pair, uint8_t flag)
 		{
-			using namespace std;
-			i = Find(i);
-			j = Find(j);
-			if(i == j) return i;
-			assert(!storage[i].empty());
-			assert(!storage[j].empty());
-			// concatenate list j into i
-			storage[i].splice(storage[i].begin(), storage[j]);
-			// replace i using j
-			replace(membership.begin(), membership.end(), j, i);			
-			size--;
-			return i;
+			if(dense) return GetBits(flag).Contains(pair);
+			const uint8_t* flags = test_table.Find(pair);
+			return flags && (*flags & flag) != 0;
 		}
 
-		void Compact()
+		/// Empties the pairs of the current test, every one of them is in equiv_list or path_list
+		void ClearTest()
 		{
-			// start scan from begin
-			auto empty_it=storage.begin();
-			while(empty_it != storage.end())
+			if(dense)
 			{
-				// find empty place
-				while(empty_it != storage.end() && !empty_it->empty()) empty_it++;
-				if(empty_it == storage.end()) break;
-				auto empty_idx = distance(storage.begin(), empty_it);
-				// find non-empty
-				auto non_empty_it = next(empty_it);
-				while(non_empty_it != storage.end() && non_empty_it->empty()) non_empty_it++;
-				if(non_empty_it == storage.end()) break;
-				auto non_empty_idx = distance(storage.begin(), non_empty_it);
-				// move non-empty to empty place
-				iter_swap(empty_it, non_empty_it);
-				replace(membership.begin(), membership.end(), non_empty_idx, empty_idx);
-				// advance search
-				empty_it++;
+				for(auto idx : equiv_list) equiv_bits.Remove(idx);
+				for(auto idx : path_list) path_bits.Remove(idx);
 			}
+			else test_table.Clear();
+			equiv_list.clear();
+			path_list.clear();
 		}
 
-		const TStore& GetStore() const
+		void ClearDistinct()
 		{
-			return storage;
+			for(auto idx : neq_list) neq_bits.Remove(idx);
+			neq_list.clear();
+			neq_table.Clear();
 		}
 
-		const TElement GetSize() const 
+	public:
+		/// Pairs of the biggest DFA minimized with bitsets, 16 MiB per set by default
+		TPairIndex DenseLimit;
+
+		/// Distinguishable pairs kept without bitsets, about 32 MiB by default
+		size_t DistinctLimit;
+
+		Workspace() : dense(true), neq_bits(0), equiv_bits(0), path_bits(0), pairs(0), budget(nullptr), steps(0), next_check(0), stopped(false), DenseLimit(TPairIndex(1) << 27), DistinctLimit(size_t(1) << 20)
 		{
-			return size;
 		}
 	};
 
-	typedef typename NumericPartition::TStore TNumericPartitionStore;
 private:
+
+	/// Workspace of the calls without one
+	Workspace work;
 	
 	TPairIndex GetPairIndex(TState p, TState q) const
 	{
-		assert(p < q);
-		return (q*q-q)/2+p;
+		return PairIndexing::GetIndex(p, q);
 	}
 
 	std::tuple<TState,TState> GetPairFromIndex(TPairIndex index) const
 	{
-		using namespace std;
-		TState q = static_cast<TState>(sqrt((1 + 8*index)/4.0f) + 0.5f);
-		TState p = static_cast<TState>(index - (q*q-q)/2);
-		assert(p < q);
-		assert(index == GetPairIndex(p,q));
+		return PairIndexing::GetPair<TState>(index);
+	}
 
-		return make_tuple(p, q);
+	static bool IsInterrupted(const Budget& budget)
+	{
+		if(budget.Cancel && budget.Cancel->load(std::memory_order_relaxed)) return true;
+		return budget.Deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= budget.Deadline;
 	}
 
-	bool EquivP(TState p, TState q, const TDfa& dfa, const NumericPartition& part, BitSet<TPairIndex>& neq, BitSet<TPairIndex>& equiv, BitSet<TPairIndex>& path)
+	/// Takes a step from the budget of <param ref="ws" />, or stops it and returns true if it ran out
+	bool Spend(Workspace& ws) const
 	{
-		using namespace std;
-		if(ShowConfiguration) {
-			cout << "Test equiv (" << static_cast<size_t>(p) << ", " << static_cast<size_t>(q) << ")" << endl;
+		if(ws.steps < ws.next_check)
+		{
+			ws.steps++;
+			return false;
 		}
-				
-		if(dfa.IsFinal(p) != dfa.IsFinal(q)) return false;
-		TPairIndex root_pair = GetPairIndex(p,q);
-		if(neq.Contains(root_pair)) return false;
-		if(path.TestAndAdd(root_pair)) return true;
-		for(TSymbol a=0; a<dfa.GetAlphabetLength(); a++)
+		const Budget& budget = *ws.budget;
+		if(ws.steps >= budget.Steps || IsInterrupted(budget))
 		{
-			TState sp = dfa.GetSuccessor(p, a);
-			TState sq = dfa.GetSuccessor(q, a);
-			if(sp == sq) continue;
-			//if(part.Find(sp) == part.Find(sq)) continue;
-			if(sp > sq) std::swap(sp, sq);
-			TPairIndex pair = GetPairIndex(sp, sq);
-			if(!equiv.TestAndAdd(pair))
+			ws.stopped = true;
+			return true;
+		}
+		ws.next_check = ws.steps + std::min(CheckInterval, budget.Steps - ws.steps);
+		ws.steps++;
+		return false;
+	}
+
+	enum class Entry { Distinct, Assumed, Opened };
+
+	/// Starts the test of the pair <param ref="p" />, <param ref="q" />, the smaller first: Distinct if it is known
+	/// to be distinguishable, Assumed if it is on the current path, otherwise Opened and it joins the path
+	Entry Enter(TState p, TState q, const TDfa& dfa, Workspace& ws) const
+	{
+		// the rows are read by the next steps, they load while the pair is looked up
+		dfa.PrefetchSuccessors(p);
+		dfa.PrefetchSuccessors(q);
+		if(dfa.IsFinal(p) != dfa.IsFinal(q)) return Entry::Distinct;
+		const TPairIndex pair = GetPairIndex(p, q);
+		if(ws.IsDistinct(pair)) return Entry::Distinct;
+		if(ws.TestAndMark(pair, Workspace::Path)) return Entry::Assumed;
+		ws.path_list.push_back(pair);
+		return Entry::Opened;
+	}
+
+	/// Depth first search of the pairs of successors of <param ref="p" /> and <param ref="q" />, the pairs on the
+	/// current path are assumed equivalent. The pair being expanded stays in locals and its ancestors are kept on
+	/// the explicit stack of <param ref="ws" />, the depth is not bounded by the call stack.
+	/// The pairs are visited in the order of the recursive formulation.
+	bool EquivP(TState p, TState q, const TDfa& dfa, Workspace& ws) const
+	{
+		const Entry root = Enter(p, q, dfa, ws);
+		if(root != Entry::Opened) return root == Entry::Assumed;
+		const TSymbol alpha = dfa.GetAlphabetLength();
+		ws.stack.clear();
+		TSymbol a = 0;
+		for(;;)
+		{
+			while(a < alpha)
 			{
-				if(ShowConfiguration) cout << "with symbol: " << static_cast<size_t>(a) << endl;
-				if(!EquivP(sp,sq, dfa, part, neq, equiv, path))
+				if(Spend(ws)) return false;
+				TState sp = dfa.GetSuccessor(p, a);
+				TState sq = dfa.GetSuccessor(q, a);
+				a++;
+				if(sp == sq) continue;
+				if(sp > sq) std::swap(sp, sq);
+				const TPairIndex pair = GetPairIndex(sp, sq);
+				if(ws.TestAndMark(pair, Workspace::Equiv)) continue;
+				ws.equiv_list.push_back(pair);
+				Trace(TraceEvent::Step, sp, sq, a - 1);
+				const Entry entry = Enter(sp, sq, dfa, ws);
+				if(entry == Entry::Distinct) return false;
+				if(entry == Entry::Assumed)
 				{
-					return false;
+					ws.Unmark(pair, Workspace::Path);
+					continue;
 				}
-				path.Remove(pair);
+				ws.stack.push_back(typename Workspace::Frame{ p, q, a });
+				p = sp;
+				q = sq;
+				a = 0;
 			}
+
+			// every pair of successors may be equivalent, so is this one
+			const TPairIndex pair = GetPairIndex(p, q);
+			if(!ws.TestAndMark(pair, Workspace::Equiv)) ws.equiv_list.push_back(pair);
+			if(ws.stack.empty()) return true;
+			ws.Unmark(pair, Workspace::Path);
+			p = ws.stack.back().p;
+			q = ws.stack.back().q;
+			a = ws.stack.back().next;
+			ws.stack.pop_back();
 		}
-		equiv.Add(root_pair);
-		return true;
 	}
 
 public:
 
 	
-	std::string to_string(const std::list<TState>& ls)
+	std::string to_string(const NumericPartition& p, TState block)
 	{
 		using namespace std;
 		string str;
 		str.append("{");
 		int cont=0;
-		for(auto i=ls.begin(); i!=ls.end(); i++)
+		p.ForEach(block, [&](TState i)
 		{
 			if(cont++ > 0) str.append(", ");
-			size_t k = static_cast<size_t>(*i);
+			size_t k = static_cast<size_t>(i);
 			str.append(std::to_string(k));
-		}
+		});
 		str.append("}");
 		return str;
 	}
@@ -185,76 +294,112 @@ public:
 		string str;
 		str.append("{");
 		TState i=0;
-		for(auto j=p.GetStore().begin(); j!=p.GetStore().end(); j++)
+		for(TState j=0; j<p.GetCapacity(); j++)
 		{
-			if(j->size() == 0) continue;
+			if(p.IsEmpty(j)) continue;
 			if(i > 0) str.append(", ");			
-			str.append(to_string(*j));
+			str.append(to_string(p, j));
 			i++;
 		}
 		str.append("}");
 		return str;
 	}
 
-	bool ShowConfiguration;
+	/// Receives the debugging events, a minimizer shared between threads needs a trace without state
+	mutable TTrace Trace;
+
+	/// Limits of the calls without a budget
+	Budget Limits;
 
-	MinimizationIncremental() : ShowConfiguration(false)
+	/// False if the last call without a budget stopped before proving its partition minimal
+	bool Minimal;
+
+	MinimizationIncremental()
+		: Minimal(true)
 	{
 	}
 
-	void Minimize(const TDfa& dfa, NumericPartition& part)
+	/// Minimizes within <param ref="budget" /> with the buffers of <param ref="ws" />, without allocating once they are big enough.
+	/// Returns false if the budget ran out, <param ref="part" /> then only joins states proven equivalent and BuildDfa
+	/// makes a valid DFA of it, maybe not minimal. Other threads may minimize with the same minimizer and workspaces of their own.
+	bool Minimize(const TDfa& dfa, NumericPartition& part, Workspace& ws, const Budget& budget) const
 	{
 		using namespace std;
+		// partial DFAs are minimized by MinimizationValmari or completed first
+		if(!dfa.IsComplete()) throw std::invalid_argument("partial DFA, complete it or minimize it with MinimizationValmari");
 		TState states = dfa.GetStates();
 		part.Clear(states);
+		ws.Reserve((static_cast<TPairIndex>(states)*states-states)/2);
+		ws.budget = &budget;
+		ws.steps = 0;
+		ws.next_check = 0;
+		ws.stopped = false;
 
-		BitSet<TPairIndex> neq((states*states-states)/2);		
-		BitSet<TPairIndex> equiv((states*states-states)/2);
-		BitSet<TPairIndex> path((states*states-states)/2);
-		for(TState p=0; p<states; p++)
+		for(TState p=0; p<states && !ws.stopped; p++)
 		{
-			for(TState q=p+1; q<states; q++)
+			// rows without tests do not spend steps
+			if(IsInterrupted(budget)) ws.stopped = true;
+			for(TState q=p+1; q<states && !ws.stopped; q++)
 			{
-				if(ShowConfiguration) 
-				{
-					cout << "test (" << static_cast<size_t>(p) << ", " << static_cast<size_t>(q) << ")" << endl;
-				}
 				if(dfa.IsFinal(p) != dfa.IsFinal(q)) continue;
-				if(neq.Contains(GetPairIndex(p,q))) continue;
-				if(part.Find(p) == part.Find(q)) continue;
-				equiv.Clear();
-				path.Clear();
+				if(part.SameBlock(p, q)) continue;
+				if(ws.IsDistinct(GetPairIndex(p,q))) continue;
+				if(Spend(ws)) break;
 
-				const bool isEquiv = EquivP(p, q, dfa, part, neq, equiv, path);
-				if(ShowConfiguration) 
+				Trace(TraceEvent::Test, p, q);
+				const bool isEquiv = EquivP(p, q, dfa, ws);
+				if(ws.stopped)
 				{
-					cout << (isEquiv ? "YES" : "NO") << endl;
+					// the interrupted test proved nothing
+					ws.ClearTest();
+					break;
 				}
-				if(isEquiv) for(auto it=equiv.GetIterator(); !it.IsEnd(); it.MoveNext())
+				if(!isEquiv) Trace(TraceEvent::Distinct, p, q);
+				// merged in pair order, the block numbering does not depend on the search order
+				if(isEquiv) std::sort(ws.equiv_list.begin(), ws.equiv_list.end());
+				if(isEquiv) for(auto idx : ws.equiv_list)
 				{
-					TPairIndex idx = it.GetCurrent();
 					TState p_prime, q_prime;
 					tie(p_prime, q_prime) = GetPairFromIndex(idx);
 					assert(p_prime < q_prime);
-					if(ShowConfiguration) {
-						cout << "union (" << static_cast<size_t>(p_prime) << ", " << static_cast<size_t>(q_prime) << ")" << endl;
-					}
+					Trace(TraceEvent::Merge, p_prime, q_prime);
 					part.Union(p_prime, q_prime);
 				}
-				else neq.UnionWith(path);
+				else for(auto idx : ws.path_list)
+				{
+					// pairs left on the path when the test failed
+					if(ws.IsMarked(idx, Workspace::Path)) ws.AddDistinct(idx);
+				}
+
+				ws.ClearTest();
 			}
 		}
-		if(ShowConfiguration)
-		{
-			cout << "Final P=" << to_string(part) << endl;
-			cout << "Finished " << part.GetSize() << " states of " << dfa.GetStates() << endl;
-		}
+		ws.ClearDistinct();
+		ws.budget = nullptr;
+		Trace(TraceEvent::Finished, part.GetSize(), dfa.GetStates());
+		return !ws.stopped;
 	}
 
+	/// Minimizes with the buffers of <param ref="ws" />, without limits
+	void Minimize(const TDfa& dfa, NumericPartition& part, Workspace& ws) const
+	{
+		Minimize(dfa, part, ws, Budget());
+	}
+
+	/// Minimizes within Limits, Minimal tells if the partition was proven minimal
+	void Minimize(const TDfa& dfa, NumericPartition& part)
+	{
+		Minimal = Minimize(dfa, part, work, Limits);
+	}
+
+	/// Quotient of <param ref="dfa" /> by <param ref="seq" />, also valid for the partition of a stopped minimization:
+	/// its blocks only join equivalent states, so any member gives the transitions of its block
 	TDfa BuildDfa(const TDfa& dfa, NumericPartition& seq)
 	{
 		seq.Compact();
-		TDfa dfa_min(dfa.GetAlphabetLength(), seq.GetSize());
+		FsaBuilder<TDfa> dfa_min(dfa.GetAlphabetLength(), seq.GetSize());
+		typename FsaBuilder<TDfa>::TEdgeBatch edges;
+		edges.reserve(static_cast<size_t>(seq.GetSize()) * dfa.GetAlphabetLength());
 		for(auto k=dfa.GetInitials().GetIterator(); !k.IsEnd(); k.MoveNext())
 		{
 			TState initial_state = k.GetCurrent();
@@ -268,19 +413,19 @@ public:
 			dfa_min.SetFinal(final_state);
 		}
 
-		for(auto i : seq.GetStore())
+		for(TState i=0; i<seq.GetSize(); i++)
 		{
-			if(i.empty()) continue;
-			TState src = *i.begin();
-			TState src_c = seq.Find(src);
+			TState src = seq.GetFirst(i);
+			TState src_c = i;
 			for(TSymbol a=0; a<dfa.GetAlphabetLength(); a++)
 			{
 				TState tgt = dfa.GetSuccessor(src, a);
 				TState tgt_c = seq.Find(tgt);
-				dfa_min.SetTransition(src_c, a, tgt_c);
+				edges.emplace_back(src_c, a, tgt_c);
 			}			
 		}
-		return dfa_min;
+		dfa_min.AddEdges(std::move(edges));
+		return dfa_min.Build();
 	}
 
 	TDfa Minimize(const TDfa& dfa)
@@ -291,3 +436,12 @@ public:
 		return dfa_min;
 	}
 };
+
+template<typename _TDfa, typename _TTrace>
+const uint8_t MinimizationIncremental<_TDfa, _TTrace>::Workspace::Equiv;
+
+template<typename _TDfa, typename _TTrace>
+const uint8_t MinimizationIncremental<_TDfa, _TTrace>::Workspace::Path;
+
+template<typename _TDfa, typename _TTrace>
+const uint64_t MinimizationIncremental<_TDfa, _TTrace>::CheckInterval;
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <stdint.h>
+#include <assert.h>
+#include <vector>
+#include <stdexcept>
+#include <iostream>
+#include "Dfa.h"
+#include "Partition.h"
+#include "FsaBuilder.h"
+#include "Trace.h"
+
+///	Moore's DFA Minimization Algorithm.
+/// Every round gives each state the signature (block, block of its successor by 0, ..., by k-1),
+/// sorts the states by signature with an LSD radix sort and numbers the blocks in that order.
+/// It stops when a round does not add blocks. O(k n) per round and at most depth + 1 rounds,
+/// shallow automata are minimized in a few flat passes over the transition table.
+/// <param ref="_TTrace" /> receives a round event per round, the default one discards them at compile time.
+template<typename _TDfa, typename _TTrace = TraceNone>
+class MinimizationMoore
+{
+public:
+	typedef _TDfa TDfa;
+	typedef _TTrace TTrace;
+	typedef typename TDfa::TState TState;
+	typedef typename TDfa::TSymbol TSymbol;
+	typedef typename TDfa::TSet TSet;
+	typedef RefinablePartition<TState> NumericPartition;
+
+private:
+
+	/// Stable counting sort of <param ref="order" /> by key[state], keys are below <param ref="keys" />.
+	/// O(states + keys)
+	static void CountingSort(std::vector<TState>& order, std::vector<TState>& sorted, const std::vector<TState>& key, std::vector<TState>& count, TState keys)
+	{
+		count.assign(static_cast<size_t>(keys) + 1, 0);
+		for(auto s : order) count[key[s] + 1]++;
+		for(TState b=0; b<keys; b++) count[b + 1] += count[b];
+		for(auto s : order) sorted[count[key[s]]++] = s;
+		order.swap(sorted);
+	}
+
+public:
+
+	/// Receives the debugging events
+	TTrace Trace;
+
+	/// Rounds done by the last Minimize, the first one included
+	size_t Rounds;
+
+	MinimizationMoore()
+		: Rounds(0)
+	{
+	}
+
+	void Minimize(const TDfa& dfa, NumericPartition& np)
+	{
+		using namespace std;
+
+		// partial DFAs are minimized by MinimizationValmari or completed first
+		if(!dfa.IsComplete()) throw std::invalid_argument("partial DFA, complete it or minimize it with MinimizationValmari");
+		const TState states = dfa.GetStates();
+		const TSymbol alpha = dfa.GetAlphabetLength();
+
+		// finals and non finals, without an empty block
+		vector<TState> block(states);
+		TState finals = 0;
+		for(TState s=0; s<states; s++)
+		{
+			if(dfa.IsFinal(s)) finals++;
+		}
+		const bool both = finals > 0 && finals < states;
+		for(TState s=0; s<states; s++) block[s] = both && dfa.IsFinal(s) ? 1 : 0;
+		TState blocks = states == 0 ? 0 : (both ? 2 : 1);
+		Rounds = 1;
+
+		vector<TState> next_block(states), order(states), sorted(states), key(states), count;
+		while(blocks > 0)
+		{
+			// LSD radix sort, the last successor first and the current block last
+			for(TState s=0; s<states; s++) order[s] = s;
+			for(TSymbol a=alpha; a-- > 0; )
+			{
+				for(TState s=0; s<states; s++) key[s] = block[dfa.GetSuccessor(s, a)];
+				CountingSort(order, sorted, key, count, blocks);
+			}
+			CountingSort(order, sorted, block, count, blocks);
+
+			// equal signatures are adjacent now, each run is a block of the next round
+			TState next_blocks = 0;
+			for(TState i=0; i<states; i++)
+			{
+				const TState s = order[i];
+				bool same = i > 0;
+				if(same)
+				{
+					const TState p = order[i - 1];
+					same = block[p] == block[s];
+					for(TSymbol a=0; same && a<alpha; a++)
+					{
+						same = block[dfa.GetSuccessor(p, a)] == block[dfa.GetSuccessor(s, a)];
+					}
+				}
+				if(!same) next_blocks++;
+				next_block[s] = next_blocks - 1;
+			}
+			block.swap(next_block);
+			Rounds++;
+			Trace(TraceEvent::Round, Rounds, next_blocks);
+
+			// every round refines the previous one, the same count means the same partition
+			if(next_blocks == blocks) break;
+			blocks = next_blocks;
+		}
+
+		np.Assign(block, blocks);
+		Trace(TraceEvent::Finished, np.GetSize(), states);
+	}
+
+	TDfa BuildDfa(const TDfa& dfa, const NumericPartition& partitions)
+	{
+		FsaBuilder<TDfa> ndfa(dfa.GetAlphabetLength(), partitions.GetSize());
+		typename FsaBuilder<TDfa>::TEdgeBatch edges;
+		edges.reserve(static_cast<size_t>(partitions.GetSize()) * dfa.GetAlphabetLength());
+		for(TState i=0; i<partitions.GetSize(); i++)
+		{
+			// every member of the block has the same transitions
+			const TState s = partitions.GetFirst(i);
+			for(TSymbol a=0; a<dfa.GetAlphabetLength(); a++)
+			{
+				edges.emplace_back(i, a, partitions.Find(dfa.GetSuccessor(s, a)));
+			}
+			for(auto st : partitions.GetBlock(i))
+			{
+				if(dfa.IsInitial(st)) ndfa.SetInitial(i);
+				if(dfa.IsFinal(st)) ndfa.SetFinal(i);
+			}
+		}
+		ndfa.AddEdges(std::move(edges));
+		return ndfa.Build();
+	}
+
+	TDfa Minimize(const TDfa& dfa)
+	{
+		NumericPartition p;
+		Minimize(dfa, p);
+		return BuildDfa(dfa, p);
+	}
+};
@@ -0,0 +1,255 @@
+#pragma once
+
+#include "MinimizationMoore.h"
+#include "ThreadPool.h"
+#include <stdint.h>
+#include <vector>
+#include <limits>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+#include <iostream>
+
+///	Moore's DFA Minimization Algorithm with every step of a round spread over several threads.
+/// Each thread owns a range of states and groups them by signature in its own open addressing table.
+/// The local groups are merged by hash shards, a shard per thread, and every block is numbered by the
+/// rank of its smallest state. The resulting partition, numbering included, does not depend on the thread count.
+template<typename _TDfa, typename _TTrace = TraceNone>
+class MinimizationMooreParallel : public MinimizationMoore<_TDfa, _TTrace>
+{
+public:
+	typedef MinimizationMoore<_TDfa, _TTrace> TBase;
+	typedef typename TBase::TDfa TDfa;
+	typedef typename TBase::TState TState;
+	typedef typename TBase::TSymbol TSymbol;
+	typedef typename TBase::NumericPartition NumericPartition;
+
+private:
+	static const TState Empty = std::numeric_limits<TState>::max();
+
+	/// Open addressing table of states, two states collide when their signatures are equal
+	struct HashTable
+	{
+		std::vector<TState> slots;
+		std::vector<uint64_t> hashes;
+		size_t mask;
+
+		/// Empties the table with room for <param ref="count" /> states at half load
+		void Reset(size_t count)
+		{
+			size_t capacity = 16;
+			while(capacity < 2 * count) capacity *= 2;
+			slots.assign(capacity, Empty);
+			hashes.resize(capacity);
+			mask = capacity - 1;
+		}
+
+		/// Returns the state already stored with the signature of <param ref="s" />, or stores <param ref="s" /> and returns it
+		template<typename TSame>
+		TState Insert(TState s, uint64_t h, TSame same)
+		{
+			for(size_t i = h & mask; ; i = (i + 1) & mask)
+			{
+				if(slots[i] == Empty)
+				{
+					slots[i] = s;
+					hashes[i] = h;
+					return s;
+				}
+				if(hashes[i] == h && same(slots[i], s)) return slots[i];
+			}
+		}
+	};
+
+	/// States owned by one thread and their local groups
+	struct Range
+	{
+		TState first, last;
+		HashTable table;
+		/// First state of each local group, in state order
+		std::vector<TState> groups;
+		std::vector<uint64_t> group_hashes;
+		/// Local groups of each shard
+		std::vector<std::vector<TState>> shards;
+		/// Smallest state with the signature of each local group
+		std::vector<TState> canonical;
+		/// Blocks starting in this range and the number of the first one
+		TState starts, first_block;
+	};
+
+	static uint64_t Finish(uint64_t h)
+	{
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ULL;
+		h ^= h >> 33;
+		return h;
+	}
+
+public:
+	/// Threads used, the calling one included
+	unsigned Threads;
+
+	/// Minimum states per thread, smaller automata use fewer threads
+	size_t Grain;
+
+	MinimizationMooreParallel()
+		: Threads(std::max(1u, std::thread::hardware_concurrency())), Grain(4096)
+	{
+	}
+
+	void Minimize(const TDfa& dfa, NumericPartition& np)
+	{
+		using namespace std;
+
+		// partial DFAs are minimized by MinimizationValmari or completed first
+		if(!dfa.IsComplete()) throw std::invalid_argument("partial DFA, complete it or minimize it with MinimizationValmari");
+		const TState states = dfa.GetStates();
+		const TSymbol alpha = dfa.GetAlphabetLength();
+
+		const size_t parts = max<size_t>(1, min<size_t>(Threads, states / max<size_t>(1, Grain)));
+		ThreadPool pool(parts);
+
+		// one odd multiplier per letter, the signature hash is a sum of products so the gathers of a row vectorize
+		vector<uint64_t> weights(static_cast<size_t>(alpha) + 1);
+		for(size_t a=0; a<weights.size(); a++) weights[a] = Finish(a + 1) | 1;
+
+		vector<TState> block(states), next_block(states), local(states);
+		auto hash = [&](TState s)
+		{
+			uint64_t h = block[s] * weights[alpha];
+			for(TSymbol a=0; a<alpha; a++) h += block[dfa.GetSuccessor(s, a)] * weights[a];
+			return Finish(h);
+		};
+		auto same = [&](TState p, TState q)
+		{
+			if(block[p] != block[q]) return false;
+			for(TSymbol a=0; a<alpha; a++)
+			{
+				if(block[dfa.GetSuccessor(p, a)] != block[dfa.GetSuccessor(q, a)]) return false;
+			}
+			return true;
+		};
+
+		vector<Range> ranges(parts);
+		for(size_t t=0; t<parts; t++)
+		{
+			ranges[t].first = static_cast<TState>(states * t / parts);
+			ranges[t].last = static_cast<TState>(states * (t + 1) / parts);
+			ranges[t].shards.resize(parts);
+		}
+		vector<HashTable> shard_tables(parts);
+
+		// finals and non finals, numbered by their smallest state as every later round
+		TState blocks = 0;
+		if(states > 0)
+		{
+			const bool first_final = dfa.IsFinal(0);
+			for(TState s=0; s<states; s++) block[s] = dfa.IsFinal(s) == first_final ? 0 : 1;
+			blocks = 1;
+			for(TState s=0; s<states && blocks == 1; s++)
+			{
+				if(block[s] != 0) blocks = 2;
+			}
+		}
+		this->Rounds = 1;
+
+		while(blocks > 0)
+		{
+			// local groups of every range
+			pool.Run(parts, [&](size_t t)
+			{
+				Range& r = ranges[t];
+				r.table.Reset(r.last - r.first);
+				r.groups.clear();
+				r.group_hashes.clear();
+				for(auto& shard : r.shards) shard.clear();
+				for(TState s=r.first; s<r.last; s++)
+				{
+					const uint64_t h = hash(s);
+					const TState p = r.table.Insert(s, h, same);
+					if(p == s)
+					{
+						local[s] = static_cast<TState>(r.groups.size());
+						r.shards[(h >> 32) % parts].push_back(local[s]);
+						r.groups.push_back(s);
+						r.group_hashes.push_back(h);
+					}
+					else local[s] = local[p];
+				}
+				r.canonical.resize(r.groups.size());
+			});
+
+			// every shard sees its groups in state order, the first one stored is the smallest state
+			pool.Run(parts, [&](size_t u)
+			{
+				size_t count = 0;
+				for(auto& r : ranges) count += r.shards[u].size();
+				HashTable& table = shard_tables[u];
+				table.Reset(count);
+				for(auto& r : ranges)
+				{
+					for(auto l : r.shards[u]) r.canonical[l] = table.Insert(r.groups[l], r.group_hashes[l], same);
+				}
+			});
+
+			// blocks are numbered by the rank of their smallest state
+			pool.Run(parts, [&](size_t t)
+			{
+				Range& r = ranges[t];
+				r.starts = 0;
+				for(TState l=0; l<r.groups.size(); l++)
+				{
+					if(r.canonical[l] == r.groups[l]) r.starts++;
+				}
+			});
+			TState next_blocks = 0;
+			for(auto& r : ranges)
+			{
+				r.first_block = next_blocks;
+				next_blocks += r.starts;
+			}
+			pool.Run(parts, [&](size_t t)
+			{
+				Range& r = ranges[t];
+				TState b = r.first_block;
+				for(TState l=0; l<r.groups.size(); l++)
+				{
+					if(r.canonical[l] == r.groups[l]) next_block[r.groups[l]] = b++;
+				}
+			});
+			pool.Run(parts, [&](size_t t)
+			{
+				Range& r = ranges[t];
+				for(TState s=r.first; s<r.last; s++)
+				{
+					// the smallest states already have their block, other threads read them
+					const TState c = r.canonical[local[s]];
+					if(c != s) next_block[s] = next_block[c];
+				}
+			});
+
+			block.swap(next_block);
+			this->Rounds++;
+			this->Trace(TraceEvent::Round, this->Rounds, next_blocks);
+
+			// every round refines the previous one, the same count means the same partition
+			if(next_blocks == blocks) break;
+			blocks = next_blocks;
+		}
+
+		np.Assign(block, blocks);
+		this->Trace(TraceEvent::Finished, np.GetSize(), states);
+	}
+
+	TDfa Minimize(const TDfa& dfa)
+	{
+		NumericPartition p;
+		Minimize(dfa, p);
+		return this->BuildDfa(dfa, p);
+	}
+};
+
+template<typename _TDfa, typename _TTrace>
+const typename MinimizationMooreParallel<_TDfa, _TTrace>::TState MinimizationMooreParallel<_TDfa, _TTrace>::Empty;
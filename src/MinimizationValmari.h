@@ -0,0 +1,224 @@
+#pragma once
+
+#include <stdint.h>
+#include <assert.h>
+#include <vector>
+#include <iostream>
+#include "Dfa.h"
+#include "Partition.h"
+#include "FsaBuilder.h"
+#include "Trace.h"
+
+///	Valmari and Lehtinen's minimization of partial DFAs.
+/// Only the defined transitions are refined. A second refinable partition groups them in cords,
+/// transitions with the same label whose targets lie in the same block, blocks split cords and
+/// cords split blocks until both are stable. O(m log n) for m defined transitions plus one pass
+/// over the transition table, a sparse automaton does not pay for the sink state it does not need.
+/// States that cannot reach a final state have the language of an undefined transition,
+/// transitions entering them are ignored and all of them end in one block.
+/// <param ref="_TTrace" /> receives the events of the refinement, the default one discards them at compile time.
+template<typename _TDfa, typename _TTrace = TraceNone>
+class MinimizationValmari
+{
+public:
+	typedef _TDfa TDfa;
+	typedef _TTrace TTrace;
+	typedef typename TDfa::TState TState;
+	typedef typename TDfa::TSymbol TSymbol;
+	typedef typename TDfa::TSet TSet;
+	typedef RefinablePartition<TState> NumericPartition;
+	/// Index of a defined transition, there may be more transitions than states
+	typedef size_t TTransition;
+	typedef RefinablePartition<TTransition> TransitionPartition;
+
+private:
+
+	/// Lists the transitions entering every state in <param ref="incoming" />, the ones of state q
+	/// are [first[q], first[q+1]). Counting sort by target, O(states + transitions)
+	static void BuildIncoming(TState states, const std::vector<TState>& heads, std::vector<TTransition>& first, std::vector<TTransition>& incoming)
+	{
+		first.assign(static_cast<size_t>(states) + 1, 0);
+		for(auto q : heads) first[q + 1]++;
+		for(size_t q=1; q<first.size(); q++) first[q] += first[q - 1];
+		incoming.resize(heads.size());
+		for(TTransition t=0; t<heads.size(); t++) incoming[first[heads[t]]++] = t;
+		// the scatter advanced every start to the next one
+		for(size_t q=first.size() - 1; q>0; q--) first[q] = first[q - 1];
+		first[0] = 0;
+	}
+
+public:
+
+	/// Receives the debugging events
+	TTrace Trace;
+
+	void Minimize(const TDfa& dfa, NumericPartition& np)
+	{
+		using namespace std;
+
+		const TState states = dfa.GetStates();
+		const TSymbol alpha = dfa.GetAlphabetLength();
+
+		// defined transitions grouped by label, counting sort over the state-major table
+		vector<TTransition> label_first(static_cast<size_t>(alpha) + 1, 0);
+		for(TState qs=0; qs<states; qs++)
+		{
+			for(TSymbol a=0; a<alpha; a++)
+			{
+				if(dfa.GetSuccessor(qs, a) != TDfa::None) label_first[a + 1]++;
+			}
+		}
+		for(TSymbol a=0; a<alpha; a++) label_first[a + 1] += label_first[a];
+		vector<TState> tails(dfa.GetTransitionCount()), heads(dfa.GetTransitionCount());
+		vector<TSymbol> labels(dfa.GetTransitionCount());
+		for(TState qs=0; qs<states; qs++)
+		{
+			for(TSymbol a=0; a<alpha; a++)
+			{
+				const TState qt = dfa.GetSuccessor(qs, a);
+				if(qt == TDfa::None) continue;
+				const TTransition t = label_first[a]++;
+				tails[t] = qs;
+				heads[t] = qt;
+				labels[t] = a;
+			}
+		}
+
+		vector<TTransition> first, incoming;
+		BuildIncoming(states, heads, first, incoming);
+
+		// states reaching a final one, backwards from the finals
+		TSet live(states);
+		vector<TState> pending;
+		pending.reserve(states);
+		for(TState q=0; q<states; q++)
+		{
+			if(dfa.IsFinal(q))
+			{
+				live.Add(q);
+				pending.push_back(q);
+			}
+		}
+		while(!pending.empty())
+		{
+			const TState q = pending.back();
+			pending.pop_back();
+			for(TTransition i=first[q]; i<first[q + 1]; i++)
+			{
+				const TState p = tails[incoming[i]];
+				if(!live.TestAndAdd(p)) pending.push_back(p);
+			}
+		}
+
+		// transitions entering dead states are dropped, the order by label is kept
+		TTransition kept = 0;
+		for(TTransition t=0; t<heads.size(); t++)
+		{
+			if(!live.Contains(heads[t])) continue;
+			tails[kept] = tails[t];
+			heads[kept] = heads[t];
+			labels[kept] = labels[t];
+			kept++;
+		}
+		tails.resize(kept);
+		heads.resize(kept);
+		labels.resize(kept);
+		BuildIncoming(states, heads, first, incoming);
+
+		// blocks: finals and non finals
+		np.Clear(states);
+		for(TState q=0; q<states; q++)
+		{
+			if(dfa.IsFinal(q)) np.Mark(q);
+		}
+		np.Split();
+
+		// cords: one per label
+		TransitionPartition cords;
+		cords.Clear(kept);
+		for(TTransition t=0; t<kept; )
+		{
+			const TSymbol a = labels[t];
+			for(; t<kept && labels[t] == a; t++) cords.Mark(t);
+			cords.Split();
+		}
+
+		Trace(TraceEvent::Initial, np.GetSize(), states, cords.GetSize());
+
+		// Every block and every cord is used once as splitter, a split block or cord keeps its index
+		// for the part already used and the new part, the smaller one, is used later.
+		// Block 0 is skipped, the cords by label already split by all the states.
+		TState b = 1;
+		TTransition c = 0;
+		while(c < cords.GetSize())
+		{
+			// sources of the cord c
+			for(auto t : cords.GetBlock(c)) np.Mark(tails[t]);
+			np.Split();
+			c++;
+
+			while(b < np.GetSize())
+			{
+				// transitions entering the block b
+				for(auto q : np.GetBlock(b))
+				{
+					for(TTransition i=first[q]; i<first[q + 1]; i++) cords.Mark(incoming[i]);
+				}
+				cords.Split();
+				b++;
+			}
+		}
+
+		Trace(TraceEvent::Finished, np.GetSize(), states);
+	}
+
+	/// Builds the partial quotient DFA, transitions entering the block of the dead states are left undefined.
+	/// That block, if any, is kept without transitions as the blocks of unreachable states are.
+	TDfa BuildDfa(const TDfa& dfa, const NumericPartition& partitions)
+	{
+		using namespace std;
+
+		// the dead states are non finals whose transitions stay in their own block
+		vector<bool> dead(partitions.GetSize());
+		for(TState i=0; i<partitions.GetSize(); i++)
+		{
+			const TState s = partitions.GetFirst(i);
+			bool d = !dfa.IsFinal(s);
+			for(TSymbol a=0; d && a<dfa.GetAlphabetLength(); a++)
+			{
+				const TState t = dfa.GetSuccessor(s, a);
+				d = t == TDfa::None || partitions.Find(t) == i;
+			}
+			dead[i] = d;
+		}
+
+		FsaBuilder<TDfa> ndfa(dfa.GetAlphabetLength(), partitions.GetSize());
+		typename FsaBuilder<TDfa>::TEdgeBatch edges;
+		for(TState i=0; i<partitions.GetSize(); i++)
+		{
+			// every member of the block has the same transitions
+			const TState s = partitions.GetFirst(i);
+			for(TSymbol a=0; a<dfa.GetAlphabetLength(); a++)
+			{
+				const TState t = dfa.GetSuccessor(s, a);
+				if(t == TDfa::None) continue;
+				const TState pt = partitions.Find(t);
+				if(!dead[pt]) edges.emplace_back(i, a, pt);
+			}
+			for(auto st : partitions.GetBlock(i))
+			{
+				if(dfa.IsInitial(st)) ndfa.SetInitial(i);
+				if(dfa.IsFinal(st)) ndfa.SetFinal(i);
+			}
+		}
+		ndfa.AddEdges(std::move(edges));
+		return ndfa.Build();
+	}
+
+	TDfa Minimize(const TDfa& dfa)
+	{
+		NumericPartition p;
+		Minimize(dfa, p);
+		return BuildDfa(dfa, p);
+	}
+};
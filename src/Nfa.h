@@ -3,24 +3,29 @@
 
 #include "Set.h"
 #include <vector>
+#include <tuple>
 #include <limits>
 
 ///	Represents a Non-Deterministic Finite Automata.
 ///	<param ref="TState" /> is the integer type representing states.
 ///	<param ref="TSymbol" /> is the integer type representing symbols.
 ///	<param ref="TToken" /> is the integer type used in order to manage internal storage of BitSets.
+///	<param ref="TSet" /> is the set of states used by the rows, BitSet or CompressedSet.
 /// Represenation:
 /// Each state is a zero-based integer index.
 /// Each symbol is a zero-based integer index.
-template<typename _TState, typename _TSymbol, typename TToken = uint64_t>
+template<typename _TState, typename _TSymbol, typename TToken = uint64_t, typename _TSet = BitSet<_TState, TToken>>
 class Nfa
 {
 public:	
 	typedef _TState TState;
 	typedef _TSymbol TSymbol;
-	typedef Nfa<TState,TSymbol,TToken> TNfa;
-	typedef BitSet<TState, TToken> TSet;
+	typedef _TSet TSet;
+	typedef Nfa<TState,TSymbol,TToken,TSet> TNfa;
 	typedef std::tuple<TState,TSymbol,TState> TEdge;
+
+	/// Rows combined per pass by GatherSuccessors
+	static const size_t UnionBatch = 16;
 	
 private:
 	/// number of symbols in alphabet
@@ -67,6 +72,23 @@ public:
 		assert(states*alpha == predecessors.size());
 	}
 
+	/// Creates the NFA with every transition in <param ref="edges" />, in any order.
+	/// O(edges + states * states * alphabet)
+	Nfa(TSymbol alpha, TState states, const TSet& initials, const TSet& finals, const std::vector<TEdge>& edges)
+		:States(states), Alphabet(alpha), Predecessors(alpha * states, TSet(states)), Succesors(alpha * states, TSet(states)), Initial(initials), Final(finals)
+	{
+		for(const auto& e : edges)
+		{
+			TState qs, qt; TSymbol a;
+			std::tie(qs, a, qt) = e;
+			assert(qs < States);
+			assert(qt < States);
+			assert(a < Alphabet);
+			Succesors[Alphabet * qs + a].Add(qt);
+			Predecessors[Alphabet * qt + a].Add(qs);
+		}
+	}
+
 	/// Get the number of symbols in alphabet
 	/// O(1)
 	virtual TSymbol GetAlphabetLength() const { return Alphabet; }
@@ -127,6 +149,46 @@ public:
 		return Succesors[index];
 	}
 
+	/// Adds the targets transitioned from <param ref="source" /> consuming <param ref="symbol" /> into <param ref="set" />
+	/// O(states)
+	void UnionSuccessors(TState source, TSymbol symbol, TSet& set) const
+	{
+		set.UnionWith(GetSuccessors(source, symbol));
+	}
+
+	/// Replaces <param ref="set" /> with the targets transitioned from any state of [<param ref="first" />, <param ref="last" />) consuming <param ref="symbol" />.
+	/// Rows are combined in batches, so <param ref="set" /> is written once per batch instead of once per source.
+	/// O(sources * states)
+	void GatherSuccessors(const TState* first, const TState* last, TSymbol symbol, TSet& set) const
+	{
+		const TSet* rows[UnionBatch];
+		size_t k = 0;
+		bool fresh = true;
+		for(; first != last; ++first)
+		{
+			if(k == UnionBatch)
+			{
+				if(fresh) set.UnionOf(rows, rows + k);
+				else set.UnionWithMany(rows, rows + k);
+				fresh = false;
+				k = 0;
+			}
+			rows[k++] = &GetSuccessors(*first, symbol);
+		}
+		if(fresh) set.UnionOf(rows, rows + k);
+		else set.UnionWithMany(rows, rows + k);
+	}
+
+	/// Replaces <param ref="set" /> with the targets transitioned from any state of <param ref="sources" /> consuming <param ref="symbol" />.
+	/// Callers visiting several symbols should extract <param ref="sources" /> once and use the range form.
+	/// O(sources * states)
+	void GatherSuccessors(const TSet& sources, TSymbol symbol, TSet& set) const
+	{
+		std::vector<TState> states(sources.Count());
+		sources.ExtractTo(states.data());
+		GatherSuccessors(states.data(), states.data() + states.size(), symbol, set);
+	}
+
 	/// Check if state <param ref="target" /> is reach from state <param ref="source" /> consuming symbol <param ref="symbol" />
 	/// O(1)
 	virtual bool IsSuccessor(TState source, TSymbol symbol, TState target) const 
@@ -150,6 +212,21 @@ public:
 		return Predecessors[index];
 	}
 
+	/// Calls <param ref="f" /> with every transition, sorted by source, symbol and target
+	/// O(states * states * alphabet)
+	template<typename TFunc>
+	void ForEachEdge(TFunc f) const
+	{
+		for(TState s=0; s<States; s++)
+		{
+			for(TSymbol a=0; a<Alphabet; a++)
+			{
+				const TSet& targets = GetSuccessors(s, a);
+				for(auto i=targets.GetIterator(); !i.IsEnd(); i.MoveNext()) f(TEdge(s, a, i.GetCurrent()));
+			}
+		}
+	}
+
 	/// Indicates if <param ref="state" /> is a Final State
 	/// O(1)
 	virtual bool IsFinal(TState state) const 
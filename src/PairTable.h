@@ -0,0 +1,141 @@
+#pragma once
+
+#include <stdint.h>
+#include <assert.h>
+#include <math.h>
+#include <vector>
+#include <tuple>
+
+/// Pairs of states p < q numbered by rows of the strict lower triangle, (q*q-q)/2+p, computed in 64 bits.
+/// The numbering and its inverse are exact for every state below 2^32.
+struct PairIndexing
+{
+	typedef uint64_t TPairIndex;
+
+	static TPairIndex GetIndex(uint64_t p, uint64_t q)
+	{
+		assert(p < q);
+		return (q * q - q) / 2 + p;
+	}
+
+	/// Inverse of GetIndex, the floating point root is a guess corrected in integers
+	template<typename TState>
+	static std::tuple<TState, TState> GetPair(TPairIndex index)
+	{
+		uint64_t q = static_cast<uint64_t>((1.0 + sqrt(1.0 + 8.0 * static_cast<double>(index))) / 2.0);
+		while(q > 1 && (q * q - q) / 2 > index) q--;
+		while((q * q + q) / 2 <= index) q++;
+		const uint64_t p = index - (q * q - q) / 2;
+		assert(p < q);
+		return std::make_tuple(static_cast<TState>(p), static_cast<TState>(q));
+	}
+};
+
+/// Open addressing table from pair indices to <param ref="_TValue" />, for the pairs a minimization reaches
+/// out of the (n*n-n)/2 of a DFA. The occupied slots are listed, Clear costs the pairs inserted and keeps
+/// the capacity for the next use. There is no removal, pairs leave the table with Clear.
+template<typename _TValue>
+class PairTable
+{
+public:
+	typedef uint64_t TPairIndex;
+	typedef _TValue TValue;
+
+private:
+	static const TPairIndex Empty = ~static_cast<TPairIndex>(0);
+
+	std::vector<TPairIndex> keys;
+	std::vector<TValue> values;
+	/// Occupied slots in insertion order
+	std::vector<size_t> used;
+	size_t mask;
+	unsigned shift;
+
+	size_t Slot(TPairIndex k) const
+	{
+		// Fibonacci hashing, the high bits of the product spread the consecutive indices of a row
+		size_t i = static_cast<size_t>((k * 0x9e3779b97f4a7c15ULL) >> shift);
+		while(keys[i] != Empty && keys[i] != k) i = (i + 1) & mask;
+		return i;
+	}
+
+	/// Doubles the capacity, the insertion order is kept
+	void Grow()
+	{
+		std::vector<TPairIndex> old_keys(keys.size() * 2, Empty);
+		std::vector<TValue> old_values(values.size() * 2);
+		old_keys.swap(keys);
+		old_values.swap(values);
+		mask = keys.size() - 1;
+		shift--;
+		for(auto& i : used)
+		{
+			const size_t j = Slot(old_keys[i]);
+			keys[j] = old_keys[i];
+			values[j] = old_values[i];
+			i = j;
+		}
+	}
+
+public:
+	PairTable() : keys(16, Empty), values(16), mask(15), shift(60)
+	{
+	}
+
+	/// Pairs inserted since the last Clear
+	size_t GetSize() const { return used.size(); }
+
+	/// Slots allocated, twice the pairs at most
+	size_t GetCapacity() const { return keys.size(); }
+
+	bool Contains(TPairIndex k) const { return keys[Slot(k)] == k; }
+
+	/// Value of <param ref="k" />, or nullptr if absent. The pointer is valid until the next insertion
+	TValue* Find(TPairIndex k)
+	{
+		const size_t i = Slot(k);
+		return keys[i] == k ? &values[i] : nullptr;
+	}
+
+	/// Value of <param ref="k" />, a default one is inserted if absent and <param ref="inserted" /> tells it.
+	/// The reference is valid until the next insertion
+	TValue& Insert(TPairIndex k, bool& inserted)
+	{
+		assert(k != Empty);
+		size_t i = Slot(k);
+		inserted = keys[i] != k;
+		if(inserted)
+		{
+			// half full at most
+			if(2 * (used.size() + 1) > keys.size())
+			{
+				Grow();
+				i = Slot(k);
+			}
+			keys[i] = k;
+			used.push_back(i);
+		}
+		return values[i];
+	}
+
+	/// Adds <param ref="k" /> and returns if it was already present
+	bool TestAndAdd(TPairIndex k)
+	{
+		bool inserted;
+		Insert(k, inserted);
+		return !inserted;
+	}
+
+	void Clear()
+	{
+		for(auto i : used)
+		{
+			keys[i] = Empty;
+			values[i] = TValue();
+		}
+		used.clear();
+	}
+};
+
+template<typename _TValue>
+const typename PairTable<_TValue>::TPairIndex PairTable<_TValue>::Empty;
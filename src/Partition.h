@@ -0,0 +1,322 @@
+#pragma once
+
+#include "Span.h"
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <assert.h>
+
+///	Refinable partition of the elements 0..n-1 (Valmari and Lehtinen).
+/// Elements are stored grouped by block in one array, every block is the range [first, end) of it.
+/// Marked elements are moved to the front of their block, so marking is O(1) and
+/// splitting the touched blocks is O(marked). No heap allocation happens after <see cref="Clear" />.
+template<typename _TElement>
+class RefinablePartition
+{
+public:
+	typedef _TElement TElement;
+	typedef Span<TElement> TSpan;
+
+private:
+	/// Elements grouped by block
+	std::vector<TElement> elements;
+	/// Element to its position in elements
+	std::vector<TElement> location;
+	/// Element to its block
+	std::vector<TElement> membership;
+	/// Block to the position of its first element
+	std::vector<TElement> first;
+	/// Block to the position after its marked elements
+	std::vector<TElement> marked_end;
+	/// Block to the position after its last element
+	std::vector<TElement> end;
+	/// Blocks with at least one marked element
+	std::vector<TElement> touched;
+	TElement blocks;
+
+public:
+	RefinablePartition()
+		: blocks(0)
+	{
+	}
+
+	/// Puts the <param ref="size" /> elements in one block, or none when <param ref="size" /> is zero
+	void Clear(TElement size)
+	{
+		elements.resize(size);
+		location.resize(size);
+		membership.assign(size, 0);
+		// at most one block per element
+		first.resize(size);
+		marked_end.resize(size);
+		end.resize(size);
+		touched.clear();
+		touched.reserve(size);
+		for(TElement i=0; i<size; i++)
+		{
+			elements[i] = i;
+			location[i] = i;
+		}
+		blocks = size > 0 ? 1 : 0;
+		if(blocks)
+		{
+			first[0] = 0;
+			marked_end[0] = 0;
+			end[0] = size;
+		}
+	}
+
+	/// Replaces the partition of the elements of <param ref="block_of" />, element e goes to block block_of[e].
+	/// The <param ref="count" /> blocks are numbered from zero and none is empty. O(size + count)
+	void Assign(const std::vector<TElement>& block_of, TElement count)
+	{
+		Clear(static_cast<TElement>(block_of.size()));
+		// sizes first, kept in end until the positions are known
+		std::fill(end.begin(), end.begin() + count, 0);
+		for(auto b : block_of) end[b]++;
+		TElement position = 0;
+		for(TElement b=0; b<count; b++)
+		{
+			first[b] = position;
+			marked_end[b] = position;
+			position += end[b];
+			end[b] = first[b];
+		}
+		for(TElement e=0; e<static_cast<TElement>(block_of.size()); e++)
+		{
+			const TElement b = block_of[e];
+			membership[e] = b;
+			location[e] = end[b];
+			elements[end[b]++] = e;
+		}
+		blocks = count;
+	}
+
+	/// Number of blocks
+	TElement GetSize() const { return blocks; }
+
+	/// Block of <param ref="e" />
+	TElement Find(TElement e) const { return membership[e]; }
+
+	/// Elements of <param ref="block" />, invalidated by <see cref="Mark" /> and <see cref="Split" />
+	TSpan GetBlock(TElement block) const
+	{
+		return TSpan(elements.data() + first[block], elements.data() + end[block]);
+	}
+
+	TElement GetBlockSize(TElement block) const { return end[block] - first[block]; }
+
+	/// Any element of <param ref="block" />
+	TElement GetFirst(TElement block) const { return elements[first[block]]; }
+
+	TElement GetMarkedCount(TElement block) const { return marked_end[block] - first[block]; }
+
+	bool IsMarked(TElement e) const { return location[e] < marked_end[membership[e]]; }
+
+	/// Marks <param ref="e" /> for the next split, returns false if it was already marked. O(1)
+	bool Mark(TElement e)
+	{
+		const TElement block = membership[e];
+		const TElement i = location[e];
+		const TElement j = marked_end[block];
+		if(i < j) return false;
+		if(j == first[block]) touched.push_back(block);
+		// exchange with the first unmarked element
+		const TElement other = elements[j];
+		elements[j] = e;
+		elements[i] = other;
+		location[e] = j;
+		location[other] = i;
+		marked_end[block] = j + 1;
+		return true;
+	}
+
+	/// Separates the marked elements of every touched block from the unmarked ones and clears the marks.
+	/// The smaller part gets a new block index, then <param ref="on_split" /> is called
+	/// as on_split(TElement block, TElement new_block). Blocks fully marked are left as they are.
+	/// O(marked)
+	template<typename TSplitHandler>
+	void Split(TSplitHandler on_split)
+	{
+		for(auto block : touched)
+		{
+			const TElement mid = marked_end[block];
+			if(mid == end[block])
+			{
+				marked_end[block] = first[block];
+				continue;
+			}
+
+			const TElement new_block = blocks++;
+			if(mid - first[block] <= end[block] - mid)
+			{
+				first[new_block] = first[block];
+				end[new_block] = mid;
+				first[block] = mid;
+			}
+			else
+			{
+				first[new_block] = mid;
+				end[new_block] = end[block];
+				end[block] = mid;
+			}
+			marked_end[new_block] = first[new_block];
+			marked_end[block] = first[block];
+			for(TElement i=first[new_block]; i<end[new_block]; i++) membership[elements[i]] = new_block;
+			on_split(block, new_block);
+		}
+		touched.clear();
+	}
+
+	void Split()
+	{
+		Split([](TElement, TElement) {});
+	}
+};
+
+///	Partition of the elements 0..n-1 only coarsened by unions.
+/// The blocks are trees of a disjoint set forest joined by size with path halving, Find and Union
+/// cost an amortized inverse Ackermann. Every root keeps the number of its block and every block
+/// is also a circular list threaded through one array of successors, so unions link both lists in O(1).
+/// Find compresses paths, a partition is not shared between threads.
+template<typename _TElement>
+class MergeablePartition
+{
+public:
+	typedef _TElement TElement;
+
+private:
+	/// Element to its parent in the forest, a root is its own parent
+	mutable std::vector<TElement> parent;
+	/// Root to the number of its block
+	std::vector<TElement> label;
+	/// Element to the next element of its block
+	std::vector<TElement> next;
+	/// Block to one of its elements, or None if the block is empty
+	std::vector<TElement> head;
+	/// Block to its number of elements
+	std::vector<TElement> count;
+	TElement blocks;
+
+	TElement Root(TElement e) const
+	{
+		while(parent[e] != e)
+		{
+			parent[e] = parent[parent[e]];
+			e = parent[e];
+		}
+		return e;
+	}
+
+public:
+	static const TElement None = std::numeric_limits<TElement>::max();
+
+	MergeablePartition()
+		: blocks(0)
+	{
+	}
+
+	explicit MergeablePartition(TElement size)
+	{
+		Clear(size);
+	}
+
+	/// One block per element, block i holds element i
+	void Clear(TElement size)
+	{
+		parent.resize(size);
+		label.resize(size);
+		next.resize(size);
+		head.resize(size);
+		count.assign(size, 1);
+		for(TElement i=0; i<size; i++)
+		{
+			parent[i] = i;
+			label[i] = i;
+			next[i] = i;
+			head[i] = i;
+		}
+		blocks = size;
+	}
+
+	TElement Find(TElement e) const { return label[Root(e)]; }
+
+	/// Same as Find(a) == Find(b) without reading the block numbers
+	bool SameBlock(TElement a, TElement b) const { return Root(a) == Root(b); }
+
+	/// Joins the blocks of <param ref="i" /> and <param ref="j" />, returns the resulting block
+	TElement Union(TElement i, TElement j)
+	{
+		using namespace std;
+		i = Root(i);
+		j = Root(j);
+		if(i == j) return label[i];
+		TElement bi = label[i], bj = label[j];
+		// the bigger block keeps its number and its root
+		if(count[bi] < count[bj])
+		{
+			swap(i, j);
+			swap(bi, bj);
+		}
+		parent[j] = i;
+		swap(next[head[bi]], next[head[bj]]);
+		count[bi] += count[bj];
+		count[bj] = 0;
+		head[bj] = None;
+		blocks--;
+		return bi;
+	}
+
+	/// Renumbers the non empty blocks as 0..GetSize()-1, keeping their relative order,
+	/// and flattens the forest so every element points to its root. O(n)
+	void Compact()
+	{
+		TElement k = 0;
+		for(TElement b=0; b<static_cast<TElement>(head.size()); b++)
+		{
+			if(head[b] == None) continue;
+			if(k != b)
+			{
+				head[k] = head[b];
+				count[k] = count[b];
+				head[b] = None;
+				count[b] = 0;
+			}
+			label[Root(head[k])] = k;
+			k++;
+		}
+		assert(k == blocks);
+		for(TElement e=0; e<static_cast<TElement>(parent.size()); e++) parent[e] = Root(e);
+	}
+
+	/// Number of non empty blocks
+	TElement GetSize() const { return blocks; }
+
+	/// Number of block indices, empty blocks included
+	TElement GetCapacity() const { return static_cast<TElement>(head.size()); }
+
+	bool IsEmpty(TElement block) const { return head[block] == None; }
+
+	TElement GetBlockSize(TElement block) const { return count[block]; }
+
+	/// Any element of a non empty <param ref="block" />
+	TElement GetFirst(TElement block) const { return head[block]; }
+
+	/// Calls <param ref="f" /> with every element of <param ref="block" />
+	template<typename TFunc>
+	void ForEach(TElement block, TFunc f) const
+	{
+		const TElement h = head[block];
+		if(h == None) return;
+		TElement e = h;
+		do
+		{
+			const TElement n = next[e];
+			f(e);
+			e = n;
+		} while(e != h);
+	}
+};
+
+template<typename _TElement>
+const _TElement MergeablePartition<_TElement>::None;
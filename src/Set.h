@@ -6,17 +6,40 @@
 #include <string>
 #include <boost/functional/hash.hpp>
 
-template<typename _TElement, typename TBlock = uint64_t>
+/// Set of integers in [0, elements) stored as a bitmap.
+/// Up to <param ref="InlineBlocks" /> blocks are stored inside the object, bigger sets use the heap.
+template<typename _TElement, typename TBlock = uint64_t, size_t InlineBlocks = BITSET_INLINE_BLOCKS>
 class BitSet
 {
 public:
 	typedef _TElement TElement;
-	typedef dynamic_bitset<TElement, TBlock> TStore;
-	typedef BitSet<TElement, TBlock> TSet;
+	typedef dynamic_bitset<TElement, TBlock, std::allocator<TBlock>, InlineBlocks> TStore;
+	typedef BitSet<TElement, TBlock, InlineBlocks> TSet;
 
 private:
 	TStore store;
 
+	static const TSet& Deref(const TSet& set) { return set; }
+	static const TSet& Deref(const TSet* set) { return *set; }
+
+	template<typename TIterator>
+	TElement UnionMany(TIterator first, TIterator last, bool accumulate, bool count)
+	{
+		const TStore* batch[TStore::union_many_batch];
+		size_t k = 0;
+		for(; first != last; ++first)
+		{
+			if(k == TStore::union_many_batch)
+			{
+				store.union_many(batch, k, accumulate, false);
+				accumulate = true;
+				k = 0;
+			}
+			batch[k++] = &Deref(*first).store;
+		}
+		return store.union_many(batch, k, accumulate, count);
+	}
+
 public:
 	
 	struct hash
@@ -72,6 +95,24 @@ public:
 		store.union_with(other.store);
 	}
 
+	/// Adds every set of [<param ref="first" />, <param ref="last" />), a range of sets or of pointers to sets.
+	/// Every block of this set is loaded and stored once per batch of inputs instead of once per input.
+	/// O(inputs * elements / bits per block)
+	template<typename TIterator>
+	void UnionWithMany(TIterator first, TIterator last)
+	{
+		UnionMany(first, last, true, false);
+	}
+
+	/// Replaces this set with the union of [<param ref="first" />, <param ref="last" />), a range of sets or of pointers to sets.
+	/// Returns the number of elements of the result if <param ref="count" /> is set, zero otherwise.
+	/// O(inputs * elements / bits per block)
+	template<typename TIterator>
+	TElement UnionOf(TIterator first, TIterator last, bool count = false)
+	{
+		return UnionMany(first, last, false, count);
+	}
+
 	void IntersectWith(const TSet& other)
 	{
 		store.intersect_with(other.store);
@@ -186,6 +227,14 @@ public:
 		return Iterator(store.begin());
 	}
 
+	/// Writes every element into <param ref="out" /> in increasing order and returns how many were written.
+	/// <param ref="out" /> must have room for Count() elements.
+	/// O(elements / bits per block + count)
+	TElement ExtractTo(TElement* out) const
+	{
+		return store.extract_to(out);
+	}
+
 	bool operator==(const TSet& rh) const
 	{
 		return store == rh.store;
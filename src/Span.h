@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stddef.h>
+
+/// Read-only view over a contiguous run of elements owned by someone else.
+/// It is invalidated as soon as the owner storage changes.
+template<typename _TElement>
+class Span
+{
+public:
+	typedef _TElement TElement;
+	typedef const TElement* TIterator;
+
+private:
+	const TElement* first;
+	const TElement* last;
+
+public:
+	Span()
+		: first(nullptr), last(nullptr)
+	{
+	}
+
+	Span(const TElement* _first, const TElement* _last)
+		: first(_first), last(_last)
+	{
+	}
+
+	TIterator begin() const { return first; }
+
+	TIterator end() const { return last; }
+
+	size_t Count() const { return static_cast<size_t>(last - first); }
+
+	bool IsEmpty() const { return first == last; }
+
+	const TElement& operator[](size_t index) const { return first[index]; }
+};
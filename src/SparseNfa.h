@@ -0,0 +1,419 @@
+#pragma once
+
+#include "Set.h"
+#include "Span.h"
+#include <vector>
+#include <tuple>
+#include <limits>
+#include <algorithm>
+#include <assert.h>
+
+///	Represents a Non-Deterministic Finite Automata using sparse storage.
+/// It exposes the same interface as Nfa, but transitions are stored as sorted CSR rows
+/// (one run of targets per (state, symbol) pair) instead of one dense BitSet per row.
+/// Rows holding enough targets to be cheaper as a BitSet are switched to dense storage.
+/// Transitions are collected as edges and the rows are built on demand, so SetTransition is O(1)
+/// and the first query after a modification takes O(edges + states * alphabet).
+///	<param ref="TState" /> is the integer type representing states.
+///	<param ref="TSymbol" /> is the integer type representing symbols.
+///	<param ref="TToken" /> is the integer type used in order to manage internal storage of BitSets.
+///	<param ref="TSet" /> is the set of states used by dense rows, BitSet or CompressedSet.
+template<typename _TState, typename _TSymbol, typename TToken = uint64_t, typename _TSet = BitSet<_TState, TToken>>
+class SparseNfa
+{
+public:
+	typedef _TState TState;
+	typedef _TSymbol TSymbol;
+	typedef _TSet TSet;
+	typedef SparseNfa<TState,TSymbol,TToken,TSet> TNfa;
+	typedef std::tuple<TState,TSymbol,TState> TEdge;
+	typedef Span<TState> TStateSpan;
+
+	/// Dense rows combined per pass by GatherSuccessors
+	static const size_t UnionBatch = 16;
+
+	/// States reached from one (state, symbol) pair, either a sorted span or a dense set
+	class Row
+	{
+	private:
+		TStateSpan sparse;
+		const TSet* dense;
+
+	public:
+		Row(TStateSpan _sparse, const TSet* _dense)
+			: sparse(_sparse), dense(_dense)
+		{
+		}
+
+		bool IsDense() const { return dense != nullptr; }
+
+		/// Only valid if IsDense()
+		const TSet& GetDense() const { return *dense; }
+
+		/// Only valid if !IsDense()
+		const TStateSpan& GetSparse() const { return sparse; }
+
+		size_t Count() const
+		{
+			return dense ? static_cast<size_t>(dense->Count()) : sparse.Count();
+		}
+
+		bool Contains(TState state) const
+		{
+			if(dense) return dense->Contains(state);
+			return std::binary_search(sparse.begin(), sparse.end(), state);
+		}
+
+		/// Adds every state of this row into <param ref="set" />
+		void UnionTo(TSet& set) const
+		{
+			if(dense) set.UnionWith(*dense);
+			else for(auto s : sparse) set.Add(s);
+		}
+	};
+
+private:
+
+	/// One direction of the transition relation
+	class Relation
+	{
+	public:
+		/// (rows + 1) offsets into Targets, dense rows own an empty run
+		std::vector<size_t> Offsets;
+
+		/// sorted runs of targets
+		std::vector<TState> Targets;
+
+		/// rows stored as dense sets
+		std::vector<size_t> DenseRows;
+		std::vector<TSet> Dense;
+
+		void Clear()
+		{
+			Offsets.clear();
+			Targets.clear();
+			DenseRows.clear();
+			Dense.clear();
+		}
+
+		/// <param ref="edges" /> must be sorted and unique, <param ref="reverse" /> builds the inverse relation
+		void Build(const std::vector<TEdge>& edges, TSymbol alpha, TState states, bool reverse)
+		{
+			using namespace std;
+			Clear();
+			const size_t rows = static_cast<size_t>(states) * alpha;
+			Offsets.assign(rows + 1, 0);
+
+			for(const auto& e : edges)
+			{
+				TState qs, qt; TSymbol a;
+				tie(qs, a, qt) = e;
+				if(reverse) swap(qs, qt);
+				Offsets[static_cast<size_t>(qs) * alpha + a + 1]++;
+			}
+
+			// A row becomes dense when a bitset is not bigger than its targets
+			const size_t dense_threshold = max<size_t>(1, states / (sizeof(TState) * 8));
+			for(size_t r=0; r<rows; r++)
+			{
+				if(Offsets[r + 1] > dense_threshold)
+				{
+					DenseRows.push_back(r);
+					Offsets[r + 1] = 0;
+				}
+			}
+			Dense.assign(DenseRows.size(), TSet(states));
+
+			for(size_t r=0; r<rows; r++) Offsets[r + 1] += Offsets[r];
+			Targets.resize(Offsets[rows]);
+
+			// edges are sorted by (source, symbol, target), both directions come out with sorted runs
+			vector<size_t> cursor(Offsets.begin(), Offsets.end() - 1);
+			for(const auto& e : edges)
+			{
+				TState qs, qt; TSymbol a;
+				tie(qs, a, qt) = e;
+				if(reverse) swap(qs, qt);
+				const size_t r = static_cast<size_t>(qs) * alpha + a;
+				if(Offsets[r] == Offsets[r + 1] && IsDenseRow(r))
+				{
+					Dense[DenseSlot(r)].Add(qt);
+				}
+				else
+				{
+					Targets[cursor[r]++] = qt;
+				}
+			}
+		}
+
+		bool IsDenseRow(size_t r) const
+		{
+			return std::binary_search(DenseRows.begin(), DenseRows.end(), r);
+		}
+
+		size_t DenseSlot(size_t r) const
+		{
+			return static_cast<size_t>(std::lower_bound(DenseRows.begin(), DenseRows.end(), r) - DenseRows.begin());
+		}
+
+		Row Get(size_t r) const
+		{
+			const size_t b = Offsets[r], e = Offsets[r + 1];
+			if(b == e && !DenseRows.empty() && IsDenseRow(r))
+			{
+				return Row(TStateSpan(), &Dense[DenseSlot(r)]);
+			}
+			const TState* base = Targets.data();
+			return Row(TStateSpan(base + b, base + e), nullptr);
+		}
+	};
+
+	/// number of symbols in alphabet
+	TSymbol Alphabet;
+
+	/// States backing field
+	TState States;
+
+	/// Initial states set
+	TSet Initial;
+
+	/// Final states set
+	TSet Final;
+
+	/// Every transition, sorted and unique when Ready
+	mutable std::vector<TEdge> Edges;
+
+	/// Function to calculate next state
+	mutable Relation Succesors;
+
+	/// Inverse function
+	mutable Relation Predecessors;
+
+	/// Indicates if both relations reflect Edges
+	mutable bool Ready;
+
+	void PrepareEdges() const
+	{
+		std::sort(Edges.begin(), Edges.end());
+		Edges.erase(std::unique(Edges.begin(), Edges.end()), Edges.end());
+	}
+
+public:
+
+	const TSet& GetInitials() const
+	{
+		return Initial;
+	}
+
+	const TSet& GetFinals() const
+	{
+		return Final;
+	}
+
+	SparseNfa(TSymbol alpha, TState states)
+		: States(states), Alphabet(alpha), Initial(states), Final(states), Ready(false)
+	{
+		assert(states < std::numeric_limits<TState>::max());
+	}
+
+	/// Creates the NFA with every transition in <param ref="edges" />, in any order.
+	/// Both directions are built at once.
+	/// O(edges log edges + states * alphabet)
+	SparseNfa(TSymbol alpha, TState states, const TSet& initials, const TSet& finals, std::vector<TEdge> edges)
+		: States(states), Alphabet(alpha), Initial(initials), Final(finals), Edges(std::move(edges)), Ready(false)
+	{
+		assert(states < std::numeric_limits<TState>::max());
+		Build();
+	}
+
+	/// Get the number of symbols in alphabet
+	/// O(1)
+	TSymbol GetAlphabetLength() const { return Alphabet; }
+
+	/// Get maximum number of states of this NFA
+	/// O(1)
+	TState GetStates() const { return States; }
+
+	/// Get the number of transitions
+	/// O(edges log edges) if there are pending modifications, O(1) otherwise
+	size_t GetEdgeCount() const
+	{
+		Build();
+		return Edges.size();
+	}
+
+	/// Calls <param ref="f" /> with every transition, sorted by source, symbol and target
+	/// O(edges log edges) if there are pending modifications, O(edges) otherwise
+	template<typename TFunc>
+	void ForEachEdge(TFunc f) const
+	{
+		Build();
+		for(const auto& e : Edges) f(e);
+	}
+
+	/// Set or unset one state as Final
+	/// O(1)
+	void SetFinal(TState state, bool st = true)
+	{
+		assert(state < States);
+
+		if(st) Final.Add(state);
+		else Final.Remove(state);
+	}
+
+	/// Set or unset one state as Initial
+	/// O(1)
+	void SetInitial(TState state, bool st = true)
+	{
+		assert(state < States);
+
+		if(st) Initial.Add(state);
+		else Initial.Remove(state);
+	}
+
+	/// Adjust the transition from <param ref="source_state" /> consuming <param ref="symbol" /> to <param ref="target_state" />
+	/// O(1) to add, O(edges) to remove
+	void SetTransition(TState source_state, TSymbol symbol, TState target_state, bool add=true)
+	{
+		assert(source_state < States);
+		assert(target_state < States);
+		assert(symbol < Alphabet);
+
+		const TEdge edge(source_state, symbol, target_state);
+		if(add)
+		{
+			Edges.push_back(edge);
+		}
+		else
+		{
+			if(!Ready) PrepareEdges();
+			auto i = std::lower_bound(Edges.begin(), Edges.end(), edge);
+			if(i == Edges.end() || *i != edge) return;
+			Edges.erase(i);
+		}
+		Ready = false;
+	}
+
+	/// Builds the rows if they are not up to date.
+	/// Call it before sharing this NFA between threads, queries build them lazily otherwise.
+	/// O(edges log edges + states * alphabet)
+	void Build() const
+	{
+		if(Ready) return;
+		PrepareEdges();
+		Succesors.Build(Edges, Alphabet, States, false);
+		Predecessors.Build(Edges, Alphabet, States, true);
+		Ready = true;
+	}
+
+	/// Get the target states transitioned from <param ref="source" /> consuming <param ref="symbol" />
+	/// O(1) amortized
+	Row GetSuccessors(TState source, TSymbol symbol) const
+	{
+		assert(source < States);
+		assert(symbol < Alphabet);
+
+		Build();
+		return Succesors.Get(static_cast<size_t>(source) * Alphabet + symbol);
+	}
+
+	/// Adds the targets transitioned from <param ref="source" /> consuming <param ref="symbol" /> into <param ref="set" />
+	/// O(targets) for sparse rows, O(states) for dense rows
+	void UnionSuccessors(TState source, TSymbol symbol, TSet& set) const
+	{
+		GetSuccessors(source, symbol).UnionTo(set);
+	}
+
+	/// Replaces <param ref="set" /> with the targets transitioned from any state of [<param ref="first" />, <param ref="last" />) consuming <param ref="symbol" />.
+	/// Dense rows are combined in batches, sparse rows are added one target at a time.
+	/// O(sparse targets + dense rows * states)
+	void GatherSuccessors(const TState* first, const TState* last, TSymbol symbol, TSet& set) const
+	{
+		const TSet* rows[UnionBatch];
+		size_t k = 0;
+		set.Clear();
+		for(; first != last; ++first)
+		{
+			Row row = GetSuccessors(*first, symbol);
+			if(!row.IsDense())
+			{
+				for(auto q : row.GetSparse()) set.Add(q);
+				continue;
+			}
+			if(k == UnionBatch)
+			{
+				set.UnionWithMany(rows, rows + k);
+				k = 0;
+			}
+			rows[k++] = &row.GetDense();
+		}
+		if(k) set.UnionWithMany(rows, rows + k);
+	}
+
+	/// Replaces <param ref="set" /> with the targets transitioned from any state of <param ref="sources" /> consuming <param ref="symbol" />.
+	/// Callers visiting several symbols should extract <param ref="sources" /> once and use the range form.
+	/// O(sparse targets + dense rows * states)
+	void GatherSuccessors(const TSet& sources, TSymbol symbol, TSet& set) const
+	{
+		std::vector<TState> states(sources.Count());
+		sources.ExtractTo(states.data());
+		GatherSuccessors(states.data(), states.data() + states.size(), symbol, set);
+	}
+
+	/// Check if state <param ref="target" /> is reach from state <param ref="source" /> consuming symbol <param ref="symbol" />
+	/// O(log targets)
+	bool IsSuccessor(TState source, TSymbol symbol, TState target) const
+	{
+		assert(source < States);
+		assert(target < States);
+		assert(symbol < Alphabet);
+
+		return GetSuccessors(source, symbol).Contains(target);
+	}
+
+	/// Get the source states transitioned to <param ref="target" /> consuming <param ref="symbol"/>
+	/// O(1) amortized
+	Row GetPredecessors(TState target, TSymbol symbol) const
+	{
+		assert(target < States);
+		assert(symbol < Alphabet);
+
+		Build();
+		return Predecessors.Get(static_cast<size_t>(target) * Alphabet + symbol);
+	}
+
+	/// Indicates if <param ref="state" /> is a Final State
+	/// O(1)
+	bool IsFinal(TState state) const
+	{
+		assert(state < States);
+
+		return Final.Contains(state);
+	}
+
+	/// Indicates if <param ref="state" /> is an Initial State
+	/// O(1)
+	bool IsInitial(TState state) const
+	{
+		assert(state < States);
+
+		return Initial.Contains(state);
+	}
+
+	// Inversion of each transition.
+	// Final states are converted into initial states.
+	// Initial states are converted into final states.
+	// O(edges log edges)
+	void Invert()
+	{
+		using namespace std;
+		swap(Initial, Final);
+		for(auto& e : Edges) swap(get<0>(e), get<2>(e));
+		if(Ready)
+		{
+			// Edges must stay sorted by source
+			swap(Succesors, Predecessors);
+			sort(Edges.begin(), Edges.end());
+		}
+	}
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <stdint.h>
+
+///	Fixed set of worker threads running indexed tasks.
+/// <see cref="Run" /> is a parallel for: the calling thread works too and returns when every index is done.
+/// Tasks must not throw.
+class ThreadPool
+{
+private:
+	std::vector<std::thread> workers;
+	std::mutex lock;
+	std::condition_variable wake;
+	std::condition_variable done;
+
+	/// Current job, valid while a Run is in progress
+	std::function<void(size_t)> task;
+	std::atomic<size_t> next;
+	size_t count;
+
+	/// Incremented by every Run, workers wait for a new value
+	uint64_t generation;
+	/// Workers that finished the current generation
+	size_t finished;
+	bool stopping;
+
+	void Drain()
+	{
+		for(size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) task(i);
+	}
+
+	void Work()
+	{
+		uint64_t seen = 0;
+		std::unique_lock<std::mutex> guard(lock);
+		for(;;)
+		{
+			wake.wait(guard, [&] { return stopping || generation != seen; });
+			if(stopping) return;
+			seen = generation;
+			guard.unlock();
+			Drain();
+			guard.lock();
+			// the caller waits for every worker, so none of them sees the task of a later Run late
+			if(++finished == workers.size()) done.notify_one();
+		}
+	}
+
+public:
+	/// <param ref="threads" /> counts the calling thread, one or zero means no worker
+	explicit ThreadPool(size_t threads)
+		: next(0), count(0), generation(0), finished(0), stopping(false)
+	{
+		for(size_t i=1; i<threads; i++) workers.emplace_back([this] { Work(); });
+	}
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			stopping = true;
+		}
+		wake.notify_all();
+		for(auto& w : workers) w.join();
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/// Threads running tasks, the caller included
+	size_t GetThreads() const { return workers.size() + 1; }
+
+	/// Calls <param ref="f" />(i) for every i in [0, <param ref="n" />) and waits for all of them
+	template<typename TTask>
+	void Run(size_t n, TTask f)
+	{
+		if(n == 0) return;
+		if(workers.empty() || n == 1)
+		{
+			for(size_t i=0; i<n; i++) f(i);
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			task = f;
+			count = n;
+			next = 0;
+			finished = 0;
+			generation++;
+		}
+		wake.notify_all();
+		Drain();
+		std::unique_lock<std::mutex> guard(lock);
+		done.wait(guard, [&] { return finished == workers.size(); });
+		task = nullptr;
+	}
+};
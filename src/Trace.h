@@ -0,0 +1,132 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include <vector>
+#include <iostream>
+
+/// Events reported by the minimizers to their trace policy, with up to three arguments
+enum class TraceEvent : uint8_t
+{
+	/// blocks, states
+	Initial,
+	/// block, letter
+	Splitter,
+	/// block, new block
+	Split,
+	/// p, q: equivalence test of a pair of states
+	Test,
+	/// p, q, letter: pair of successors followed by a test
+	Step,
+	/// p, q: states found equivalent and merged
+	Merge,
+	/// p, q: states found distinguishable
+	Distinct,
+	/// round, blocks
+	Round,
+	/// size, letter, size: transition between sets of states
+	Transition,
+	/// affected states, splits, merges
+	Update,
+	/// blocks, states
+	Finished,
+};
+
+inline const char* GetTraceEventName(TraceEvent e)
+{
+	static const char* const names[] = { "initial", "splitter", "split", "test", "step", "merge", "distinct", "round", "transition", "update", "finished" };
+	return names[static_cast<size_t>(e)];
+}
+
+/// Trace policy of the minimizers by default, the calls are empty and compile to nothing
+struct TraceNone
+{
+	static const bool Enabled = false;
+
+	void operator()(TraceEvent, uint64_t = 0, uint64_t = 0, uint64_t = 0)
+	{
+	}
+};
+
+/// Trace policy printing a line per event
+struct TraceConsole
+{
+	static const bool Enabled = true;
+
+	/// Output can be turned off without changing the instantiation
+	bool Show;
+
+	TraceConsole() : Show(true)
+	{
+	}
+
+	void operator()(TraceEvent e, uint64_t a = 0, uint64_t b = 0, uint64_t c = 0)
+	{
+		if(Show) std::cout << GetTraceEventName(e) << " " << a << " " << b << " " << c << std::endl;
+	}
+};
+
+/// Trace policy keeping the last <param ref="N" /> events in a ring buffer allocated once.
+/// Recording an event stores four words, there is no allocation nor output while minimizing.
+template<size_t N = 4096>
+class TraceRing
+{
+	static_assert(N > 0 && (N & (N - 1)) == 0, "the capacity must be a power of two");
+
+public:
+	static const bool Enabled = true;
+
+	struct Entry
+	{
+		TraceEvent Event;
+		uint64_t A, B, C;
+	};
+
+private:
+	std::vector<Entry> entries;
+	uint64_t count;
+
+public:
+	TraceRing() : entries(N), count(0)
+	{
+	}
+
+	void operator()(TraceEvent e, uint64_t a = 0, uint64_t b = 0, uint64_t c = 0)
+	{
+		Entry& entry = entries[count & (N - 1)];
+		entry.Event = e;
+		entry.A = a;
+		entry.B = b;
+		entry.C = c;
+		count++;
+	}
+
+	/// Events recorded since the last Clear, the older ones may have been overwritten
+	uint64_t GetCount() const { return count; }
+
+	/// Events kept
+	size_t GetSize() const { return count < N ? static_cast<size_t>(count) : N; }
+
+	/// Kept event <param ref="i" />, the oldest first
+	const Entry& operator[](size_t i) const
+	{
+		assert(i < GetSize());
+		return entries[(count - GetSize() + i) & (N - 1)];
+	}
+
+	void Clear() { count = 0; }
+
+	/// Prints the kept events, the oldest first
+	void Write(std::ostream& out) const
+	{
+		for(size_t i=0; i<GetSize(); i++)
+		{
+			const Entry& e = (*this)[i];
+			out << GetTraceEventName(e.Event) << " " << e.A << " " << e.B << " " << e.C << std::endl;
+		}
+	}
+};
+
+template<size_t N>
+const bool TraceRing<N>::Enabled;
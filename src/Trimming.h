@@ -0,0 +1,272 @@
+#pragma once
+
+#include <stdint.h>
+#include <assert.h>
+#include <vector>
+#include <tuple>
+#include <limits>
+
+/// Keeps the accessible part of a DFA, the states reached from an initial state.
+/// The accessible states not reaching a final state recognize nothing, they collapse into one non final sink
+/// numbered after the others. A complete DFA stays complete, a partial one leaves the transitions into them
+/// undefined and only keeps the sink if it is initial. The kept states preserve their relative order.
+/// O(states * alphabet)
+template<typename _TDfa>
+class DfaTrimming
+{
+public:
+	typedef _TDfa TDfa;
+	typedef typename TDfa::TState TState;
+	typedef typename TDfa::TSymbol TSymbol;
+
+	/// States removed by the last Trim
+	TState Removed;
+
+	/// State of the trimmed DFA for every state of the last input, TDfa::None if it was removed
+	std::vector<TState> Map;
+
+	DfaTrimming() : Removed(0)
+	{
+	}
+
+	TDfa Trim(const TDfa& dfa)
+	{
+		using namespace std;
+
+		const TState states = dfa.GetStates();
+		const TSymbol alpha = dfa.GetAlphabetLength();
+		vector<uint8_t> accessible(states, 0), alive(states, 0);
+		vector<TState> stack;
+
+		for(auto i=dfa.GetInitials().GetIterator(); !i.IsEnd(); i.MoveNext())
+		{
+			accessible[i.GetCurrent()] = 1;
+			stack.push_back(i.GetCurrent());
+		}
+		while(!stack.empty())
+		{
+			const TState s = stack.back();
+			stack.pop_back();
+			for(TSymbol a=0; a<alpha; a++)
+			{
+				const TState t = dfa.GetSuccessor(s, a);
+				if(t == TDfa::None || accessible[t]) continue;
+				accessible[t] = 1;
+				stack.push_back(t);
+			}
+		}
+
+		// sources of the accessible transitions of every target, the symbols do not matter
+		vector<size_t> offsets(static_cast<size_t>(states) + 1, 0);
+		for(TState s=0; s<states; s++)
+		{
+			if(!accessible[s]) continue;
+			for(TSymbol a=0; a<alpha; a++)
+			{
+				const TState t = dfa.GetSuccessor(s, a);
+				if(t != TDfa::None) offsets[t + 1]++;
+			}
+		}
+		for(TState s=0; s<states; s++) offsets[s + 1] += offsets[s];
+		vector<TState> sources(offsets[states]);
+		{
+			vector<size_t> cursor(offsets.begin(), offsets.end() - 1);
+			for(TState s=0; s<states; s++)
+			{
+				if(!accessible[s]) continue;
+				for(TSymbol a=0; a<alpha; a++)
+				{
+					const TState t = dfa.GetSuccessor(s, a);
+					if(t != TDfa::None) sources[cursor[t]++] = s;
+				}
+			}
+		}
+
+		// backwards from the accessible finals
+		for(auto i=dfa.GetFinals().GetIterator(); !i.IsEnd(); i.MoveNext())
+		{
+			if(!accessible[i.GetCurrent()]) continue;
+			alive[i.GetCurrent()] = 1;
+			stack.push_back(i.GetCurrent());
+		}
+		while(!stack.empty())
+		{
+			const TState t = stack.back();
+			stack.pop_back();
+			for(size_t j=offsets[t]; j<offsets[t + 1]; j++)
+			{
+				const TState s = sources[j];
+				if(alive[s]) continue;
+				alive[s] = 1;
+				stack.push_back(s);
+			}
+		}
+
+		Map.assign(states, TDfa::None);
+		TState kept = 0;
+		bool dead = false, dead_initial = false;
+		for(TState s=0; s<states; s++)
+		{
+			if(!accessible[s]) continue;
+			if(alive[s]) Map[s] = kept++;
+			else
+			{
+				dead = true;
+				if(dfa.IsInitial(s)) dead_initial = true;
+			}
+		}
+		const bool complete = dfa.IsComplete();
+		if(dead && (complete || dead_initial))
+		{
+			for(TState s=0; s<states; s++)
+			{
+				if(accessible[s] && !alive[s]) Map[s] = kept;
+			}
+			kept++;
+		}
+
+		// the transitions are written in place, the inverse function is built on demand
+		TDfa trimmed(alpha, kept, !complete);
+		for(TState s=0; s<states; s++)
+		{
+			if(Map[s] == TDfa::None) continue;
+			if(dfa.IsInitial(s)) trimmed.SetInitial(Map[s]);
+			if(!alive[s]) continue;
+			if(dfa.IsFinal(s)) trimmed.SetFinal(Map[s]);
+			for(TSymbol a=0; a<alpha; a++)
+			{
+				const TState t = dfa.GetSuccessor(s, a);
+				if(t == TDfa::None || Map[t] == TDfa::None) continue;
+				if(!alive[t] && !complete) continue;
+				trimmed.SetTransition(Map[s], a, Map[t]);
+			}
+		}
+		if(dead && complete)
+		{
+			for(TSymbol a=0; a<alpha; a++) trimmed.SetTransition(kept - 1, a, kept - 1);
+		}
+
+		Removed = states - kept;
+		return trimmed;
+	}
+};
+
+/// Keeps the useful part of a NFA, the states reached from an initial state and reaching a final one.
+/// An empty language keeps its initial states without transitions, the automaton is never left without a start.
+/// The kept states preserve their relative order.
+/// O(edges + states) plus the cost of enumerating the transitions of <param ref="_TNfa" />
+template<typename _TNfa>
+class NfaTrimming
+{
+public:
+	typedef _TNfa TNfa;
+	typedef typename TNfa::TState TState;
+	typedef typename TNfa::TSymbol TSymbol;
+	typedef typename TNfa::TSet TSet;
+	typedef typename TNfa::TEdge TEdge;
+
+	/// Marks a removed state in Map
+	static const TState None = std::numeric_limits<TState>::max();
+
+	/// States removed by the last Trim
+	TState Removed;
+
+	/// State of the trimmed NFA for every state of the last input, None if it was removed
+	std::vector<TState> Map;
+
+	NfaTrimming() : Removed(0)
+	{
+	}
+
+	TNfa Trim(const TNfa& nfa)
+	{
+		using namespace std;
+
+		const TState states = nfa.GetStates();
+		vector<TEdge> edges;
+		nfa.ForEachEdge([&](const TEdge& e) { edges.push_back(e); });
+
+		// neighbours of every state in both directions, the symbols do not matter
+		vector<size_t> out_offsets(static_cast<size_t>(states) + 1, 0), in_offsets(static_cast<size_t>(states) + 1, 0);
+		for(const auto& e : edges)
+		{
+			out_offsets[get<0>(e) + 1]++;
+			in_offsets[get<2>(e) + 1]++;
+		}
+		for(TState s=0; s<states; s++)
+		{
+			out_offsets[s + 1] += out_offsets[s];
+			in_offsets[s + 1] += in_offsets[s];
+		}
+		vector<TState> out_targets(edges.size()), in_sources(edges.size());
+		{
+			vector<size_t> out_cursor(out_offsets.begin(), out_offsets.end() - 1), in_cursor(in_offsets.begin(), in_offsets.end() - 1);
+			for(const auto& e : edges)
+			{
+				out_targets[out_cursor[get<0>(e)]++] = get<2>(e);
+				in_sources[in_cursor[get<2>(e)]++] = get<0>(e);
+			}
+		}
+
+		vector<uint8_t> accessible(states, 0), alive(states, 0);
+		auto reach = [&](const TSet& start, const vector<size_t>& offsets, const vector<TState>& neighbours, vector<uint8_t>& mark)
+		{
+			vector<TState> stack;
+			for(auto i=start.GetIterator(); !i.IsEnd(); i.MoveNext())
+			{
+				mark[i.GetCurrent()] = 1;
+				stack.push_back(i.GetCurrent());
+			}
+			while(!stack.empty())
+			{
+				const TState s = stack.back();
+				stack.pop_back();
+				for(size_t j=offsets[s]; j<offsets[s + 1]; j++)
+				{
+					const TState t = neighbours[j];
+					if(mark[t]) continue;
+					mark[t] = 1;
+					stack.push_back(t);
+				}
+			}
+		};
+		reach(nfa.GetInitials(), out_offsets, out_targets, accessible);
+		reach(nfa.GetFinals(), in_offsets, in_sources, alive);
+
+		Map.assign(states, None);
+		TState kept = 0;
+		for(TState s=0; s<states; s++)
+		{
+			if(accessible[s] && alive[s]) Map[s] = kept++;
+		}
+		if(kept == 0)
+		{
+			for(TState s=0; s<states; s++)
+			{
+				if(nfa.IsInitial(s)) Map[s] = kept++;
+			}
+		}
+
+		TSet initials(kept), finals(kept);
+		for(TState s=0; s<states; s++)
+		{
+			if(Map[s] == None) continue;
+			if(nfa.IsInitial(s)) initials.Add(Map[s]);
+			if(nfa.IsFinal(s)) finals.Add(Map[s]);
+		}
+		size_t count = 0;
+		for(const auto& e : edges)
+		{
+			const TState s = Map[get<0>(e)], t = Map[get<2>(e)];
+			if(s == None || t == None || !alive[get<0>(e)]) continue;
+			edges[count++] = TEdge(s, get<1>(e), t);
+		}
+		edges.resize(count);
+
+		Removed = states - kept;
+		return TNfa(nfa.GetAlphabetLength(), kept, initials, finals, std::move(edges));
+	}
+};
+
+template<typename _TNfa>
+const typename NfaTrimming<_TNfa>::TState NfaTrimming<_TNfa>::None;
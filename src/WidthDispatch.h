@@ -0,0 +1,134 @@
+#pragma once
+
+#include "FsaFormat.h"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <stdint.h>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+
+/// Number of states and symbols declared by an automaton file
+struct FsaDimensions
+{
+	uint64_t States;
+	uint64_t Symbols;
+
+	FsaDimensions(uint64_t states, uint64_t symbols)
+		: States(states), Symbols(symbols)
+	{
+	}
+};
+
+/// Widest of two unsigned integer types
+template<typename A, typename B>
+struct WidestOf
+{
+	typedef typename std::conditional<(sizeof(A) >= sizeof(B)), A, B>::type type;
+};
+
+///	Instantiates the automata and algorithms with the narrowest unsigned integer types
+/// able to number the states and symbols of an input, chosen at run time among 8, 16, 32 and 64 bits.
+/// Small automata get denser tables and sets, big ones get types wide enough to hold them.
+/// The visitor has a member template Run<TState, TSymbol>() returning int, it is called once with the chosen types.
+/// As in the readers and containers, a type T holds counts below its maximum value.
+class WidthDispatch
+{
+public:
+	template<typename T>
+	static bool Fits(uint64_t count)
+	{
+		return count < std::numeric_limits<T>::max();
+	}
+
+	/// Bits of the narrowest type holding <param ref="count" />, never below <param ref="min_bits" />
+	static unsigned BitsFor(uint64_t count, unsigned min_bits = 8)
+	{
+		unsigned bits = 64;
+		if(Fits<uint8_t>(count)) bits = 8;
+		else if(Fits<uint16_t>(count)) bits = 16;
+		else if(Fits<uint32_t>(count)) bits = 32;
+		return std::max(bits, min_bits);
+	}
+
+	/// Calls Run<TState, TSymbol>() of <param ref="visitor" /> with the narrowest types for <param ref="states" /> and <param ref="symbols" />.
+	/// <param ref="min_state_bits" /> raises the state type for algorithms creating more states than they read.
+	template<typename TVisitor>
+	static int Dispatch(uint64_t states, uint64_t symbols, TVisitor& visitor, unsigned min_state_bits = 8)
+	{
+		switch(BitsFor(states, min_state_bits))
+		{
+		case 8: return DispatchSymbol<uint8_t>(symbols, visitor);
+		case 16: return DispatchSymbol<uint16_t>(symbols, visitor);
+		case 32: return DispatchSymbol<uint32_t>(symbols, visitor);
+		default: return DispatchSymbol<uint64_t>(symbols, visitor);
+		}
+	}
+
+	/// Reads the number of states and symbols of <param ref="file" /> without loading its transitions
+	static FsaDimensions Peek(const std::string& file, FsaFormat format)
+	{
+		using namespace std;
+
+		if(format == FsaFormat::AlmeidaPlainTextReader)
+		{
+			// dimensions are part of the name, "<name>.n<states>k<symbols>"
+			auto dot = file.find_last_of('.');
+			if(dot == string::npos || dot + 1 >= file.size() || file[dot + 1] != 'n') throw invalid_argument("Nombre de archivo Almeida invalido");
+			string ext(file.begin() + dot + 2, file.end());
+			vector<string> vc;
+			boost::split(vc, ext, boost::is_any_of("nk"), boost::algorithm::token_compress_on);
+			if(vc.size() != 2) throw invalid_argument("Nombre de archivo Almeida invalido");
+			return FsaDimensions(boost::lexical_cast<uint64_t>(vc[0]), boost::lexical_cast<uint64_t>(vc[1]));
+		}
+
+		if(format != FsaFormat::ZeroBasedPlainText && format != FsaFormat::OneBasedPlainText)
+		{
+			throw invalid_argument("unsupported format");
+		}
+
+		ifstream str(file);
+		if(!str.is_open()) throw invalid_argument("Error opening file " + file);
+
+		string line;
+		getline(str, line);
+		if(line.empty() || line[0] != '#') throw invalid_argument("Formato invalido");
+		getline(str, line);
+		uint64_t states = stoull(line);
+
+		getline(str, line);
+		if(line.empty() || line[0] != '#') throw invalid_argument("Formato invalido");
+		getline(str, line);
+		uint64_t symbols;
+		if(format == FsaFormat::ZeroBasedPlainText)
+		{
+			symbols = stoull(line);
+		}
+		else
+		{
+			// one based files list the symbols
+			vector<string> col;
+			boost::trim(line);
+			boost::split(col, line, boost::is_space(), boost::algorithm::token_compress_on);
+			symbols = col.size();
+		}
+		return FsaDimensions(states, symbols);
+	}
+
+private:
+	template<typename TState, typename TVisitor>
+	static int DispatchSymbol(uint64_t symbols, TVisitor& visitor)
+	{
+		switch(BitsFor(symbols))
+		{
+		case 8: return visitor.template Run<TState, uint8_t>();
+		case 16: return visitor.template Run<TState, uint16_t>();
+		case 32: return visitor.template Run<TState, uint32_t>();
+		default: return visitor.template Run<TState, uint64_t>();
+		}
+	}
+};
@@ -0,0 +1,182 @@
+#include "../Set.h"
+#include "../Nfa.h"
+#include "../Dfa.h"
+#include "../NfaGenerator.h"
+#include "../Determinization.h"
+#include "../bitset_kernels.h"
+#include <boost/timer/timer.hpp>
+#include <boost/format.hpp>
+#include <boost/program_options.hpp>
+#include <random>
+#include <vector>
+#include <string>
+#include <iostream>
+
+namespace bitset_benchmark
+{
+	using namespace std;
+	using namespace boost::program_options;
+	using boost::timer::cpu_timer;
+	using boost::format;
+
+	class Options
+	{
+	public:
+		uint32_t Bits;
+		uint32_t Sets;
+		uint32_t Rounds;
+		uint32_t NfaStates;
+		bool ShowHelp;
+
+		Options() : Bits(16384), Sets(256), Rounds(200), NfaStates(0), ShowHelp(false)
+		{
+		}
+	};
+
+	typedef BitSet<uint32_t> TSet;
+
+	/// Runs every kernel over random sets and returns a checksum so the work is not discarded
+	size_t RunKernels(const Options& opt, const vector<TSet>& sets, const string& name)
+	{
+		size_t checksum = 0;
+		TSet acc(opt.Bits);
+		// none and equal stop at the first difference, their worst case scans everything
+		const TSet empty(opt.Bits);
+		const vector<TSet> copies(sets);
+		cpu_timer timer;
+
+		auto report = [&](const char* kernel, double bytes)
+		{
+			timer.stop();
+			double seconds = timer.elapsed().wall / 1e9;
+			cout << format("%-8s %-10s %10.3f ms %8.2f GB/s") % name % kernel % (seconds * 1e3) % (bytes / seconds / 1e9) << endl;
+		};
+
+		const double set_bytes = opt.Bits / 8.0;
+		const double pass = set_bytes * sets.size() * opt.Rounds;
+
+		timer.start();
+		for(uint32_t r=0; r<opt.Rounds; r++) for(const auto& s : sets) acc.UnionWith(s);
+		checksum += acc.Count();
+		report("union", 2 * pass);
+
+		timer.start();
+		for(uint32_t r=0; r<opt.Rounds; r++) checksum += acc.UnionOf(sets.begin(), sets.end(), true);
+		report("union_many", pass);
+
+		timer.start();
+		for(uint32_t r=0; r<opt.Rounds; r++) for(const auto& s : sets) { acc.UnionWith(s); acc.IntersectWith(s); }
+		checksum += acc.Count();
+		report("intersect", 4 * pass);
+
+		timer.start();
+		for(uint32_t r=0; r<opt.Rounds; r++) for(const auto& s : sets) acc.DifferenceWith(s);
+		checksum += acc.Count();
+		report("difference", 2 * pass);
+
+		timer.start();
+		for(uint32_t r=0; r<opt.Rounds; r++) for(size_t i=0; i<sets.size(); i++) checksum += empty.IsEmpty() ? 1 : 0;
+		report("none", pass);
+
+		timer.start();
+		for(uint32_t r=0; r<opt.Rounds; r++) for(const auto& s : sets) checksum += s.Count();
+		report("count", pass);
+
+		timer.start();
+		for(uint32_t r=0; r<opt.Rounds; r++) for(size_t i=0; i<sets.size(); i++) checksum += sets[i] == copies[i] ? 1 : 0;
+		report("equal", 2 * pass);
+
+		timer.start();
+		for(uint32_t r=0; r<opt.Rounds; r++) for(const auto& s : sets) for(auto i=s.GetIterator(); !i.IsEnd(); i.MoveNext()) checksum += i.GetCurrent();
+		report("iterate", pass);
+
+		vector<uint32_t> elements(opt.Bits);
+		timer.start();
+		for(uint32_t r=0; r<opt.Rounds; r++) for(const auto& s : sets) checksum += elements[s.ExtractTo(elements.data()) / 2];
+		report("extract", pass);
+
+		return checksum;
+	}
+
+	/// Subset construction on a random NFA, dominated by successor unions and set hashing
+	void RunDeterminization(const Options& opt, const string& name)
+	{
+		typedef Nfa<uint32_t, uint8_t> TNfa;
+		typedef Dfa<uint32_t, uint8_t> TDfa;
+		mt19937 gen(opt.NfaStates);
+		NfaGenerator<TNfa, mt19937> nfagen;
+		TNfa nfa = nfagen.Generate(opt.NfaStates, 2, 1, 1, 0.0005f, gen);
+		Determinization<TDfa, TNfa> det;
+		TDfa::TState states;
+		Determinization<TDfa, TNfa>::TVectorDfaState finals;
+		Determinization<TDfa, TNfa>::TVectorDfaEdge edges;
+		cpu_timer timer;
+		det.Determinize(nfa, &states, finals, edges);
+		timer.stop();
+		cout << format("%-8s %-10s %10.3f ms %8u states") % name % "determinize" % (timer.elapsed().wall / 1e6) % states << endl;
+	}
+
+	void Run(const Options& opt)
+	{
+		mt19937 gen(1);
+		uniform_int_distribution<uint32_t> bit_dist(0, opt.Bits - 1);
+		vector<TSet> sets(opt.Sets, TSet(opt.Bits));
+		for(auto& s : sets)
+		{
+			for(uint32_t i=0; i<opt.Bits/8; i++) s.Add(bit_dist(gen));
+		}
+
+		cout << "Widest supported kernels: " << bitset_kernels::get_table(bitset_kernels::supported()).name << endl;
+		size_t checksum = 0;
+		const bitset_isa isas[] = { bitset_isa::scalar, bitset_isa::avx2, bitset_isa::avx512 };
+		for(auto isa : isas)
+		{
+			if(!bitset_kernels::select(isa)) continue;
+			string name = bitset_kernels::active().name;
+			checksum += RunKernels(opt, sets, name);
+			if(opt.NfaStates > 0) RunDeterminization(opt, name);
+		}
+		bitset_kernels::select(bitset_kernels::supported());
+		cout << "checksum " << checksum << endl;
+	}
+}
+
+using namespace bitset_benchmark;
+
+int main(int argc, char** argv)
+{
+	Options o;
+	options_description opt_desc("Allowed options");
+	opt_desc.add_options()
+		("help,?", bool_switch(&o.ShowHelp)->default_value(false), "Show this information")
+		("bits,b", value(&o.Bits)->default_value(o.Bits), "Bits per set")
+		("sets,n", value(&o.Sets)->default_value(o.Sets), "Number of random sets")
+		("rounds,r", value(&o.Rounds)->default_value(o.Rounds), "Passes over the sets per kernel")
+		("nfa,d", value(&o.NfaStates)->default_value(o.NfaStates), "States of a random NFA to determinize, zero skips it")
+		;
+
+	variables_map vm;
+	command_line_parser parser(argc, argv);
+	auto po = parser.options(opt_desc).run();
+	store(po, vm);
+	notify(vm);
+
+	if(o.ShowHelp)
+	{
+		cout << opt_desc << endl;
+		return 0;
+	}
+
+	try
+	{
+		if(o.Bits == 0) throw invalid_argument("bits must be positive");
+		Run(o);
+	}
+	catch(exception ex)
+	{
+		cout << "Error: " << ex.what() << endl;
+		return -1;
+	}
+
+	return 0;
+}
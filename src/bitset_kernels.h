@@ -0,0 +1,624 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#define BITSET_KERNELS_X86 1
+#define BITSET_KERNELS_TARGET(isa)
+#include <intrin.h>
+#include <immintrin.h>
+#elif defined(__GNUC__) && defined(__x86_64__)
+#define BITSET_KERNELS_X86 1
+#define BITSET_KERNELS_TARGET(isa) __attribute__((target(isa)))
+#include <cpuid.h>
+#include <immintrin.h>
+#else
+#define BITSET_KERNELS_X86 0
+#endif
+
+#if BITSET_KERNELS_X86
+#define BITSET_KERNELS_PREFETCH(p) _mm_prefetch(reinterpret_cast<const char*>(p), _MM_HINT_T0)
+#elif defined(__GNUC__)
+#define BITSET_KERNELS_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define BITSET_KERNELS_PREFETCH(p)
+#endif
+
+/// Instruction sets with kernels, ordered from the most portable
+enum class bitset_isa
+{
+	scalar,
+	avx2,
+	avx512
+};
+
+/// Kernels over arrays of 64-bit blocks used by dynamic_bitset.
+/// The implementation is selected once from cpuid, the scalar one is always available.
+/// Every kernel accepts unaligned arrays of any length.
+struct bitset_kernels
+{
+	typedef void (*binary_kernel)(uint64_t* dst, const uint64_t* src, size_t n);
+	typedef bool (*none_kernel)(const uint64_t* src, size_t n);
+	typedef size_t (*count_kernel)(const uint64_t* src, size_t n);
+	typedef bool (*equal_kernel)(const uint64_t* a, const uint64_t* b, size_t n);
+	/// dst = (accumulate ? dst : 0) | srcs[0] | ... | srcs[k-1], returns the popcount of dst if count is set
+	typedef size_t (*union_many_kernel)(uint64_t* dst, const uint64_t* const* srcs, size_t k, size_t n, bool accumulate, bool count);
+	/// Writes base + index of every set bit of src into out in increasing order, returns how many were written
+	typedef size_t (*extract_kernel)(const uint64_t* src, size_t n, uint32_t base, uint32_t* out);
+
+	/// Blocks combined across every input per step of union_many, one cache line
+	static const size_t column = 8;
+
+	/// Columns prefetched ahead on each input by union_many
+	static const size_t prefetch_distance = 4;
+
+	struct table
+	{
+		bitset_isa isa;
+		const char* name;
+		binary_kernel union_with;
+		binary_kernel intersect_with;
+		binary_kernel difference_with;
+		none_kernel none;
+		count_kernel count;
+		equal_kernel equal;
+		union_many_kernel union_many;
+		extract_kernel extract;
+	};
+
+	// scalar
+
+	static void scalar_union(uint64_t* dst, const uint64_t* src, size_t n)
+	{
+		for(size_t i=0; i<n; i++) dst[i] |= src[i];
+	}
+
+	static void scalar_intersect(uint64_t* dst, const uint64_t* src, size_t n)
+	{
+		for(size_t i=0; i<n; i++) dst[i] &= src[i];
+	}
+
+	static void scalar_difference(uint64_t* dst, const uint64_t* src, size_t n)
+	{
+		for(size_t i=0; i<n; i++) dst[i] &= ~src[i];
+	}
+
+	static bool scalar_none(const uint64_t* src, size_t n)
+	{
+		for(size_t i=0; i<n; i++) if(src[i]) return false;
+		return true;
+	}
+
+	static size_t scalar_popcnt(uint64_t x)
+	{
+		// SWAR population count
+		x = x - ((x >> 1) & 0x5555555555555555ULL);
+		x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+		x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+		return static_cast<size_t>((x * 0x0101010101010101ULL) >> 56);
+	}
+
+	/// Index of the lowest set bit, <param ref="x" /> must not be zero
+	static uint32_t scalar_ctz(uint64_t x)
+	{
+#if defined(__GNUC__)
+		return static_cast<uint32_t>(__builtin_ctzll(x));
+#elif defined(_MSC_VER) && defined(_M_X64)
+		unsigned long i;
+		_BitScanForward64(&i, x);
+		return static_cast<uint32_t>(i);
+#else
+		// isolate the lowest bit and count the ones below it
+		return static_cast<uint32_t>(scalar_popcnt((x & (0 - x)) - 1));
+#endif
+	}
+
+	static size_t scalar_count(const uint64_t* src, size_t n)
+	{
+		size_t c = 0;
+		for(size_t i=0; i<n; i++) c += scalar_popcnt(src[i]);
+		return c;
+	}
+
+	static bool scalar_equal(const uint64_t* a, const uint64_t* b, size_t n)
+	{
+		for(size_t i=0; i<n; i++) if(a[i] != b[i]) return false;
+		return true;
+	}
+
+	/// union_many over blocks [begin, n), the accumulator of each column lives in registers
+	static size_t scalar_union_columns(uint64_t* dst, const uint64_t* const* srcs, size_t k, size_t begin, size_t n, bool accumulate, bool count)
+	{
+		size_t c = 0;
+		size_t j = begin;
+		for(; j+column<=n; j+=column)
+		{
+			const bool ahead = j + prefetch_distance * column < n;
+			uint64_t acc[column];
+			for(size_t i=0; i<column; i++) acc[i] = accumulate ? dst[j + i] : 0;
+			for(size_t s=0; s<k; s++)
+			{
+				const uint64_t* row = srcs[s] + j;
+				if(ahead) BITSET_KERNELS_PREFETCH(row + prefetch_distance * column);
+				for(size_t i=0; i<column; i++) acc[i] |= row[i];
+			}
+			for(size_t i=0; i<column; i++) dst[j + i] = acc[i];
+			if(count) for(size_t i=0; i<column; i++) c += scalar_popcnt(acc[i]);
+		}
+		// partial column, one block at a time
+		for(; j<n; j++)
+		{
+			uint64_t b = accumulate ? dst[j] : 0;
+			for(size_t s=0; s<k; s++) b |= srcs[s][j];
+			dst[j] = b;
+			if(count) c += scalar_popcnt(b);
+		}
+		return c;
+	}
+
+	static size_t scalar_union_many(uint64_t* dst, const uint64_t* const* srcs, size_t k, size_t n, bool accumulate, bool count)
+	{
+		return scalar_union_columns(dst, srcs, k, 0, n, accumulate, count);
+	}
+
+	/// One tzcnt and one blsr (x & x - 1) per element
+	static size_t scalar_extract(const uint64_t* src, size_t n, uint32_t base, uint32_t* out)
+	{
+		uint32_t* const first = out;
+		for(size_t i=0; i<n; i++, base+=64)
+		{
+			for(uint64_t w = src[i]; w; w &= w - 1) *out++ = base + scalar_ctz(w);
+		}
+		return static_cast<size_t>(out - first);
+	}
+
+#if BITSET_KERNELS_X86
+
+	// AVX2, 4 blocks per vector
+
+	BITSET_KERNELS_TARGET("avx2")
+	static void avx2_union(uint64_t* dst, const uint64_t* src, size_t n)
+	{
+		size_t i = 0;
+		for(; i+4<=n; i+=4)
+		{
+			__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+			__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_or_si256(a, b));
+		}
+		for(; i<n; i++) dst[i] |= src[i];
+	}
+
+	BITSET_KERNELS_TARGET("avx2")
+	static void avx2_intersect(uint64_t* dst, const uint64_t* src, size_t n)
+	{
+		size_t i = 0;
+		for(; i+4<=n; i+=4)
+		{
+			__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+			__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_and_si256(a, b));
+		}
+		for(; i<n; i++) dst[i] &= src[i];
+	}
+
+	BITSET_KERNELS_TARGET("avx2")
+	static void avx2_difference(uint64_t* dst, const uint64_t* src, size_t n)
+	{
+		size_t i = 0;
+		for(; i+4<=n; i+=4)
+		{
+			__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+			__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+			// andnot computes ~b & a
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_andnot_si256(b, a));
+		}
+		for(; i<n; i++) dst[i] &= ~src[i];
+	}
+
+	BITSET_KERNELS_TARGET("avx2")
+	static bool avx2_none(const uint64_t* src, size_t n)
+	{
+		size_t i = 0;
+		for(; i+4<=n; i+=4)
+		{
+			__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+			if(!_mm256_testz_si256(a, a)) return false;
+		}
+		for(; i<n; i++) if(src[i]) return false;
+		return true;
+	}
+
+	/// Wojciech Mula, Nathan Kurz, Daniel Lemire (2018)
+	/// "Faster Population Counts Using AVX2 Instructions", nibble lookup variant
+	BITSET_KERNELS_TARGET("avx2")
+	static size_t avx2_count(const uint64_t* src, size_t n)
+	{
+		const __m256i lookup = _mm256_setr_epi8(
+			0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+			0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+		const __m256i low_mask = _mm256_set1_epi8(0x0f);
+		__m256i acc = _mm256_setzero_si256();
+		size_t i = 0;
+		for(; i+4<=n; i+=4)
+		{
+			__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+			__m256i lo = _mm256_and_si256(v, low_mask);
+			__m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+			__m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+			acc = _mm256_add_epi64(acc, _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+		}
+		size_t c = static_cast<size_t>(_mm256_extract_epi64(acc, 0)) + static_cast<size_t>(_mm256_extract_epi64(acc, 1))
+			+ static_cast<size_t>(_mm256_extract_epi64(acc, 2)) + static_cast<size_t>(_mm256_extract_epi64(acc, 3));
+		for(; i<n; i++) c += scalar_popcnt(src[i]);
+		return c;
+	}
+
+	BITSET_KERNELS_TARGET("avx2")
+	static bool avx2_equal(const uint64_t* a, const uint64_t* b, size_t n)
+	{
+		size_t i = 0;
+		for(; i+4<=n; i+=4)
+		{
+			__m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+			__m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+			__m256i d = _mm256_xor_si256(x, y);
+			if(!_mm256_testz_si256(d, d)) return false;
+		}
+		for(; i<n; i++) if(a[i] != b[i]) return false;
+		return true;
+	}
+
+	BITSET_KERNELS_TARGET("avx2")
+	static size_t avx2_union_many(uint64_t* dst, const uint64_t* const* srcs, size_t k, size_t n, bool accumulate, bool count)
+	{
+		size_t j = 0;
+		for(; j+column<=n; j+=column)
+		{
+			const bool ahead = j + prefetch_distance * column < n;
+			__m256i a0 = _mm256_setzero_si256();
+			__m256i a1 = _mm256_setzero_si256();
+			if(accumulate)
+			{
+				a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + j));
+				a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + j + 4));
+			}
+			for(size_t s=0; s<k; s++)
+			{
+				const uint64_t* row = srcs[s] + j;
+				if(ahead) BITSET_KERNELS_PREFETCH(row + prefetch_distance * column);
+				a0 = _mm256_or_si256(a0, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row)));
+				a1 = _mm256_or_si256(a1, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + 4)));
+			}
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + j), a0);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + j + 4), a1);
+		}
+		// dst was just written, counting it now hits cache
+		const size_t c = count ? avx2_count(dst, j) : 0;
+		return c + scalar_union_columns(dst, srcs, k, j, n, accumulate, count);
+	}
+
+	/// Indexes of the set bits of every byte value, packed one per byte
+	static const uint64_t* byte_positions()
+	{
+		struct lookup
+		{
+			uint64_t positions[256];
+			lookup()
+			{
+				for(unsigned b=0; b<256; b++)
+				{
+					uint64_t p = 0;
+					unsigned c = 0;
+					for(unsigned i=0; i<8; i++) if(b & (1u << i)) p |= static_cast<uint64_t>(i) << (8 * c++);
+					positions[b] = p;
+				}
+			}
+		};
+		static const lookup table;
+		return table.positions;
+	}
+
+	/// Daniel Lemire, "Decoding billions of integers per second through vectorization".
+	/// Every byte of a block is decoded with one lookup widened to 8 lanes,
+	/// a masked store writes only the set bits so out needs no room past the last element.
+	BITSET_KERNELS_TARGET("avx2,bmi,popcnt")
+	static size_t avx2_extract(const uint64_t* src, size_t n, uint32_t base, uint32_t* out)
+	{
+		uint32_t* const first = out;
+		const uint64_t* positions = byte_positions();
+		const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		for(size_t i=0; i<n; i++, base+=64)
+		{
+			uint64_t w = src[i];
+			if(_mm_popcnt_u32(static_cast<uint32_t>(w)) + _mm_popcnt_u32(static_cast<uint32_t>(w >> 32)) < 8)
+			{
+				for(; w; w &= w - 1) *out++ = base + scalar_ctz(w);
+				continue;
+			}
+			for(uint32_t j=0; j<64; j+=8, w>>=8)
+			{
+				const uint32_t b = static_cast<uint32_t>(w & 0xff);
+				const int c = static_cast<int>(_mm_popcnt_u32(b));
+				const __m256i idx = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128(static_cast<long long>(positions[b])));
+				const __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(c), lanes);
+				_mm256_maskstore_epi32(reinterpret_cast<int*>(out), mask, _mm256_add_epi32(idx, _mm256_set1_epi32(static_cast<int>(base + j))));
+				out += c;
+			}
+		}
+		return static_cast<size_t>(out - first);
+	}
+
+	// AVX-512, 8 blocks per vector, tails use masked loads
+
+	static __mmask8 avx512_tail(size_t n)
+	{
+		return static_cast<__mmask8>((1u << n) - 1);
+	}
+
+	BITSET_KERNELS_TARGET("avx512f")
+	static void avx512_union(uint64_t* dst, const uint64_t* src, size_t n)
+	{
+		size_t i = 0;
+		for(; i+8<=n; i+=8)
+		{
+			__m512i a = _mm512_loadu_si512(dst + i);
+			__m512i b = _mm512_loadu_si512(src + i);
+			_mm512_storeu_si512(dst + i, _mm512_or_si512(a, b));
+		}
+		if(i < n)
+		{
+			__mmask8 m = avx512_tail(n - i);
+			__m512i a = _mm512_maskz_loadu_epi64(m, dst + i);
+			__m512i b = _mm512_maskz_loadu_epi64(m, src + i);
+			_mm512_mask_storeu_epi64(dst + i, m, _mm512_or_si512(a, b));
+		}
+	}
+
+	BITSET_KERNELS_TARGET("avx512f")
+	static void avx512_intersect(uint64_t* dst, const uint64_t* src, size_t n)
+	{
+		size_t i = 0;
+		for(; i+8<=n; i+=8)
+		{
+			__m512i a = _mm512_loadu_si512(dst + i);
+			__m512i b = _mm512_loadu_si512(src + i);
+			_mm512_storeu_si512(dst + i, _mm512_and_si512(a, b));
+		}
+		if(i < n)
+		{
+			__mmask8 m = avx512_tail(n - i);
+			__m512i a = _mm512_maskz_loadu_epi64(m, dst + i);
+			__m512i b = _mm512_maskz_loadu_epi64(m, src + i);
+			_mm512_mask_storeu_epi64(dst + i, m, _mm512_and_si512(a, b));
+		}
+	}
+
+	BITSET_KERNELS_TARGET("avx512f")
+	static void avx512_difference(uint64_t* dst, const uint64_t* src, size_t n)
+	{
+		size_t i = 0;
+		for(; i+8<=n; i+=8)
+		{
+			__m512i a = _mm512_loadu_si512(dst + i);
+			__m512i b = _mm512_loadu_si512(src + i);
+			_mm512_storeu_si512(dst + i, _mm512_andnot_si512(b, a));
+		}
+		if(i < n)
+		{
+			__mmask8 m = avx512_tail(n - i);
+			__m512i a = _mm512_maskz_loadu_epi64(m, dst + i);
+			__m512i b = _mm512_maskz_loadu_epi64(m, src + i);
+			_mm512_mask_storeu_epi64(dst + i, m, _mm512_andnot_si512(b, a));
+		}
+	}
+
+	BITSET_KERNELS_TARGET("avx512f")
+	static bool avx512_none(const uint64_t* src, size_t n)
+	{
+		size_t i = 0;
+		for(; i+8<=n; i+=8)
+		{
+			__m512i a = _mm512_loadu_si512(src + i);
+			if(_mm512_test_epi64_mask(a, a)) return false;
+		}
+		if(i < n)
+		{
+			__m512i a = _mm512_maskz_loadu_epi64(avx512_tail(n - i), src + i);
+			if(_mm512_test_epi64_mask(a, a)) return false;
+		}
+		return true;
+	}
+
+	BITSET_KERNELS_TARGET("avx512f,avx512vpopcntdq")
+	static size_t avx512_count(const uint64_t* src, size_t n)
+	{
+		__m512i acc = _mm512_setzero_si512();
+		size_t i = 0;
+		for(; i+8<=n; i+=8)
+		{
+			acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_loadu_si512(src + i)));
+		}
+		if(i < n)
+		{
+			__m512i a = _mm512_maskz_loadu_epi64(avx512_tail(n - i), src + i);
+			acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(a));
+		}
+		return static_cast<size_t>(_mm512_reduce_add_epi64(acc));
+	}
+
+	BITSET_KERNELS_TARGET("avx512f")
+	static bool avx512_equal(const uint64_t* a, const uint64_t* b, size_t n)
+	{
+		size_t i = 0;
+		for(; i+8<=n; i+=8)
+		{
+			__m512i x = _mm512_loadu_si512(a + i);
+			__m512i y = _mm512_loadu_si512(b + i);
+			if(_mm512_cmpneq_epi64_mask(x, y)) return false;
+		}
+		if(i < n)
+		{
+			__mmask8 m = avx512_tail(n - i);
+			__m512i x = _mm512_maskz_loadu_epi64(m, a + i);
+			__m512i y = _mm512_maskz_loadu_epi64(m, b + i);
+			if(_mm512_cmpneq_epi64_mask(x, y)) return false;
+		}
+		return true;
+	}
+
+	BITSET_KERNELS_TARGET("avx512f,avx512vpopcntdq")
+	static size_t avx512_union_many(uint64_t* dst, const uint64_t* const* srcs, size_t k, size_t n, bool accumulate, bool count)
+	{
+		__m512i cnt = _mm512_setzero_si512();
+		for(size_t j=0; j<n; j+=column)
+		{
+			const __mmask8 m = n - j < column ? avx512_tail(n - j) : static_cast<__mmask8>(0xff);
+			const bool ahead = j + prefetch_distance * column < n;
+			__m512i a = accumulate ? _mm512_maskz_loadu_epi64(m, dst + j) : _mm512_setzero_si512();
+			for(size_t s=0; s<k; s++)
+			{
+				const uint64_t* row = srcs[s] + j;
+				if(ahead) BITSET_KERNELS_PREFETCH(row + prefetch_distance * column);
+				a = _mm512_or_si512(a, _mm512_maskz_loadu_epi64(m, row));
+			}
+			_mm512_mask_storeu_epi64(dst + j, m, a);
+			if(count) cnt = _mm512_add_epi64(cnt, _mm512_popcnt_epi64(a));
+		}
+		return static_cast<size_t>(_mm512_reduce_add_epi64(cnt));
+	}
+
+	/// Blocks are decoded 16 bits at a time, vpcompressd packs the indexes of the set bits
+	/// and a masked store writes only them, so out needs no room past the last element.
+	/// Blocks with few bits use the scalar loop.
+	BITSET_KERNELS_TARGET("avx512f,bmi,popcnt")
+	static size_t avx512_extract(const uint64_t* src, size_t n, uint32_t base, uint32_t* out)
+	{
+		uint32_t* const first = out;
+		const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+		const __m512i step = _mm512_set1_epi32(16);
+		for(size_t i=0; i<n; i++, base+=64)
+		{
+			const uint64_t w = src[i];
+			if(!w) continue;
+			const uint32_t lo = static_cast<uint32_t>(w), hi = static_cast<uint32_t>(w >> 32);
+			if(_mm_popcnt_u32(lo) + _mm_popcnt_u32(hi) < 8)
+			{
+				for(uint64_t b = w; b; b &= b - 1) *out++ = base + scalar_ctz(b);
+				continue;
+			}
+			__m512i idx = _mm512_add_epi32(_mm512_set1_epi32(static_cast<int>(base)), lanes);
+			for(int j=0; j<4; j++, idx=_mm512_add_epi32(idx, step))
+			{
+				const __mmask16 m = static_cast<__mmask16>(w >> (16 * j));
+				const unsigned c = _mm_popcnt_u32(m);
+				_mm512_mask_storeu_epi32(out, static_cast<__mmask16>((1u << c) - 1), _mm512_maskz_compress_epi32(m, idx));
+				out += c;
+			}
+		}
+		return static_cast<size_t>(out - first);
+	}
+
+	// cpuid
+
+	static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+	{
+#ifdef _MSC_VER
+		int r[4];
+		__cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+		for(int i=0; i<4; i++) regs[i] = static_cast<uint32_t>(r[i]);
+#else
+		unsigned int a = 0, b = 0, c = 0, d = 0;
+		if(!__get_cpuid_count(leaf, subleaf, &a, &b, &c, &d)) a = b = c = d = 0;
+		regs[0] = a; regs[1] = b; regs[2] = c; regs[3] = d;
+#endif
+	}
+
+	/// OS enabled register state (XCR0)
+	static uint64_t xgetbv0()
+	{
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		uint32_t lo, hi;
+		__asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+		return (static_cast<uint64_t>(hi) << 32) | lo;
+#endif
+	}
+
+	/// Finds the widest instruction set supported by the CPU and enabled by the OS
+	static bitset_isa detect()
+	{
+		uint32_t r[4];
+		cpuid(0, 0, r);
+		const uint32_t max_leaf = r[0];
+		if(max_leaf < 7) return bitset_isa::scalar;
+
+		cpuid(1, 0, r);
+		const bool osxsave = (r[2] & (1u << 27)) != 0;
+		if(!osxsave) return bitset_isa::scalar;
+		const uint64_t xcr0 = xgetbv0();
+		const bool ymm = (xcr0 & 0x6) == 0x6;
+		const bool zmm = (xcr0 & 0xe6) == 0xe6;
+
+		cpuid(7, 0, r);
+		const bool bmi = (r[1] & (1u << 3)) != 0;
+		const bool avx2 = (r[1] & (1u << 5)) != 0;
+		const bool avx512f = (r[1] & (1u << 16)) != 0;
+		const bool vpopcntdq = (r[2] & (1u << 14)) != 0;
+
+		if(zmm && avx512f && vpopcntdq && bmi) return bitset_isa::avx512;
+		if(ymm && avx2 && bmi) return bitset_isa::avx2;
+		return bitset_isa::scalar;
+	}
+
+#else
+
+	static bitset_isa detect()
+	{
+		return bitset_isa::scalar;
+	}
+
+#endif
+
+	static const table& get_table(bitset_isa isa)
+	{
+		static const table scalar_table = { bitset_isa::scalar, "scalar", scalar_union, scalar_intersect, scalar_difference, scalar_none, scalar_count, scalar_equal, scalar_union_many, scalar_extract };
+#if BITSET_KERNELS_X86
+		static const table avx2_table = { bitset_isa::avx2, "avx2", avx2_union, avx2_intersect, avx2_difference, avx2_none, avx2_count, avx2_equal, avx2_union_many, avx2_extract };
+		static const table avx512_table = { bitset_isa::avx512, "avx512", avx512_union, avx512_intersect, avx512_difference, avx512_none, avx512_count, avx512_equal, avx512_union_many, avx512_extract };
+		if(isa == bitset_isa::avx512) return avx512_table;
+		if(isa == bitset_isa::avx2) return avx2_table;
+#endif
+		return scalar_table;
+	}
+
+	/// Widest instruction set available on this machine
+	static bitset_isa supported()
+	{
+		static const bitset_isa isa = detect();
+		return isa;
+	}
+
+	static const table*& active_slot()
+	{
+		static const table* slot = &get_table(supported());
+		return slot;
+	}
+
+	/// Kernels in use, the widest supported ones by default
+	static const table& active()
+	{
+		return *active_slot();
+	}
+
+	/// Forces an instruction set, returns false if this machine does not support it.
+	/// Not thread safe, call it before using bitsets from several threads.
+	static bool select(bitset_isa isa)
+	{
+		if(isa > supported()) return false;
+		active_slot() = &get_table(isa);
+		return true;
+	}
+};
@@ -1,11 +1,14 @@
 // August 2013, Jairo Andres Velasco Romero, jairov(at)javerianacali.edu.co
 #include "../Dfa.h"
-#include "../Nfa.h"
+#include "../SparseNfa.h"
+#include "../CompressedSet.h"
 #include "../FsaGraphVizWriter.h"
 #include "../FsaPlainTextReader.h"
 #include "../FsaPlainTextWriter.h"
 #include "../FsaFormat.h"
 #include "../Determinization.h"
+#include "../WidthDispatch.h"
+#include "../Trimming.h"
 #include <fstream>
 #include <boost/timer/timer.hpp>
 #include <boost/format.hpp>
@@ -25,19 +28,17 @@ namespace determinize
 		FsaFormat Format;
 		bool ShowHelp;
 		bool Verbose;
+		bool Compressed;
+		bool Trim;
 
-		Options() : Verbose(false), ShowHelp(false), Format(FsaFormat::ZeroBasedPlainText)
+		Options() : Verbose(false), ShowHelp(false), Compressed(false), Trim(false), Format(FsaFormat::ZeroBasedPlainText)
 		{
 		}
 	};
 
+	template<typename TNfa, typename TDfa>
 	void Convert(const Options& opt)
 	{
-		typedef uint32_t TState;
-		typedef uint8_t TSymbol;
-		typedef Dfa<TState, TSymbol> TDfa;
-		typedef Nfa<TState, TSymbol> TNfa;
-				
 		ifstream ifs(opt.InputFile);
 		if(!ifs.is_open()) 
 		{
@@ -57,6 +58,13 @@ namespace determinize
 		}
 		ifs.close();
 
+		if(opt.Trim)
+		{
+			NfaTrimming<TNfa> trimming;
+			nfa = trimming.Trim(nfa);
+			cout << "Trimming removed " << static_cast<size_t>(trimming.Removed) << " states" << endl;
+		}
+
 		Determinization<TDfa, TNfa> det;
 		TDfa dfa = det.Determinize(nfa);
 
@@ -83,6 +91,34 @@ namespace determinize
 		}
 	}
 
+	class ConvertDispatch
+	{
+	public:
+		const Options& opt;
+
+		explicit ConvertDispatch(const Options& o) : opt(o)
+		{
+		}
+
+		template<typename TState, typename TSymbol>
+		int Run()
+		{
+			// the DFA may have many more states than the NFA, its states keep at least 32 bits
+			typedef Dfa<typename WidestOf<TState, uint32_t>::type, TSymbol> TDfa;
+			// every subset of states is stored in the map of DFA states, compressed sets make them as big as their contents
+			if(opt.Compressed) Convert<SparseNfa<TState, TSymbol, uint64_t, CompressedSet<TState>>, TDfa>(opt);
+			else Convert<SparseNfa<TState, TSymbol>, TDfa>(opt);
+			return 0;
+		}
+	};
+
+	void Convert(const Options& opt)
+	{
+		// NFA states and subsets use the narrowest type holding the input
+		auto dims = WidthDispatch::Peek(opt.InputFile, opt.Format);
+		ConvertDispatch dispatch(opt);
+		WidthDispatch::Dispatch(dims.States, dims.Symbols, dispatch);
+	}
 }
 
 using namespace determinize;
@@ -100,6 +136,8 @@ int main(int argc, char** argv)
 		("output,o", value(&o.OutputFile), "Output FSA file")
 		("format,f", value(&o.Format), "FSA file format to be used")
 		("verbose,v", bool_switch(&o.Verbose), "Verbose mode")
+		("compressed,c", bool_switch(&o.Compressed), "Store sets of states compressed, for NFA with many states and small subsets")
+		("trim,t", bool_switch(&o.Trim), "Remove the states not reachable or not reaching a final state before determinizing")
 		;
 
 	variables_map vm;
@@ -117,4 +155,4 @@ int main(int argc, char** argv)
 	Convert(o);
 
 	return 0;
-}
\ No newline at end of file
+}
\ No newline at end of file
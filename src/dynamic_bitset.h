@@ -2,9 +2,12 @@
 #pragma once
 
 #include <vector>
+#include <memory>
+#include <algorithm>
 #include <assert.h>
 #include <stdint.h>
 #include <boost/functional/hash.hpp>
+#include "bitset_kernels.h"
 
 template<typename Block, typename Index>
 struct bitutil
@@ -63,6 +66,15 @@ struct bitutil
 		return true;
 	}
 
+	/// Index of the lowest set bit, <param ref="b" /> must not be zero
+	static Index ctz(Block b)
+	{
+		assert(b != 0);
+		Index i;
+		bsf(b, &i);
+		return i;
+	}
+
 	static Index popcnt(Block x)
 	{
 		static_assert(sizeof(x) <= 8, "Max size of block is 64-bit");
@@ -116,6 +128,14 @@ struct bitutil<uint64_t, Index>
 		*i = static_cast<Index>(ii);
 		return r;
 	}
+
+	static Index ctz(uint64_t b)
+	{
+		assert(b != 0);
+		unsigned long ii;
+		_BitScanForward64(&ii, b);
+		return static_cast<Index>(ii);
+	}
 };
 
 // 32-bit x86 versions
@@ -159,6 +179,14 @@ struct bitutil<uint32_t, Index>
 		*i = static_cast<Index>(ii);
 		return r;
 	}
+
+	static Index ctz(uint32_t b)
+	{
+		assert(b != 0);
+		unsigned long ii;
+		_BitScanForward(&ii, b);
+		return static_cast<Index>(ii);
+	}
 };
 #elif __GNUC__
 
@@ -212,6 +240,12 @@ struct bitutil<uint64_t, Index>
 		}
 		return false;
 	}
+
+	static Index ctz(uint64_t b)
+	{
+		assert(b != 0);
+		return static_cast<Index>(__builtin_ctzll(b));
+	}
 };
 
 
@@ -265,21 +299,280 @@ struct bitutil<uint32_t, Index>
 		}
 		return false;
 	}
+
+	static Index ctz(uint32_t b)
+	{
+		assert(b != 0);
+		return static_cast<Index>(__builtin_ctz(b));
+	}
 };
 
 
 #endif
 
+/// Whole storage operations, 64-bit blocks use the vectorized bitset_kernels
+template<typename Block>
+struct blockutil
+{
+	static void union_with(Block* dst, const Block* src, size_t n)
+	{
+		for(size_t i=0; i<n; i++) dst[i] |= src[i];
+	}
+
+	static void intersect_with(Block* dst, const Block* src, size_t n)
+	{
+		for(size_t i=0; i<n; i++) dst[i] &= src[i];
+	}
+
+	static void difference_with(Block* dst, const Block* src, size_t n)
+	{
+		for(size_t i=0; i<n; i++) dst[i] &= ~src[i];
+	}
+
+	static bool none(const Block* src, size_t n)
+	{
+		for(size_t i=0; i<n; i++) if(src[i]) return false;
+		return true;
+	}
+
+	template<typename Index>
+	static Index count(const Block* src, size_t n)
+	{
+		Index c = 0;
+		for(size_t i=0; i<n; i++) c += bitutil<Block, Index>::popcnt(src[i]);
+		return c;
+	}
+
+	static bool equal(const Block* a, const Block* b, size_t n)
+	{
+		for(size_t i=0; i<n; i++) if(a[i] != b[i]) return false;
+		return true;
+	}
+
+	template<typename Index>
+	static Index union_many(Block* dst, const Block* const* srcs, size_t k, size_t n, bool accumulate, bool count)
+	{
+		Index c = 0;
+		for(size_t i=0; i<n; i++)
+		{
+			Block b = accumulate ? dst[i] : 0;
+			for(size_t s=0; s<k; s++) b |= srcs[s][i];
+			dst[i] = b;
+			if(count) c += bitutil<Block, Index>::popcnt(b);
+		}
+		return c;
+	}
+
+	/// Writes <param ref="base" /> + index of every set bit into <param ref="out" /> in increasing order, returns how many were written
+	template<typename Index>
+	static size_t extract(const Block* src, size_t n, Index base, Index* out)
+	{
+		Index* const first = out;
+		for(size_t i=0; i<n; i++, base+=static_cast<Index>(sizeof(Block) * 8))
+		{
+			for(Block b = src[i]; b; b &= b - 1) *out++ = static_cast<Index>(base + bitutil<Block, Index>::ctz(b));
+		}
+		return static_cast<size_t>(out - first);
+	}
+};
+
+template<>
+struct blockutil<uint64_t>
+{
+	static void union_with(uint64_t* dst, const uint64_t* src, size_t n)
+	{
+		bitset_kernels::active().union_with(dst, src, n);
+	}
+
+	static void intersect_with(uint64_t* dst, const uint64_t* src, size_t n)
+	{
+		bitset_kernels::active().intersect_with(dst, src, n);
+	}
+
+	static void difference_with(uint64_t* dst, const uint64_t* src, size_t n)
+	{
+		bitset_kernels::active().difference_with(dst, src, n);
+	}
+
+	static bool none(const uint64_t* src, size_t n)
+	{
+		return bitset_kernels::active().none(src, n);
+	}
+
+	template<typename Index>
+	static Index count(const uint64_t* src, size_t n)
+	{
+		return static_cast<Index>(bitset_kernels::active().count(src, n));
+	}
+
+	static bool equal(const uint64_t* a, const uint64_t* b, size_t n)
+	{
+		return bitset_kernels::active().equal(a, b, n);
+	}
+
+	template<typename Index>
+	static Index union_many(uint64_t* dst, const uint64_t* const* srcs, size_t k, size_t n, bool accumulate, bool count)
+	{
+		return static_cast<Index>(bitset_kernels::active().union_many(dst, srcs, k, n, accumulate, count));
+	}
+
+	template<typename Index>
+	static size_t extract(const uint64_t* src, size_t n, Index base, Index* out)
+	{
+		Index* const first = out;
+		for(size_t i=0; i<n; i++, base+=64)
+		{
+			for(uint64_t b = src[i]; b; b &= b - 1) *out++ = static_cast<Index>(base + bitutil<uint64_t, Index>::ctz(b));
+		}
+		return static_cast<size_t>(out - first);
+	}
+
+	/// 32-bit indexes are decoded by the kernels
+	static size_t extract(const uint64_t* src, size_t n, uint32_t base, uint32_t* out)
+	{
+		return bitset_kernels::active().extract(src, n, base, out);
+	}
+};
+
+#ifndef BITSET_INLINE_BLOCKS
+/// Blocks kept inside every BitSet before spilling to the heap, 4 blocks of 64 bits hold 256 states
+#define BITSET_INLINE_BLOCKS 4
+#endif
+
+/// Fixed length array of blocks stored inside the object when it has up to <param ref="InlineBlocks" /> blocks,
+/// longer arrays are taken from <param ref="Allocator" />.
+/// Small bitsets are created, copied and destroyed without touching the heap.
+template<typename Block, size_t InlineBlocks, typename Allocator>
+class block_storage : private Allocator
+{
+public:
+	typedef Block value_type;
+	typedef Block* iterator;
+	typedef const Block* const_iterator;
+
+private:
+	size_t length;
+	/// points to local or to the heap
+	Block* blocks;
+	Block local[InlineBlocks > 0 ? InlineBlocks : 1];
+
+	bool is_local() const
+	{
+		return blocks == local;
+	}
+
+	void acquire(size_t n)
+	{
+		length = n;
+		blocks = n <= InlineBlocks ? local : Allocator::allocate(n);
+	}
+
+	void release()
+	{
+		if(!is_local()) Allocator::deallocate(blocks, length);
+		length = 0;
+		blocks = local;
+	}
+
+public:
+
+	explicit block_storage(size_t n, const Allocator& allocator = Allocator())
+		: Allocator(allocator)
+	{
+		acquire(n);
+		std::fill(blocks, blocks + n, Block(0));
+	}
+
+	block_storage(const block_storage& other)
+		: Allocator(other)
+	{
+		acquire(other.length);
+		std::copy(other.blocks, other.blocks + length, blocks);
+	}
+
+	block_storage(block_storage&& other)
+		: Allocator(std::move(other))
+	{
+		length = other.length;
+		if(other.is_local())
+		{
+			blocks = local;
+			std::copy(other.blocks, other.blocks + length, blocks);
+		}
+		else
+		{
+			blocks = other.blocks;
+			other.length = 0;
+			other.blocks = other.local;
+		}
+	}
+
+	~block_storage()
+	{
+		release();
+	}
+
+	/// Reuses the current array when both have the same length
+	block_storage& operator=(const block_storage& other)
+	{
+		if(this == &other) return *this;
+		if(length != other.length)
+		{
+			release();
+			acquire(other.length);
+		}
+		std::copy(other.blocks, other.blocks + length, blocks);
+		return *this;
+	}
+
+	block_storage& operator=(block_storage&& other)
+	{
+		if(this == &other) return *this;
+		if(other.is_local())
+		{
+			*this = static_cast<const block_storage&>(other);
+			return *this;
+		}
+		release();
+		length = other.length;
+		blocks = other.blocks;
+		other.length = 0;
+		other.blocks = other.local;
+		return *this;
+	}
+
+	size_t size() const { return length; }
+	bool empty() const { return length == 0; }
+
+	Block* data() { return blocks; }
+	const Block* data() const { return blocks; }
+
+	iterator begin() { return blocks; }
+	iterator end() { return blocks + length; }
+	const_iterator begin() const { return blocks; }
+	const_iterator end() const { return blocks + length; }
+	const_iterator cbegin() const { return blocks; }
+	const_iterator cend() const { return blocks + length; }
+
+	Block& operator[](size_t i) { return blocks[i]; }
+	const Block& operator[](size_t i) const { return blocks[i]; }
+
+	Block& back() { return blocks[length - 1]; }
+	const Block& back() const { return blocks[length - 1]; }
+};
+
 // Declarations 
 
 template<class _Parent>
 class dynamic_bitset_iterator;
 
-template<typename ElementType, typename Block, typename Allocator = std::allocator<Block>>
+template<typename ElementType, typename Block, typename Allocator = std::allocator<Block>, size_t InlineBlocks = BITSET_INLINE_BLOCKS>
 class dynamic_bitset;
 
 // Definitions
 
+/// Forward iterator over the set bits.
+/// Keeps the current block and the index of its first bit, every step is one ctz and one clear of the lowest bit.
 template<class _Parent>
 class dynamic_bitset_iterator
 {
@@ -292,63 +585,54 @@ public:
 	static const element_type bits_per_block = sizeof(block_type) * 8;
 private:
 	element_type bit_num;
-	const storage_type* storage;
-	typename storage_type::const_iterator blk_iter;
+	/// index of the first bit of blk
+	element_type blk_base;
+	const block_type* blk;
+	const block_type* blk_end;
+	/// bits of *blk not visited yet
 	block_type current_block;
 
 public:
 
 	explicit dynamic_bitset_iterator(const storage_type* _storage)
-		: storage(_storage)
+		: bit_num(0), blk_base(0), blk(_storage->data()), blk_end(_storage->data() + _storage->size()), current_block(0)
 	{
-		blk_iter = storage->cbegin();
-		if(storage->empty()) return;
-		current_block = *blk_iter;
+		if(blk == blk_end) return;
+		current_block = *blk;
 		advance();
 	}
 
-	dynamic_bitset_iterator(storage_type* _storage, element_type _bit_num)
-		: storage(_storage), bit_num(_bit_num)
-	{
-		blk_iter = storage->cbegin() + _bit_num/bits_per_block;
-		current_block = *blk_iter;
-		assert(bt(current_block, _bit_num%bits_per_block));
-		current_block &= ~static_cast<block_type>(0) << (_bit_num%bits_per_block + 1);
-	}
-
-	dynamic_bitset_iterator(const iterator& org)
-		: storage(org.storage), bit_num(org.bit_num), current_block(org.current_block), blk_iter(org.blk_iter)
+	dynamic_bitset_iterator(const storage_type* _storage, element_type _bit_num)
+		: bit_num(_bit_num), blk_base(_bit_num - _bit_num % bits_per_block), blk(_storage->data() + _bit_num / bits_per_block), blk_end(_storage->data() + _storage->size())
 	{
+		current_block = *blk;
+		assert(bu::bt(current_block, _bit_num % bits_per_block));
+		// drop the bits up to the current one
+		current_block &= ~static_cast<block_type>(0) << (_bit_num % bits_per_block) << 1;
 	}
 
 	element_type operator*() const 
 	{
-		assert(blk_iter != storage->end());
+		assert(blk != blk_end);
 		return bit_num;
 	}
 
 	void advance()
 	{
-		assert(blk_iter != storage->end());
-		element_type bit_idx;
-		do {
-			if(bu::bsf(current_block, &bit_idx))
-			{
-				bu::bc(&current_block, bit_idx);
-				auto blk_idx = std::distance(storage->begin(), blk_iter);
-				element_type blk_bit_begin = static_cast<element_type>(blk_idx) * bits_per_block;
-				bit_num = bit_idx + blk_bit_begin;
-				break;
-			}
-			++blk_iter;
-			if(blk_iter == storage->end()) break;
-			current_block = *blk_iter;
-		} while(true);
+		assert(blk != blk_end);
+		while(!current_block)
+		{
+			if(++blk == blk_end) return;
+			blk_base += bits_per_block;
+			current_block = *blk;
+		}
+		bit_num = blk_base + bu::ctz(current_block);
+		current_block &= current_block - 1;
 	}
 
 	bool is_end() const
 	{
-		return blk_iter == storage->end();
+		return blk == blk_end;
 	}
 
 	iterator& operator++()
@@ -360,26 +644,26 @@ public:
 	bool operator==(const dynamic_bitset_iterator<_Parent>& rhs) const
 	{
 		const dynamic_bitset_iterator<_Parent>& lhs = *this;
-		auto b1 = lhs.blk_iter == storage->end();
-		auto b2 = rhs.blk_iter == storage->end();
+		auto b1 = lhs.is_end();
+		auto b2 = rhs.is_end();
 		if(b1 != b2) return false;
-		return lhs.bit_num == rhs.bit_num;
+		return b1 || lhs.bit_num == rhs.bit_num;
 	}
 };
 
-template<typename ElementType, typename Block, typename Allocator>
+template<typename ElementType, typename Block, typename Allocator, size_t InlineBlocks>
 class dynamic_bitset 
 {
 public:
 	typedef ElementType element_type;
 	typedef Block block_type;
-	typedef dynamic_bitset<ElementType, Block, Allocator> dynamic_bitset_type;
+	typedef dynamic_bitset<ElementType, Block, Allocator, InlineBlocks> dynamic_bitset_type;
 	typedef dynamic_bitset_iterator<dynamic_bitset_type> iterator;
 	typedef bitutil<block_type, element_type> bu;
 	static const element_type bits_per_block = sizeof(Block) * 8;
 
 private:
-	typedef std::vector<Block, Allocator> StorageType;
+	typedef block_storage<Block, InlineBlocks, Allocator> StorageType;
 	StorageType storage;
 	element_type bits;
 
@@ -487,41 +771,52 @@ public:
 
 	void union_with(const dynamic_bitset_type& bt) 
 	{
-		auto i = bt.storage.begin();
-		auto j = storage.begin();
-		while(i!=bt.storage.end())
+		assert(bt.storage.size() <= storage.size());
+		blockutil<Block>::union_with(storage.data(), bt.storage.data(), bt.storage.size());
+	}
+
+	/// Inputs combined per pass of union_many
+	static const size_t union_many_batch = 16;
+
+	/// this = (accumulate ? this : empty) | *srcs[0] | ... | *srcs[k-1], in one pass per batch of inputs.
+	/// Every input must have the same size as this one.
+	/// Returns the number of elements of the result if <param ref="count" /> is set, zero otherwise.
+	element_type union_many(const dynamic_bitset_type* const* srcs, size_t k, bool accumulate, bool count)
+	{
+		const Block* blocks[union_many_batch];
+		size_t s = 0;
+		do
 		{
-			*j++ |= *i++;
-		}
+			const size_t m = std::min(k - s, union_many_batch);
+			for(size_t i=0; i<m; i++)
+			{
+				assert(srcs[s + i]->storage.size() == storage.size());
+				blocks[i] = srcs[s + i]->storage.data();
+			}
+			s += m;
+			// only the last batch counts, it rewrites every block
+			const bool last = s == k;
+			const element_type c = blockutil<Block>::template union_many<element_type>(storage.data(), blocks, m, storage.size(), accumulate, count && last);
+			if(last) return c;
+			accumulate = true;
+		} while(true);
 	}
 
 	void intersect_with(const dynamic_bitset_type& bt) 
 	{
-		auto i = bt.storage.begin();
-		auto j = storage.begin();
-		while(i!=bt.storage.end())
-		{
-			*j++ &= *i++;
-		}
+		assert(bt.storage.size() <= storage.size());
+		blockutil<Block>::intersect_with(storage.data(), bt.storage.data(), bt.storage.size());
 	}
 
 	void difference_with(const dynamic_bitset_type& bt)
 	{
-		auto i = bt.storage.begin();
-		auto j = storage.begin();
-		while(i!=bt.storage.end())
-		{
-			*j++ &= ~*i++;
-		}
+		assert(bt.storage.size() <= storage.size());
+		blockutil<Block>::difference_with(storage.data(), bt.storage.data(), bt.storage.size());
 	}
 
 	bool none() const
 	{
-		for(auto i : storage)
-		{
-			if(i) return false;
-		}
-		return true;
+		return blockutil<Block>::none(storage.data(), storage.size());
 	}
 
 	bool any() const 
@@ -535,12 +830,7 @@ public:
 
 	element_type count() const
 	{
-		element_type c=0;
-		for(auto i : storage)
-		{
-			c += bu::popcnt(i);
-		}
-		return c;
+		return blockutil<Block>::template count<element_type>(storage.data(), storage.size());
 	}
 
 	element_type element_in_position(element_type cnt) const
@@ -548,7 +838,7 @@ public:
 		assert(cnt < count());
 		element_type c = 0;
 		auto i = storage.begin();
-		if (cnt >= bits_per_block)
+		// skip whole blocks holding fewer elements than the remaining position
 		while(true)
 		{
 			auto p = bu::popcnt(*i);
@@ -567,15 +857,17 @@ public:
 		return c + bit;
 	}
 
+	/// Writes every element into <param ref="out" /> in increasing order, returns how many were written.
+	/// <param ref="out" /> must have room for count() elements.
+	element_type extract_to(element_type* out) const
+	{
+		return static_cast<element_type>(blockutil<Block>::extract(storage.data(), storage.size(), element_type(0), out));
+	}
+
 	bool operator==(const dynamic_bitset_type& rhs) const
 	{
-		auto j=storage.begin();
-		auto i=rhs.storage.begin();
-		while(i != rhs.storage.end())
-		{
-			if(*i++ != *j++) return false;
-		}
-		return true;
+		assert(rhs.storage.size() <= storage.size());
+		return blockutil<Block>::equal(storage.data(), rhs.storage.data(), rhs.storage.size());
 	}
 
 	iterator begin() const
@@ -590,6 +882,9 @@ public:
 
 	size_t hash_value() const
 	{
-		return boost::hash_value(storage);
+		return boost::hash_range(storage.begin(), storage.end());
 	}
 };
+
+template<typename ElementType, typename Block, typename Allocator, size_t InlineBlocks>
+const size_t dynamic_bitset<ElementType, Block, Allocator, InlineBlocks>::union_many_batch;
@@ -6,6 +6,7 @@
 #include "../FsaPlainTextReader.h"
 #include "../FsaPlainTextWriter.h"
 #include "../FsaFormat.h"
+#include "../WidthDispatch.h"
 #include <fstream>
 #include <chrono>
 #include <boost/format.hpp>
@@ -38,10 +39,9 @@ namespace generate_nfa
 		}
 	};
 
+	template<typename TState, typename TSymbol>
 	void GenerateNfa(const Options& opt)
 	{
-		typedef uint16_t TState;
-		typedef uint16_t TSymbol;
 		typedef Nfa<TState, TSymbol> TNfa;
 		typedef mt19937 TRandGen;
 
@@ -79,6 +79,30 @@ namespace generate_nfa
 		}
 	}
 
+	class GenerateDispatch
+	{
+	public:
+		const Options& opt;
+
+		explicit GenerateDispatch(const Options& o) : opt(o)
+		{
+		}
+
+		template<typename TState, typename TSymbol>
+		int Run()
+		{
+			GenerateNfa<TState, TSymbol>(opt);
+			return 0;
+		}
+	};
+
+	void GenerateNfa(const Options& opt)
+	{
+		if(opt.States <= 0 || opt.Symbols <= 0) throw invalid_argument("states and symbols must be positive");
+		GenerateDispatch dispatch(opt);
+		WidthDispatch::Dispatch(static_cast<uint64_t>(opt.States), static_cast<uint64_t>(opt.Symbols), dispatch);
+	}
+
 }
 
 using namespace generate_nfa;
@@ -111,7 +135,15 @@ int main(int argc, char** argv)
 		return 0;
 	}
 
-	GenerateNfa(o);
+	try
+	{
+		GenerateNfa(o);
+	}
+	catch(exception& ex)
+	{
+		cout << "Error: " << ex.what() << endl;
+		return -1;
+	}
 
 	return 0;
 }
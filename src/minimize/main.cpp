@@ -1,9 +1,13 @@
 // June 2013, Jairo Andres Velasco Romero, jairov(at)javerianacali.edu.co
 #include "../MinimizationHopcroft.h"
+#include "../MinimizationHopcroftParallel.h"
 #include "../MinimizationBrzozowski.h"
 #include "../MinimizationIncremental.h"
 #include "../MinimizationHybrid.h"
 #include "../MinimizationAtomic.h"
+#include "../MinimizationValmari.h"
+#include "../MinimizationMoore.h"
+#include "../MinimizationMooreParallel.h"
 #include "../MinimizationAlgorithm.h"
 #include "../Dfa.h"
 #include "../Nfa.h"
@@ -11,6 +15,8 @@
 #include "../FsaFormatReader.h"
 #include "../FsaPlainTextReader.h"
 #include "../FsaPlainTextWriter.h"
+#include "../WidthDispatch.h"
+#include "../Trimming.h"
 #include <fstream>
 #include <boost/timer/timer.hpp>
 #include <boost/format.hpp>
@@ -37,11 +43,15 @@ namespace minimize
 		bool SkipSynthOutput;
 		bool ShowHelp;
 		bool Verbose;
+		bool Trim;
+		unsigned Threads;
 
 		Options() :
 			SkipSynthOutput(true),
 			ShowHelp(false),
 			Verbose(false),
+			Trim(false),
+			Threads(1),
 			AppendTimeInformation(),
 			Algorithm(MinimizationAlgorithm::Hopcroft)
 		{
@@ -49,11 +59,10 @@ namespace minimize
 	};
 
 
-	int Minimization(Options opt)
+	template<typename TState, typename TSymbol>
+	int Minimization(const Options& opt)
 	{
 		using boost::timer::cpu_timer;
-		typedef uint16_t TState;
-		typedef uint8_t TSymbol;
 		typedef Dfa<TState, TSymbol> TDfa;
 		typedef Nfa<TState, TSymbol> TFsa;
 
@@ -84,32 +93,71 @@ namespace minimize
 		if (opt.Verbose)
 		{
 			cout << "Read " << opt.InputFile << endl;
-			cout << "Found FSA with " << original_states << " states and " << dfa.GetAlphabetLength() << " symbols" << endl;
+			cout << "Found FSA with " << static_cast<size_t>(original_states) << " states and " << original_alphabet << " symbols" << endl;
+		}
+
+		if (opt.Trim)
+		{
+			// Brzozowski reads the NFA, the others the DFA
+			size_t removed;
+			if (opt.Algorithm == MinimizationAlgorithm::Brzozowski)
+			{
+				NfaTrimming<TFsa> trimming;
+				fsa = trimming.Trim(fsa);
+				removed = static_cast<size_t>(trimming.Removed);
+			}
+			else
+			{
+				DfaTrimming<TDfa> trimming;
+				dfa = trimming.Trim(dfa);
+				removed = static_cast<size_t>(trimming.Removed);
+			}
+			cout << "Trimming removed " << removed << " states" << endl;
+		}
+
+		// only Valmari handles undefined transitions, the others get a sink state
+		if (!dfa.IsComplete() && opt.Algorithm != MinimizationAlgorithm::Valmari)
+		{
+			dfa = dfa.Complete();
+			if (opt.Verbose) cout << "Partial DFA completed with sink state " << static_cast<size_t>(dfa.GetStates() - 1) << endl;
 		}
 
 		cpu_timer timer;
 		// TODO: apply polymorphism to reduce code lines
 		TDfa min_dfa(0, 0);
 		timer.start();
-		if (opt.Algorithm == MinimizationAlgorithm::Hopcroft)
+		if (opt.Algorithm == MinimizationAlgorithm::Hopcroft && opt.Threads > 1)
+		{
+			MinimizationHopcroftParallel<TDfa> min;
+			typename MinimizationHopcroftParallel<TDfa>::NumericPartition partition;
+			min.Threads = opt.Threads;
+			timer.start();
+			min.Minimize(dfa, partition);
+			timer.stop();
+			minimum_states = partition.GetSize();
+			if (opt.Verbose) {
+				cout << "Partition count: " << static_cast<size_t>(minimum_states) << endl;
+			}
+			if (!opt.SkipSynthOutput) min_dfa = min.BuildDfa(dfa, partition);
+		}
+		else if (opt.Algorithm == MinimizationAlgorithm::Hopcroft)
 		{
 			MinimizationHopcroft<TDfa> min;
-			MinimizationHopcroft<TDfa>::NumericPartition partition;
-			min.ShowConfiguration = false;
+			typename MinimizationHopcroft<TDfa>::NumericPartition partition;
 			timer.start();
 			min.Minimize(dfa, partition);
 			timer.stop();
 			minimum_states = partition.GetSize();
 			if (opt.Verbose) {
-				cout << "Partition count: " << minimum_states << endl;
+				cout << "Partition count: " << static_cast<size_t>(minimum_states) << endl;
 			}
 			if (!opt.SkipSynthOutput) min_dfa = min.BuildDfa(dfa, partition);
 		}
 		else if (opt.Algorithm == MinimizationAlgorithm::Brzozowski)
 		{
 			MinimizationBrzozowski<TFsa, TDfa> min;
-			MinimizationBrzozowski<TFsa, TDfa>::TVectorDfaState vfinal;
-			MinimizationBrzozowski<TFsa, TDfa>::TVectorDfaEdge vedges;
+			typename MinimizationBrzozowski<TFsa, TDfa>::TVectorDfaState vfinal;
+			typename MinimizationBrzozowski<TFsa, TDfa>::TVectorDfaEdge vedges;
 
 			timer.start();
 			min.Minimize(fsa, &minimum_states, vfinal, vedges);
@@ -117,49 +165,86 @@ namespace minimize
 
 			if (opt.Verbose)
 			{
-				cout << "Minimum state count: " << minimum_states << endl;
+				cout << "Minimum state count: " << static_cast<size_t>(minimum_states) << endl;
 			}
 			if (!opt.SkipSynthOutput) min_dfa = min.BuildDfa(fsa.GetAlphabetLength(), minimum_states, vfinal, vedges);
 		}
 		else if (opt.Algorithm == MinimizationAlgorithm::Incremental)
 		{
 			MinimizationIncremental<TDfa> min;
-			MinimizationIncremental<TDfa>::NumericPartition partition;
-			min.ShowConfiguration = false;
+			typename MinimizationIncremental<TDfa>::NumericPartition partition;
 			timer.start();
 			min.Minimize(dfa, partition);
 			timer.stop();
 			minimum_states = partition.GetSize();
 			if (opt.Verbose) {
-				cout << "Partition count: " << minimum_states << endl;
+				cout << "Partition count: " << static_cast<size_t>(minimum_states) << endl;
 			}
 			if (!opt.SkipSynthOutput) min_dfa = min.BuildDfa(dfa, partition);
 		}
 		else if (opt.Algorithm == MinimizationAlgorithm::Hybrid)
 		{
 			MinimizationHybrid<TDfa> min;
-			MinimizationHybrid<TDfa>::NumericPartition partition;
-			min.ShowConfiguration = false;
+			typename MinimizationHybrid<TDfa>::NumericPartition partition;
+			timer.start();
+			min.Minimize(dfa, partition);
+			timer.stop();
+			minimum_states = partition.GetSize();
+			if (opt.Verbose) {
+				cout << "Partition count: " << static_cast<size_t>(minimum_states) << endl;
+			}
+			if (!opt.SkipSynthOutput) min_dfa = min.BuildDfa(dfa, partition);
+		}
+		else if (opt.Algorithm == MinimizationAlgorithm::Valmari)
+		{
+			MinimizationValmari<TDfa> min;
+			typename MinimizationValmari<TDfa>::NumericPartition partition;
+			timer.start();
+			min.Minimize(dfa, partition);
+			timer.stop();
+			minimum_states = partition.GetSize();
+			if (opt.Verbose) {
+				cout << "Partition count: " << static_cast<size_t>(minimum_states) << endl;
+			}
+			if (!opt.SkipSynthOutput) min_dfa = min.BuildDfa(dfa, partition);
+		}
+		else if (opt.Algorithm == MinimizationAlgorithm::Moore)
+		{
+			MinimizationMoore<TDfa> min;
+			typename MinimizationMoore<TDfa>::NumericPartition partition;
+			timer.start();
+			min.Minimize(dfa, partition);
+			timer.stop();
+			minimum_states = partition.GetSize();
+			if (opt.Verbose) {
+				cout << "Partition count: " << static_cast<size_t>(minimum_states) << " in " << min.Rounds << " rounds" << endl;
+			}
+			if (!opt.SkipSynthOutput) min_dfa = min.BuildDfa(dfa, partition);
+		}
+		else if (opt.Algorithm == MinimizationAlgorithm::MooreParallel)
+		{
+			MinimizationMooreParallel<TDfa> min;
+			typename MinimizationMooreParallel<TDfa>::NumericPartition partition;
+			min.Threads = opt.Threads;
 			timer.start();
 			min.Minimize(dfa, partition);
 			timer.stop();
 			minimum_states = partition.GetSize();
 			if (opt.Verbose) {
-				cout << "Partition count: " << minimum_states << endl;
+				cout << "Partition count: " << static_cast<size_t>(minimum_states) << " in " << min.Rounds << " rounds" << endl;
 			}
 			if (!opt.SkipSynthOutput) min_dfa = min.BuildDfa(dfa, partition);
 		}
 		else if (opt.Algorithm == MinimizationAlgorithm::Atomic)
 		{
 			MinimizationAtomic<TDfa> min;
-			min.ShowConfiguration = false;
 			timer.start();
 			min_dfa = min.Minimize(dfa);
 			timer.stop();
 			minimum_states = min_dfa.GetStates();
 			if (opt.Verbose)
 			{
-				cout << "Minimum state count: " << minimum_states << endl;
+				cout << "Minimum state count: " << static_cast<size_t>(minimum_states) << endl;
 			}
 		}
 
@@ -194,14 +279,40 @@ namespace minimize
 			}
 			ofs << opt.InputFile
 				<< "," << opt.Algorithm
-				<< "," << original_states
+				<< "," << static_cast<size_t>(original_states)
 				<< "," << original_alphabet
-				<< "," << minimum_states
+				<< "," << static_cast<size_t>(minimum_states)
 				<< "," << timer.elapsed().wall
 				<< endl;
 		}
 		return 0;
 	}
+
+	class MinimizationDispatch
+	{
+	public:
+		const Options& opt;
+
+		explicit MinimizationDispatch(const Options& o) : opt(o)
+		{
+		}
+
+		template<typename TState, typename TSymbol>
+		int Run()
+		{
+			return Minimization<TState, TSymbol>(opt);
+		}
+	};
+
+	int Minimization(const Options& opt)
+	{
+		// the reversed automaton determinized by Brzozowski may have many more states than the input
+		const unsigned min_state_bits = opt.Algorithm == MinimizationAlgorithm::Brzozowski ? 32 : 8;
+		auto dims = WidthDispatch::Peek(opt.InputFile, FsaFormat::ZeroBasedPlainText);
+		MinimizationDispatch dispatch(opt);
+		// room for the sink state of a partial input
+		return WidthDispatch::Dispatch(dims.States + 1, dims.Symbols, dispatch, min_state_bits);
+	}
 }
 
 using namespace minimize;
@@ -218,6 +329,8 @@ int main(int argc, char** argv)
 		("append_log,w", value(&o.AppendTimeInformation)->default_value(""), "CSV file to append time and minimization result")
 		("skip_synth,s", bool_switch(&o.SkipSynthOutput)->default_value(false), "Skip synthetize output")
 		("verbose,v", bool_switch(&o.Verbose), "Verbose mode")
+		("trim,t", bool_switch(&o.Trim), "Remove unreachable states and collapse dead ones before minimizing")
+		("threads,j", value(&o.Threads)->default_value(1), "Threads used by Hopcroft and moore-parallel")
 		;
 
 	variables_map vm;
@@ -232,7 +345,13 @@ int main(int argc, char** argv)
 		return 0;
 	}
 
-	Minimization(o);
-
-	return 0;
+	try
+	{
+		return Minimization(o);
+	}
+	catch (exception& ex)
+	{
+		cout << "Error: " << ex.what() << endl;
+		return -1;
+	}
 }
@@ -1,12 +1,25 @@
 // June 2013, Jairo Andres Velasco Romero, jairov(at)javerianacali.edu.co
 #include "../MinimizationHopcroft.h"
+#include "../MinimizationHopcroftParallel.h"
 #include "../MinimizationBrzozowski.h"
 #include "../MinimizationIncremental.h"
 #include "../MinimizationHybrid.h"
 #include "../MinimizationAtomic.h"
+#include "../MinimizationValmari.h"
+#include "../MinimizationMoore.h"
+#include "../MinimizationMooreParallel.h"
+#include "../MinimizationDynamic.h"
+#include "../Trace.h"
+#include "../Trimming.h"
 #include "../MinimizationAlgorithm.h"
 #include "../Dfa.h"
+#include "../CompactDfa.h"
 #include "../Nfa.h"
+#include "../SparseNfa.h"
+#include "../CompressedSet.h"
+#include "../Partition.h"
+#include "../PairTable.h"
+#include "../FsaBuilder.h"
 #include "../Fsa.h"
 #include "../Set.h"
 #include "../FsaFormat.h"
@@ -25,7 +38,12 @@
 #include <boost/program_options.hpp>
 #include <boost/algorithm/string.hpp>
 #include <array>
+#include <limits>
 #include <stdexcept>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <cstdlib>
 
 using namespace std;
 using boost::format;
@@ -33,6 +51,22 @@ using boost::format;
 char** global_argv;
 int global_argc;
 
+// Every heap allocation of the process, reported by the benchmarks
+atomic<size_t> global_allocations(0);
+
+void* operator new(size_t size)
+{
+	global_allocations++;
+	void* p = malloc(size == 0 ? 1 : size);
+	if (p == nullptr) throw bad_alloc();
+	return p;
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
 // Utilities
 
 template<typename TFsa>
@@ -92,10 +126,10 @@ void write_dfa_info(const TDfa& dfa)
 			auto pred = dfa.GetPredecessors(s, a);
 			int cont = 0;
 			cout << "{";
-			for (auto i = pred.GetIterator(); !i.IsEnd(); i.MoveNext())
+			for (auto i : pred)
 			{
 				if (cont++ > 0) cout << ",";
-				size_t target = static_cast<size_t>(i.GetCurrent());
+				size_t target = static_cast<size_t>(i);
 				cout << target;
 			}
 			cout << "}";
@@ -161,7 +195,7 @@ int test100()
 	typedef uint16_t TState;
 	typedef uint8_t TSymbol;
 	typedef Dfa<TState, TSymbol> TDfa;
-	MinimizationHopcroft<TDfa> mini;
+	MinimizationHopcroft<TDfa, TraceConsole> mini;
 	TDfa dfa(2, 4);
 
 	//   / 2 \
@@ -182,7 +216,6 @@ int test100()
 	dfa.SetTransition(3, 1, 3);
 
 	MinimizationHopcroft<TDfa>::NumericPartition out_partitions;
-	mini.ShowConfiguration = true;
 	mini.Minimize(dfa, out_partitions);
 
 	// asegura que la cantidad de estados al final es menor
@@ -201,7 +234,7 @@ int test101()
 	typedef uint16_t TState;
 	typedef uint8_t TSymbol;
 	typedef Dfa<TState, TSymbol> TDfa;
-	MinimizationHopcroft<TDfa> mini;
+	MinimizationHopcroft<TDfa, TraceConsole> mini;
 	//    / 1 - 3
 	//  0
 	//    \ 2 - 4
@@ -227,7 +260,6 @@ int test101()
 	dfa.SetTransition(4, 1, 4);
 
 	MinimizationHopcroft<TDfa>::NumericPartition out_partitions;
-	mini.ShowConfiguration = true;
 	mini.Minimize(dfa, out_partitions);
 
 	// asegura que la cantidad de estados al final es menor
@@ -246,7 +278,7 @@ int test102()
 	typedef uint16_t TState;
 	typedef uint8_t TSymbol;
 	typedef Dfa<TState, TSymbol> TDfa;
-	MinimizationHopcroft<TDfa> mini;
+	MinimizationHopcroft<TDfa, TraceConsole> mini;
 	// uses zero as invisible null-sink state
 	//      2 - 5 - 8  - 11
 	//    /
@@ -277,7 +309,6 @@ int test102()
 	dfa.SetTransition(10, 2, 13);
 
 	MinimizationHopcroft<TDfa>::NumericPartition out_partitions;
-	mini.ShowConfiguration = true;
 	mini.Minimize(dfa, out_partitions);
 
 	// asegura que la cantidad de estados al final es menor
@@ -296,7 +327,7 @@ int test103()
 	typedef uint16_t TState;
 	typedef uint8_t TSymbol;
 	typedef Dfa<TState, TSymbol> TDfa;
-	MinimizationHopcroft<TDfa> mini;
+	MinimizationHopcroft<TDfa, TraceConsole> mini;
 	// uses zero as invisible null-sink state
 	//      2 - 5 - 8  - 11
 	//    /       \   /
@@ -343,7 +374,6 @@ int test103()
 	dfa.SetTransition(10, 2, 13);
 
 	MinimizationHopcroft<TDfa>::NumericPartition out_partitions;
-	mini.ShowConfiguration = true;
 	mini.Minimize(dfa, out_partitions);
 
 	// asegura que la cantidad de estados al final es menor
@@ -440,7 +470,6 @@ int test104()
 	ifstream afd;
 	ofstream report("report.txt");
 	Dfa<uint16_t, uint8_t> dfa(0, 0);
-	mini.ShowConfiguration = false;
 
 	for (auto filename : files)
 	{
@@ -478,6 +507,67 @@ int test104()
 }
 
 
+int test105()
+{
+	cout << "Esta prueba minimiza DFA aleatorios en sus variantes compactas y compara contra el DFA original" << endl;
+
+	typedef uint32_t TState;
+	typedef uint8_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+	typedef CompactDfa<TState, TSymbol, DfaLayout::SymbolMajor, uint16_t> TSymbolMajorDfa;
+	typedef CompactDfa<TState, TSymbol, DfaLayout::StateMajor> TStateMajorDfa;
+
+	mt19937 rgen(105);
+	for (int round = 0; round < 10; round++)
+	{
+		const TState states = 50 + round * 20;
+		const TSymbol alpha = 2 + round % 3;
+		uniform_int_distribution<TState> state_dist(0, states - 1);
+		TDfa dfa(alpha, states);
+		dfa.SetInitial(0);
+		for (TState s = 0; s < states; s++)
+		{
+			// pocos estados finales y pocos destinos para obtener clases no triviales
+			if (state_dist(rgen) < states / 5) dfa.SetFinal(s);
+			for (TSymbol a = 0; a < alpha; a++) dfa.SetTransition(s, a, state_dist(rgen) % (states / 2 + 1));
+		}
+
+		TSymbolMajorDfa sym(dfa);
+		TDfa copy = dfa;
+		TStateMajorDfa st(move(copy));
+		assert(copy.GetStates() == 0);
+		for (TState s = 0; s < states; s++)
+		{
+			assert(sym.IsFinal(s) == dfa.IsFinal(s) && st.IsFinal(s) == dfa.IsFinal(s));
+			for (TSymbol a = 0; a < alpha; a++)
+			{
+				assert(sym.GetSuccessor(s, a) == dfa.GetSuccessor(s, a));
+				assert(st.GetSuccessor(s, a) == dfa.GetSuccessor(s, a));
+				assert(sym.GetSymbolSuccessors(a)[s] == dfa.GetSuccessor(s, a));
+				auto p = dfa.GetPredecessors(s, a);
+				auto p1 = sym.GetPredecessors(s, a);
+				auto p2 = st.GetPredecessors(s, a);
+				assert(p.Count() == p1.Count() && equal(p.begin(), p.end(), p1.begin()));
+				assert(p.Count() == p2.Count() && equal(p.begin(), p.end(), p2.begin()));
+			}
+		}
+
+		MinimizationHopcroft<TDfa> h;
+		MinimizationHopcroft<TSymbolMajorDfa> h1;
+		MinimizationHopcroft<TStateMajorDfa> h2;
+		MinimizationIncremental<TSymbolMajorDfa> i1;
+		auto min = h.Minimize(dfa);
+		auto min1 = h1.Minimize(sym);
+		auto min2 = h2.Minimize(st);
+		auto min3 = i1.Minimize(sym);
+		assert(min.GetStates() == min1.GetStates());
+		assert(min.GetStates() == min2.GetStates());
+		assert(min.GetStates() == min3.GetStates());
+	}
+
+	return 0;
+}
+
 // Tests Brzozowski 200-299
 
 int test200()
@@ -676,6 +766,131 @@ int test203()
 	return 0;
 }
 
+int test204()
+{
+	cout << "Esta prueba compara el NFA disperso contra el NFA denso en determinizacion y Brzozowski" << endl;
+
+	typedef uint16_t TState;
+	typedef uint8_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+	typedef Nfa<TState, TSymbol> TNfa;
+	typedef SparseNfa<TState, TSymbol> TSparseNfa;
+
+	// filas dispersas y densas, automatas pequenos para acotar la determinizacion
+	const TState sizes[] = { 300, 300, 16, 16 };
+	const float densities[] = { 0.01f, 0.1f, 0.05f, 0.3f };
+	for (int k = 0; k < 4; k++)
+	{
+		const TState n = sizes[k];
+		mt19937 gen1(204), gen2(204);
+		NfaGenerator<TNfa, mt19937> nfagen;
+		NfaGenerator<TSparseNfa, mt19937> snfagen;
+		TNfa nfa = nfagen.Generate(n, 3, 2, 2, densities[k], gen1);
+		TSparseNfa snfa = snfagen.Generate(n, 3, 2, 2, densities[k], gen2);
+
+		// mismas filas en ambas direcciones
+		for (TState q = 0; q < n; q++)
+		{
+			for (TSymbol a = 0; a < 3; a++)
+			{
+				TNfa::TSet row(n);
+				snfa.UnionSuccessors(q, a, row);
+				assert(row == nfa.GetSuccessors(q, a));
+				assert(snfa.GetPredecessors(q, a).Count() == nfa.GetPredecessors(q, a).Count());
+				for (TState t = 0; t < n; t++)
+				{
+					assert(snfa.IsSuccessor(q, a, t) == nfa.IsSuccessor(q, a, t));
+					assert(snfa.GetPredecessors(t, a).Contains(q) == nfa.IsSuccessor(q, a, t));
+				}
+			}
+		}
+		if (n > 16) continue;
+
+		Determinization<TDfa, TNfa> det;
+		Determinization<TDfa, TSparseNfa> sdet;
+		TDfa dfa = det.Determinize(nfa);
+		TDfa sdfa = sdet.Determinize(snfa);
+		assert(dfa.GetStates() == sdfa.GetStates());
+		for (TState q = 0; q < dfa.GetStates(); q++)
+		{
+			assert(dfa.IsFinal(q) == sdfa.IsFinal(q));
+			for (TSymbol a = 0; a < 3; a++) assert(dfa.GetSuccessor(q, a) == sdfa.GetSuccessor(q, a));
+		}
+
+		MinimizationBrzozowski<TNfa, TDfa> mini;
+		MinimizationBrzozowski<TSparseNfa, TDfa> smini;
+		assert(mini.Minimize(nfa).GetStates() == smini.Minimize(snfa).GetStates());
+	}
+
+	// las modificaciones invalidan las filas construidas
+	TSparseNfa snfa(2, 4);
+	snfa.SetTransition(0, 0, 1);
+	snfa.SetTransition(0, 0, 2);
+	assert(snfa.GetSuccessors(0, 0).Count() == 2);
+	snfa.SetTransition(0, 0, 1, false);
+	snfa.SetTransition(3, 1, 0);
+	assert(snfa.GetSuccessors(0, 0).Count() == 1);
+	assert(snfa.IsSuccessor(3, 1, 0));
+	assert(snfa.GetEdgeCount() == 2);
+	snfa.Invert();
+	assert(snfa.IsSuccessor(0, 1, 3));
+	assert(snfa.GetPredecessors(0, 0).Contains(2));
+
+	cout << endl;
+
+	return 0;
+}
+
+int test205()
+{
+	cout << "Esta prueba compara la determinizacion y Atomic usando CompressedSet contra BitSet" << endl;
+
+	typedef uint16_t TState;
+	typedef uint8_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+	typedef Nfa<TState, TSymbol> TNfa;
+	typedef Nfa<TState, TSymbol, uint64_t, CompressedSet<TState>> TCompressedNfa;
+	typedef SparseNfa<TState, TSymbol, uint64_t, CompressedSet<TState>> TCompressedSparseNfa;
+
+	const float densities[] = { 0.05f, 0.3f };
+	for (auto density : densities)
+	{
+		mt19937 gen1(205), gen2(205), gen3(205);
+		NfaGenerator<TNfa, mt19937> nfagen;
+		NfaGenerator<TCompressedNfa, mt19937> cnfagen;
+		NfaGenerator<TCompressedSparseNfa, mt19937> csnfagen;
+		TNfa nfa = nfagen.Generate(16, 3, 2, 2, density, gen1);
+		TCompressedNfa cnfa = cnfagen.Generate(16, 3, 2, 2, density, gen2);
+		TCompressedSparseNfa csnfa = csnfagen.Generate(16, 3, 2, 2, density, gen3);
+
+		Determinization<TDfa, TNfa> det;
+		Determinization<TDfa, TCompressedNfa> cdet;
+		Determinization<TDfa, TCompressedSparseNfa> csdet;
+		TDfa dfa = det.Determinize(nfa);
+		TDfa cdfa = cdet.Determinize(cnfa);
+		TDfa csdfa = csdet.Determinize(csnfa);
+		assert(dfa.GetStates() == cdfa.GetStates() && dfa.GetStates() == csdfa.GetStates());
+		for (TState q = 0; q < dfa.GetStates(); q++)
+		{
+			assert(dfa.IsFinal(q) == cdfa.IsFinal(q) && dfa.IsFinal(q) == csdfa.IsFinal(q));
+			for (TSymbol a = 0; a < 3; a++)
+			{
+				assert(dfa.GetSuccessor(q, a) == cdfa.GetSuccessor(q, a));
+				assert(dfa.GetSuccessor(q, a) == csdfa.GetSuccessor(q, a));
+			}
+		}
+
+		if (dfa.GetFinals().IsEmpty()) continue;
+		MinimizationAtomic<TDfa> atomic_min;
+		MinimizationAtomic<TDfa, CompressedSet<TState>> catomic_min;
+		assert(atomic_min.Minimize(dfa).GetStates() == catomic_min.Minimize(dfa).GetStates());
+	}
+
+	cout << endl;
+
+	return 0;
+}
+
 // Tests Incremental 300-399
 
 int test300()
@@ -685,7 +900,7 @@ int test300()
 	typedef uint16_t TState;
 	typedef uint8_t TSymbol;
 	typedef Dfa<TState, TSymbol> TDfa;
-	MinimizationIncremental<TDfa> mini;
+	MinimizationIncremental<TDfa, TraceConsole> mini;
 	TDfa dfa(2, 4);
 
 	//   / 2 \
@@ -705,7 +920,6 @@ int test300()
 	dfa.SetTransition(3, 0, 3);
 	dfa.SetTransition(3, 1, 3);
 
-	mini.ShowConfiguration = true;
 	auto dfa_min = mini.Minimize(dfa);
 
 	// asegura que la cantidad de estados al final es menor
@@ -724,7 +938,7 @@ int test301()
 	typedef uint16_t TState;
 	typedef uint8_t TSymbol;
 	typedef Dfa<TState, TSymbol> TDfa;
-	MinimizationIncremental<TDfa> mini;
+	MinimizationIncremental<TDfa, TraceConsole> mini;
 	//    / 1 - 3
 	//  0
 	//    \ 2 - 4
@@ -749,7 +963,6 @@ int test301()
 	dfa.SetTransition(4, 0, 4);
 	dfa.SetTransition(4, 1, 4);
 
-	mini.ShowConfiguration = true;
 	TDfa dfa_min = mini.Minimize(dfa);
 
 	// asegura que la cantidad de estados al final es menor
@@ -767,7 +980,7 @@ int test310()
 	typedef uint16_t TState;
 	typedef uint8_t TSymbol;
 	typedef Dfa<TState, TSymbol> TDfa;
-	MinimizationIncremental<TDfa> mini;
+	MinimizationIncremental<TDfa, TraceConsole> mini;
 	TDfa dfa(2, 10);
 
 	dfa.SetInitial(0);
@@ -799,7 +1012,6 @@ int test310()
 	dfa.SetTransition(9, 0, 7);
 	dfa.SetTransition(9, 1, 9);
 
-	mini.ShowConfiguration = true;
 	auto dfa_min = mini.Minimize(dfa);
 
 	write_dot(dfa, "test_310.dot");
@@ -815,7 +1027,7 @@ int test302()
 	typedef uint16_t TState;
 	typedef uint8_t TSymbol;
 	typedef Dfa<TState, TSymbol> TDfa;
-	MinimizationIncremental<TDfa> mini;
+	MinimizationIncremental<TDfa, TraceConsole> mini;
 	// uses zero as invisible null-sink state
 	//      2 - 5 - 8  - 11
 	//    /
@@ -845,7 +1057,6 @@ int test302()
 	dfa.SetTransition(9, 1, 12);
 	dfa.SetTransition(10, 2, 13);
 
-	mini.ShowConfiguration = true;
 	auto dfa_min = mini.Minimize(dfa);
 
 	write_dot(dfa, "test_302.dot");
@@ -867,7 +1078,7 @@ int test303()
 	typedef uint16_t TState;
 	typedef uint8_t TSymbol;
 	typedef Dfa<TState, TSymbol> TDfa;
-	MinimizationIncremental<TDfa> mini;
+	MinimizationIncremental<TDfa, TraceConsole> mini;
 	// uses zero as invisible null-sink state
 	//      2 - 5 - 8  - 11
 	//    /       \   /
@@ -913,7 +1124,6 @@ int test303()
 	dfa.SetTransition(10, 1, 13);
 	dfa.SetTransition(10, 2, 13);
 
-	mini.ShowConfiguration = true;
 	auto dfa_min = mini.Minimize(dfa);
 
 	// asegura que la cantidad de estados al final es menor
@@ -934,7 +1144,7 @@ int test600()
 	typedef uint16_t TState;
 	typedef uint8_t TSymbol;
 	typedef Dfa<TState, TSymbol> TDfa;
-	MinimizationHybrid<TDfa> mini;
+	MinimizationHybrid<TDfa, TraceConsole> mini;
 	TDfa dfa(2, 4);
 
 	//   / 2 \
@@ -954,7 +1164,6 @@ int test600()
 	dfa.SetTransition(3, 0, 3);
 	dfa.SetTransition(3, 1, 3);
 
-	mini.ShowConfiguration = true;
 	auto dfa_min = mini.Minimize(dfa);
 
 	// asegura que la cantidad de estados al final es menor
@@ -973,7 +1182,7 @@ int test601()
 	typedef uint16_t TState;
 	typedef uint8_t TSymbol;
 	typedef Dfa<TState, TSymbol> TDfa;
-	MinimizationHybrid<TDfa> mini;
+	MinimizationHybrid<TDfa, TraceConsole> mini;
 	//    / 1 - 3
 	//  0
 	//    \ 2 - 4
@@ -998,7 +1207,6 @@ int test601()
 	dfa.SetTransition(4, 0, 4);
 	dfa.SetTransition(4, 1, 4);
 
-	mini.ShowConfiguration = true;
 	TDfa dfa_min = mini.Minimize(dfa);
 
 	// asegura que la cantidad de estados al final es menor
@@ -1015,7 +1223,7 @@ int test610()
 	typedef uint16_t TState;
 	typedef uint16_t TSymbol;
 	typedef Dfa<TState, TSymbol> TDfa;
-	MinimizationHybrid<TDfa> mini;
+	MinimizationHybrid<TDfa, TraceConsole> mini;
 	TDfa dfa(2, 10);
 
 	dfa.SetInitial(0);
@@ -1047,7 +1255,6 @@ int test610()
 	dfa.SetTransition(9, 0, 7);
 	dfa.SetTransition(9, 1, 9);
 
-	mini.ShowConfiguration = true;
 	write_dot(dfa, "test_610.dot");
 	auto dfa_min = mini.Minimize(dfa);
 	write_dot(dfa_min, "test_610_min.dot");
@@ -1082,7 +1289,7 @@ int test611()
 	typedef uint16_t TState;
 	typedef uint16_t TSymbol;
 	typedef Dfa<TState, TSymbol> TDfa;
-	MinimizationHybrid<TDfa> mini;
+	MinimizationHybrid<TDfa, TraceConsole> mini;
 	TDfa dfa(3, 14);
 
 	dfa.SetInitial(0);
@@ -1136,7 +1343,6 @@ int test611()
 	dfa.SetTransition(13, 1, 6);
 	dfa.SetTransition(13, 2, 6);
 
-	mini.ShowConfiguration = true;
 	write_dot(dfa, "test_611.dot");
 	auto dfa_min = mini.Minimize(dfa);
 	write_dot(dfa_min, "test_611_min.dot");
@@ -1162,7 +1368,7 @@ int test612()
 	typedef uint16_t TState;
 	typedef uint16_t TSymbol;
 	typedef Dfa<TState, TSymbol> TDfa;
-	MinimizationHybrid<TDfa> mini;
+	MinimizationHybrid<TDfa, TraceConsole> mini;
 	TDfa dfa(2, 5);
 
 	dfa.SetInitial(0);
@@ -1180,7 +1386,6 @@ int test612()
 	dfa.SetTransition(4, 0, 4);
 	dfa.SetTransition(4, 1, 1);
 
-	mini.ShowConfiguration = true;
 	write_dot(dfa, "test_612.dot");
 	auto dfa_min = mini.Minimize(dfa);
 	write_dot(dfa_min, "test_612_min.dot");
@@ -1212,7 +1417,7 @@ int test613()
 	typedef uint16_t TState;
 	typedef uint16_t TSymbol;
 	typedef Dfa<TState, TSymbol> TDfa;
-	MinimizationHybrid<TDfa> mini;
+	MinimizationHybrid<TDfa, TraceConsole> mini;
 	TDfa dfa(2, 10);
 
 	dfa.SetInitial(0);
@@ -1241,7 +1446,6 @@ int test613()
 	dfa.SetTransition(9, 0, 7);
 	dfa.SetTransition(9, 1, 6);
 
-	mini.ShowConfiguration = true;
 	write_dot(dfa, "test_613.dot");
 	auto dfa_min = mini.Minimize(dfa);
 	write_dot(dfa_min, "test_613_min.dot");
@@ -1261,7 +1465,7 @@ int test602()
 	typedef uint16_t TState;
 	typedef uint8_t TSymbol;
 	typedef Dfa<TState, TSymbol> TDfa;
-	MinimizationHybrid<TDfa> mini;
+	MinimizationHybrid<TDfa, TraceConsole> mini;
 	// uses zero as invisible null-sink state
 	//      2 - 5 - 8  - 11
 	//    /
@@ -1291,7 +1495,6 @@ int test602()
 	dfa.SetTransition(9, 1, 12);
 	dfa.SetTransition(10, 2, 13);
 
-	mini.ShowConfiguration = true;
 	auto dfa_min = mini.Minimize(dfa);
 
 	write_dot(dfa, "test_302.dot");
@@ -1313,7 +1516,7 @@ int test603()
 	typedef uint16_t TState;
 	typedef uint8_t TSymbol;
 	typedef Dfa<TState, TSymbol> TDfa;
-	MinimizationHybrid<TDfa> mini;
+	MinimizationHybrid<TDfa, TraceConsole> mini;
 	// uses zero as invisible null-sink state
 	//      2 - 5 - 8  - 11
 	//    /       \   /
@@ -1359,7 +1562,6 @@ int test603()
 	dfa.SetTransition(10, 1, 13);
 	dfa.SetTransition(10, 2, 13);
 
-	mini.ShowConfiguration = true;
 	auto dfa_min = mini.Minimize(dfa);
 
 	// asegura que la cantidad de estados al final es menor
@@ -1411,7 +1613,6 @@ int test400()
 
 					TMinimizer mini;
 					TMinimizer::NumericPartition part;
-					mini.ShowConfiguration = false;
 
 					boost::timer::cpu_timer timer;
 					timer.start();
@@ -1459,8 +1660,8 @@ int test401()
 
 	bool show_help;
 	bool enable_all;
-	bool hoproft_verbose, incremental_verbose, hybrid_verbose, atomic_verbose;
-	bool hopcroft_enable, incremental_enable, hybrid_enable, atomic_enable;
+	bool hoproft_verbose, incremental_verbose, hybrid_verbose, atomic_verbose, moore_verbose;
+	bool hopcroft_enable, incremental_enable, hybrid_enable, atomic_enable, moore_enable;
 	string output_file;
 	int seed, redundancy;
 
@@ -1477,11 +1678,13 @@ int test401()
 		("incremental", bool_switch(&incremental_enable)->default_value(false), "Enable use Incremental algorithm")
 		("hybrid", bool_switch(&hybrid_enable)->default_value(false), "Enable use Hybrid algorithm")
 		("atomic", bool_switch(&atomic_enable)->default_value(false), "Enable use Atomic algorithm")
+		("moore", bool_switch(&moore_enable)->default_value(false), "Enable use Moore algorithm")
 		("seed", value(&seed)->default_value(5000), "Seed for MT19937 random number generator")
 		("hopcroft-verbose", value(&hoproft_verbose)->default_value(false), "Verbosity for Hopcroft")
 		("incremental-verbose", value(&incremental_verbose)->default_value(false), "Verbosity for Incremental algorithm")
 		("hybrid-verbose", value(&hybrid_verbose)->default_value(false), "Verbosity for Hybrid algorithm")
 		("atomic-verbose", value(&atomic_verbose)->default_value(false), "Verbosity for Atomic algorithm")
+		("moore-verbose", value(&moore_verbose)->default_value(false), "Verbosity for Moore algorithm")
 		("output,o", value(&output_file)->default_value("report_401.csv"), "Output file")
 		("alphas,a", value(&alphas)->multitoken(), "Alphabet to test")
 		("states,s", value(&states_set)->multitoken(), "States number to test")
@@ -1512,33 +1715,38 @@ int test401()
 		cout << opt_desc << endl;
 		return 0;
 	}
-	if (enable_all) hopcroft_enable = incremental_enable = hybrid_enable = atomic_enable = true;
-	else if (!hopcroft_enable && !incremental_enable && !hybrid_enable) throw invalid_option_value("None algorithm enabled");
+	if (enable_all) hopcroft_enable = incremental_enable = hybrid_enable = atomic_enable = moore_enable = true;
+	else if (!hopcroft_enable && !incremental_enable && !hybrid_enable && !moore_enable) throw invalid_option_value("None algorithm enabled");
 
 	if (redundancy == 0) throw invalid_option_value("Invalid redundancy");
 	if (max_density > 1.0f) throw invalid_option_value("Invalid max density");
 	if (min_density < 0.0f) throw invalid_option_value("Invalid min density");
 	if (step_density < 0.0f || step_density>1.0f) throw invalid_option_value("Invalid step density");
 	if (max_density < min_density) throw invalid_option_value("max density must be greater than min density");
-	if (hoproft_verbose || hybrid_verbose || incremental_verbose) cout << "WARNING: Verbosity affects time measurements" << endl;
+	if (hoproft_verbose || hybrid_verbose || incremental_verbose || moore_verbose) cout << "WARNING: Verbosity affects time measurements" << endl;
 
 	Determinization<TDfa, TNfa> determ;
 	NfaGenerator<TNfa, mt19937> nfagen;
 
+	// los minimizadores con traza se usan solo si se pide, los tiempos son sin traza
 	MinimizationHopcroft<TDfa> min_h;
+	MinimizationHopcroft<TDfa, TraceConsole> min_h_verbose;
 	MinimizationHopcroft<TDfa>::NumericPartition p_h;
-	min_h.ShowConfiguration = hoproft_verbose;
 
 	MinimizationHybrid<TDfa> min_hi;
+	MinimizationHybrid<TDfa, TraceConsole> min_hi_verbose;
 	MinimizationHybrid<TDfa>::NumericPartition p_hi;
-	min_hi.ShowConfiguration = hybrid_verbose;
 
 	MinimizationIncremental<TDfa> min_i;
+	MinimizationIncremental<TDfa, TraceConsole> min_i_verbose;
 	MinimizationIncremental<TDfa>::NumericPartition p_i;
-	min_i.ShowConfiguration = incremental_verbose;
 
 	MinimizationAtomic<TDfa> min_at;
-	min_at.ShowConfiguration = atomic_verbose;
+	MinimizationAtomic<TDfa, TDfa::TSet, TraceConsole> min_at_verbose;
+
+	MinimizationMoore<TDfa> min_mo;
+	MinimizationMoore<TDfa, TraceConsole> min_mo_verbose;
+	MinimizationMoore<TDfa>::NumericPartition p_mo;
 
 	cpu_timer timer;
 
@@ -1546,7 +1754,7 @@ int test401()
 	ofstream report(output_file);
 	if (!report.is_open()) throw invalid_argument("No se pudo abrir el archivo");
 
-	report << "states,alpha,d,fd,states_dfa,t_h,c_h,t_i,c_i,t_hi,c_hi" << endl;
+	report << "states,alpha,d,fd,states_dfa,t_h,c_h,t_i,c_i,t_hi,c_hi,t_at,c_at,t_mo,c_mo" << endl;
 
 	for (TSymbol alpha : alphas)
 		for (TState states : states_set)
@@ -1562,13 +1770,14 @@ int test401()
 						//write_text(dfa, "automata_test.txt");
 						//write_dot(dfa, "automata_test.dot");
 
-						nanosecond_type t_h = 0, t_i = 0, t_hy = 0, t_at = 0;
-						TState c_h = 0, c_i = 0, c_hy = 0, c_at = 0;
+						nanosecond_type t_h = 0, t_i = 0, t_hy = 0, t_at = 0, t_mo = 0;
+						TState c_h = 0, c_i = 0, c_hy = 0, c_at = 0, c_mo = 0;
 
 						if (hopcroft_enable)
 						{
 							timer.start();
-							min_h.Minimize(dfa, p_h);
+							if (hoproft_verbose) min_h_verbose.Minimize(dfa, p_h);
+							else min_h.Minimize(dfa, p_h);
 							timer.stop();
 							t_h = timer.elapsed().wall;
 							c_h = p_h.GetSize();
@@ -1576,7 +1785,8 @@ int test401()
 						if (incremental_enable)
 						{
 							timer.start();
-							min_i.Minimize(dfa, p_i);
+							if (incremental_verbose) min_i_verbose.Minimize(dfa, p_i);
+							else min_i.Minimize(dfa, p_i);
 							timer.stop();
 							t_i = timer.elapsed().wall;
 							c_i = p_i.GetSize();
@@ -1584,7 +1794,8 @@ int test401()
 						if (hybrid_enable)
 						{
 							timer.start();
-							min_hi.Minimize(dfa, p_hi);
+							if (hybrid_verbose) min_hi_verbose.Minimize(dfa, p_hi);
+							else min_hi.Minimize(dfa, p_hi);
 							timer.stop();
 							t_hy = timer.elapsed().wall;
 							c_hy = p_hi.GetSize();
@@ -1592,12 +1803,21 @@ int test401()
 						if (atomic_enable)
 						{
 							timer.start();
-							auto d = min_at.Minimize(dfa);
+							auto d = atomic_verbose ? min_at_verbose.Minimize(dfa) : min_at.Minimize(dfa);
 							timer.stop();
 							t_at = timer.elapsed().wall;
 							c_at = d.GetStates();
 						}
-						auto fmt = boost::format("%1%,%2%,%3%,%4%,%5%,%6%,%7%,%8%,%9%,%10%,%11%,%12%,%13%")
+						if (moore_enable)
+						{
+							timer.start();
+							if (moore_verbose) min_mo_verbose.Minimize(dfa, p_mo);
+							else min_mo.Minimize(dfa, p_mo);
+							timer.stop();
+							t_mo = timer.elapsed().wall;
+							c_mo = p_mo.GetSize();
+						}
+						auto fmt = boost::format("%1%,%2%,%3%,%4%,%5%,%6%,%7%,%8%,%9%,%10%,%11%,%12%,%13%,%14%,%15%")
 							% states
 							% alpha
 							% den
@@ -1611,6 +1831,8 @@ int test401()
 							% c_hy
 							% t_at
 							% c_at
+							% t_mo
+							% c_mo
 							;
 						report << fmt.str() << endl;
 
@@ -1619,11 +1841,247 @@ int test401()
 						if (incremental_enable && hybrid_enable && (c_i != c_hy))  throw invalid_argument("Incremental differs of Hybrid");
 						if (atomic_enable && hopcroft_enable && (c_h != c_at))  throw invalid_argument("Atomic differs of Hopcroft");
 						if (atomic_enable && hybrid_enable && (c_hy != c_at)) throw invalid_argument("Atomic differs of Hybrid");
+						if (moore_enable && hopcroft_enable && (c_h != c_mo)) throw invalid_argument("Moore differs of Hopcroft");
 					}
 
 	return 0;
 }
 
+// Tests Moore 700-799
+
+int test700()
+{
+	cout << "Esta prueba minimiza un automata sencillo usando Moore" << endl;
+
+	typedef uint16_t TState;
+	typedef uint8_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+	MinimizationMoore<TDfa, TraceConsole> mini;
+	TDfa dfa(2, 4);
+
+	//   / 2 \
+	// 0 - 1 - 3
+	dfa.SetInitial(0);
+	dfa.SetFinal(3);
+
+	dfa.SetTransition(0, 0, 1);
+	dfa.SetTransition(0, 1, 2);
+
+	dfa.SetTransition(1, 0, 3);
+	dfa.SetTransition(1, 1, 1);
+
+	dfa.SetTransition(2, 0, 3);
+	dfa.SetTransition(2, 1, 2);
+
+	dfa.SetTransition(3, 0, 3);
+	dfa.SetTransition(3, 1, 3);
+
+	auto dfa_min = mini.Minimize(dfa);
+
+	assert(dfa_min.GetStates() == 3);
+	assert(mini.Rounds == 3);
+
+	return 0;
+}
+
+int test701()
+{
+	cout << "Compara las particiones de Moore y Hopcroft sobre DFA aleatorios" << endl;
+
+	typedef uint16_t TState;
+	typedef uint8_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+
+	mt19937 rgen(701);
+	for (int i = 0; i < 2000; i++)
+	{
+		const TState n = uniform_int_distribution<TState>(1, 50)(rgen);
+		const TSymbol k = uniform_int_distribution<int>(1, 4)(rgen);
+		// pocos destinos para obtener clases no triviales
+		uniform_int_distribution<TState> target_dist(0, uniform_int_distribution<TState>(0, n - 1)(rgen));
+		TDfa dfa(k, n);
+		dfa.SetInitial(0);
+		for (TState s = 0; s < n; s++)
+		{
+			if (i % 10 == 0 || target_dist(rgen) % 3 == 0) dfa.SetFinal(s);
+			for (TSymbol a = 0; a < k; a++) dfa.SetTransition(s, a, target_dist(rgen));
+		}
+
+		MinimizationMoore<TDfa> moore;
+		MinimizationMoore<TDfa>::NumericPartition pm;
+		moore.Minimize(dfa, pm);
+		MinimizationHopcroft<TDfa> hopcroft;
+		MinimizationHopcroft<TDfa>::NumericPartition ph;
+		hopcroft.Minimize(dfa, ph);
+
+		assert(pm.GetSize() == ph.GetSize());
+		for (TState p = 0; p < n; p++)
+		{
+			assert(pm.GetBlock(pm.Find(p)).Count() == pm.GetBlockSize(pm.Find(p)));
+			for (TState q = 0; q < n; q++) assert((pm.Find(p) == pm.Find(q)) == (ph.Find(p) == ph.Find(q)));
+		}
+		assert(moore.BuildDfa(dfa, pm).GetStates() == pm.GetSize());
+	}
+
+	return 0;
+}
+
+int test702()
+{
+	cout << "Compara Moore paralelo con Moore y entre cantidades de hilos" << endl;
+
+	typedef uint16_t TState;
+	typedef uint8_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+	typedef MinimizationMooreParallel<TDfa> TMinimizer;
+
+	mt19937 rgen(702);
+	for (int i = 0; i < 1000; i++)
+	{
+		const TState n = uniform_int_distribution<TState>(1, 80)(rgen);
+		const TSymbol k = uniform_int_distribution<int>(1, 4)(rgen);
+		uniform_int_distribution<TState> target_dist(0, uniform_int_distribution<TState>(0, n - 1)(rgen));
+		TDfa dfa(k, n);
+		dfa.SetInitial(0);
+		for (TState s = 0; s < n; s++)
+		{
+			if (i % 10 == 0 || target_dist(rgen) % 3 == 0) dfa.SetFinal(s);
+			for (TSymbol a = 0; a < k; a++) dfa.SetTransition(s, a, target_dist(rgen));
+		}
+
+		MinimizationMoore<TDfa> moore;
+		MinimizationMoore<TDfa>::NumericPartition pm;
+		moore.Minimize(dfa, pm);
+
+		// un estado por hilo como minimo, todos los hilos trabajan aun en automatas pequenos
+		TMinimizer::NumericPartition reference;
+		for (unsigned threads : { 1, 3, 7 })
+		{
+			TMinimizer parallel;
+			parallel.Threads = threads;
+			parallel.Grain = 1;
+			TMinimizer::NumericPartition pp;
+			parallel.Minimize(dfa, pp);
+			assert(pp.GetSize() == pm.GetSize());
+			assert(parallel.Rounds == moore.Rounds);
+			for (TState p = 0; p < n; p++)
+			{
+				for (TState q = 0; q < n; q++) assert((pp.Find(p) == pp.Find(q)) == (pm.Find(p) == pm.Find(q)));
+			}
+			if (threads == 1) reference = pp;
+			for (TState s = 0; s < n; s++) assert(pp.Find(s) == reference.Find(s));
+		}
+	}
+
+	return 0;
+}
+
+// Tests Dynamic 800-899
+
+int test800()
+{
+	cout << "Esta prueba edita un automata minimo y actualiza su particion" << endl;
+
+	typedef uint16_t TState;
+	typedef uint8_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+	TDfa dfa(2, 4);
+
+	//   / 2 \
+	// 0 - 1 - 3
+	dfa.SetInitial(0);
+	dfa.SetFinal(3);
+
+	dfa.SetTransition(0, 0, 1);
+	dfa.SetTransition(0, 1, 2);
+
+	dfa.SetTransition(1, 0, 3);
+	dfa.SetTransition(1, 1, 1);
+
+	dfa.SetTransition(2, 0, 3);
+	dfa.SetTransition(2, 1, 2);
+
+	dfa.SetTransition(3, 0, 3);
+	dfa.SetTransition(3, 1, 3);
+
+	MinimizationDynamic<TDfa, TraceConsole> mini(dfa);
+	assert(mini.GetSize() == 3);
+
+	// 2 se separa de 1
+	auto dfa_min = mini.Update({ make_tuple(2, 1, 3) }, {});
+	assert(dfa_min.GetStates() == 4);
+	assert(mini.LastSplits > 0);
+
+	// 1 vuelve a ser equivalente a 2 por otro camino
+	dfa_min = mini.Update({ make_tuple(1, 1, 3) }, {});
+	assert(dfa_min.GetStates() == 3);
+	assert(mini.LastMerges > 0);
+
+	// 1 y 2 son finales y equivalentes a 3
+	dfa_min = mini.Update({}, { make_pair(1, true), make_pair(2, true) });
+	assert(dfa_min.GetStates() == 2);
+
+	return 0;
+}
+
+int test801()
+{
+	cout << "Compara la actualizacion dinamica con Hopcroft tras lotes de ediciones aleatorias" << endl;
+
+	typedef uint16_t TState;
+	typedef uint8_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+	typedef MinimizationDynamic<TDfa> TMinimizer;
+
+	mt19937 rgen(801);
+	for (int i = 0; i < 300; i++)
+	{
+		const TState n = uniform_int_distribution<TState>(1, 60)(rgen);
+		const TSymbol k = uniform_int_distribution<int>(1, 3)(rgen);
+		// pocos destinos para obtener clases no triviales
+		uniform_int_distribution<TState> target_dist(0, uniform_int_distribution<TState>(0, n - 1)(rgen));
+		uniform_int_distribution<TState> state_dist(0, n - 1);
+		TDfa dfa(k, n);
+		dfa.SetInitial(0);
+		for (TState s = 0; s < n; s++)
+		{
+			if (target_dist(rgen) % 3 == 0) dfa.SetFinal(s);
+			for (TSymbol a = 0; a < k; a++) dfa.SetTransition(s, a, target_dist(rgen));
+		}
+
+		MinimizationHopcroft<TDfa> hopcroft;
+		TMinimizer::NumericPartition ph;
+		hopcroft.Minimize(dfa, ph);
+		TMinimizer dynamic(dfa, ph);
+
+		for (int batch = 0; batch < 20; batch++)
+		{
+			vector<TMinimizer::TEdge> transitions;
+			vector<pair<TState, bool>> finals;
+			const int edits = uniform_int_distribution<int>(1, 4)(rgen);
+			for (int e = 0; e < edits; e++)
+			{
+				if (rgen() % 4 == 0) finals.emplace_back(state_dist(rgen), rgen() % 2 == 0);
+				else transitions.emplace_back(state_dist(rgen), uniform_int_distribution<int>(0, k - 1)(rgen), target_dist(rgen));
+			}
+			auto dfa_min = dynamic.Update(transitions, finals);
+
+			auto edited = dynamic.GetDfa();
+			hopcroft.Minimize(edited, ph);
+			TMinimizer::NumericPartition pd;
+			dynamic.GetPartition(pd);
+			assert(pd.GetSize() == ph.GetSize());
+			assert(dfa_min.GetStates() == ph.GetSize());
+			for (TState p = 0; p < n; p++)
+			{
+				for (TState q = 0; q < n; q++) assert((pd.Find(p) == pd.Find(q)) == (ph.Find(p) == ph.Find(q)));
+			}
+		}
+	}
+
+	return 0;
+}
+
 // Test performance 500-599
 
 int test500()
@@ -1657,7 +2115,6 @@ int test500()
 
 	MinimizationHopcroft<TDfa> minh;
 	MinimizationHopcroft<TDfa>::NumericPartition hpartitions;
-	minh.ShowConfiguration = false;
 	timer.start();
 	minh.Minimize(dfa, hpartitions);
 	timer.stop();
@@ -1689,7 +2146,6 @@ int test500()
 
 	MinimizationIncremental<TDfa> mini;
 	MinimizationIncremental<TDfa>::NumericPartition part;
-	mini.ShowConfiguration = false;
 	timer.start();
 	mini.Minimize(dfa, part);
 	timer.stop();
@@ -1702,7 +2158,6 @@ int test500()
 
 	MinimizationHybrid<TDfa> minhi;
 	MinimizationHybrid<TDfa>::NumericPartition parthi;
-	minhi.ShowConfiguration = false;
 	timer.start();
 	minhi.Minimize(dfa, parthi);
 	timer.stop();
@@ -1826,7 +2281,6 @@ int test503()
 			{
 				MinimizationHopcroft<TDfa> min2;
 				MinimizationHopcroft<TDfa>::NumericPartition part_h;
-				min2.ShowConfiguration = false;
 
 				timer.start();
 				min2.Minimize(dfa, part_h);
@@ -1851,7 +2305,6 @@ int test503()
 			{
 				MinimizationIncremental<TDfa> min3;
 				MinimizationIncremental<TDfa>::NumericPartition part_i;
-				min3.ShowConfiguration = false;
 
 				timer.start();
 				min3.Minimize(dfa, part_i);
@@ -1876,7 +2329,6 @@ int test503()
 			{
 				MinimizationHybrid<TDfa> min4;
 				MinimizationHybrid<TDfa>::NumericPartition part_hi;
-				min4.ShowConfiguration = false;
 
 				timer.start();
 				min4.Minimize(dfa, part_hi);
@@ -1900,7 +2352,6 @@ int test503()
 			if (find(algorithms.begin(), algorithms.end(), algo) != algorithms.end())
 			{
 				MinimizationAtomic<TDfa> min5;
-				min5.ShowConfiguration = false;
 
 				timer.start();
 				auto mdfa = min5.Minimize(dfa);
@@ -1910,6 +2361,29 @@ int test503()
 				statesCount[algo] = mdfa.GetStates();
 			}
 
+			// MOORE
+			algo = MinimizationAlgorithm::Moore;
+			if (find(algorithms.begin(), algorithms.end(), algo) != algorithms.end())
+			{
+				MinimizationMoore<TDfa> min6;
+				MinimizationMoore<TDfa>::NumericPartition part_mo;
+
+				timer.start();
+				min6.Minimize(dfa, part_mo);
+				timer.stop();
+				report << (boost::format("%1%,%2%,%3%,%4%,%5%,%6%")
+					% "Moore"
+					% n
+					% k
+					% timer.elapsed().wall
+					% dfa_filename
+					% static_cast<size_t>(part_mo.GetSize())
+					).str() << endl;
+				if (acumTime.find(algo) == acumTime.end()) acumTime[algo] = 0;
+				acumTime[algo] += timer.elapsed().wall;
+				statesCount[algo] = part_mo.GetSize();
+			}
+
 			bool fail = false;
 			for (auto j = statesCount.begin(); j != statesCount.end(); j++)
 			{
@@ -1993,20 +2467,16 @@ int test502()
 	typedef Dfa<TState, TSymbol> TDfa;
 	typedef Nfa<TState, TSymbol> TNfa;
 
-	MinimizationHopcroft<TDfa> min_h;
-	min_h.ShowConfiguration = true;
+	MinimizationHopcroft<TDfa, TraceConsole> min_h;
 	MinimizationHopcroft<TDfa>::NumericPartition part_h;
 
-	MinimizationIncremental<TDfa> min_i;
-	min_i.ShowConfiguration = true;
+	MinimizationIncremental<TDfa, TraceConsole> min_i;
 	MinimizationIncremental<TDfa>::NumericPartition part_i;
 
-	MinimizationHybrid<TDfa> min_hi;
-	min_hi.ShowConfiguration = true;
+	MinimizationHybrid<TDfa, TraceConsole> min_hi;
 	MinimizationHybrid<TDfa>::NumericPartition part_hi;
 
-	MinimizationAtomic<TDfa> min_at;
-	min_at.ShowConfiguration = true;
+	MinimizationAtomic<TDfa, TDfa::TSet, TraceConsole> min_at;
 
 	ofstream report("report_501.csv");
 	if (!report.is_open()) throw invalid_argument("No se pudo abrir el reporte");
@@ -2087,11 +2557,9 @@ int test504()
 		for (int i = 100; i <= 10000; i += 100)
 		{
 			MinimizationHopcroft<TDfa> min_h;
-			min_h.ShowConfiguration = false;
 			MinimizationHopcroft<TDfa>::NumericPartition part_h;
 
 			MinimizationHybrid<TDfa> min_hi;
-			min_hi.ShowConfiguration = false;
 			MinimizationHybrid<TDfa>::NumericPartition part_hi;
 
 			string dfa_filename = string("experimento-25-03-2014\\k10\\") + to_string(i) + "-" + to_string(j) + ".afd";
@@ -2121,53 +2589,2383 @@ int test504()
 	return 0;
 }
 
-// Test Set 50-60
-
-int test50()
+int test505()
 {
-	cout << "Prueba de Set" << endl;
-	Set<int> s(3);
-	s.Add(0);
-	s.Add(3);
-	assert(s.Contains(0));
-	assert(!s.Contains(1));
-	assert(!s.Contains(2));
-	assert(s.Contains(3));
+	using namespace boost::timer;
 
-	auto r = s.GetIterator();
-	assert(!r.IsEnd());
-	assert(r.GetCurrent() == 0);
-	r.MoveNext();
+	cout << "Compara tiempos de minimizacion de DFA aleatorios de hasta 10000 estados con las distintas disposiciones de la tabla de transiciones" << endl;
 
-	assert(!r.IsEnd());
-	assert(r.GetCurrent() == 3);
-	r.MoveNext();
+	cpu_timer timer;
 
-	assert(r.IsEnd());
+	typedef uint16_t TState;
+	typedef uint16_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+	typedef CompactDfa<TState, TSymbol, DfaLayout::SymbolMajor> TSymbolMajorDfa;
+	typedef CompactDfa<TState, TSymbol, DfaLayout::StateMajor> TStateMajorDfa;
 
-	cout << "Prueba de BitSet" << endl;
-	BitSet<int> s2(10);
-	s2.Add(0);
-	s2.Add(3);
-	assert(s2.Contains(0));
-	assert(!s2.Contains(1));
+	ofstream report("report_505.csv");
+	if (!report.is_open()) throw invalid_argument("No se pudo abrir el reporte");
+
+	report << "alg,layout,n,k,t" << endl;
+
+	mt19937 rgen(505);
+	for (int i = 1000; i <= 10000; i += 1000)
+	{
+		const TState n = static_cast<TState>(i);
+		const TSymbol k = 10;
+		uniform_int_distribution<TState> state_dist(0, n - 1);
+		TDfa dfa(k, n);
+		dfa.SetInitial(0);
+		for (TState s = 0; s < n; s++)
+		{
+			if (state_dist(rgen) < n / 10) dfa.SetFinal(s);
+			for (TSymbol a = 0; a < k; a++) dfa.SetTransition(s, a, state_dist(rgen));
+		}
+		TSymbolMajorDfa sym(dfa);
+		TStateMajorDfa st(dfa);
+		dfa.BuildPredecessors();
+
+		MinimizationHopcroft<TDfa> h;
+		MinimizationHopcroft<TDfa>::NumericPartition part;
+		timer.start();
+		h.Minimize(dfa, part);
+		timer.stop();
+		cout << "Hopcroft Dfa " << n << ": " << timer.elapsed().wall << " " << part.GetSize() << endl;
+		report << "hopcroft,dfa," << n << "," << k << "," << timer.elapsed().wall << endl;
+
+		MinimizationHopcroft<TSymbolMajorDfa> h1;
+		MinimizationHopcroft<TSymbolMajorDfa>::NumericPartition part1;
+		timer.start();
+		h1.Minimize(sym, part1);
+		timer.stop();
+		cout << "Hopcroft SymbolMajor " << n << ": " << timer.elapsed().wall << " " << part1.GetSize() << endl;
+		report << "hopcroft,symbol-major," << n << "," << k << "," << timer.elapsed().wall << endl;
+
+		MinimizationHopcroft<TStateMajorDfa> h2;
+		MinimizationHopcroft<TStateMajorDfa>::NumericPartition part2;
+		timer.start();
+		h2.Minimize(st, part2);
+		timer.stop();
+		cout << "Hopcroft StateMajor " << n << ": " << timer.elapsed().wall << " " << part2.GetSize() << endl;
+		report << "hopcroft,state-major," << n << "," << k << "," << timer.elapsed().wall << endl;
+	}
+
+	report.close();
+
+	return 0;
+}
+
+int test506()
+{
+	using namespace boost::timer;
+
+	cout << "Minimiza un lote de DFA aleatorios pequenos y reporta las asignaciones de memoria por automata" << endl;
+	cout << "Bloques en linea por BitSet: " << BITSET_INLINE_BLOCKS << endl;
+
+	cpu_timer timer;
+
+	typedef uint16_t TState;
+	typedef uint16_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+
+	// como los corpus de Almeida, muchos automatas de pocos estados
+	const int count = 10000;
+	mt19937 rgen(506);
+	uniform_int_distribution<int> size_dist(5, 50);
+	vector<TDfa> dfas;
+	dfas.reserve(count);
+	for (int i = 0; i < count; i++)
+	{
+		const TState n = static_cast<TState>(size_dist(rgen));
+		const TSymbol k = 2;
+		uniform_int_distribution<TState> state_dist(0, n - 1);
+		FsaBuilder<TDfa> dfa(k, n);
+		dfa.SetInitial(0);
+		for (TState s = 0; s < n; s++)
+		{
+			// siempre hay al menos un final, Atomic lo requiere
+			if (s == n - 1 || state_dist(rgen) < n / 4) dfa.SetFinal(s);
+			for (TSymbol a = 0; a < k; a++) dfa.AddEdge(s, a, state_dist(rgen));
+		}
+		dfas.push_back(dfa.Build());
+	}
+
+	auto run = [&](const char* name, function<size_t(int)> minimize)
+	{
+		size_t states = 0;
+		const size_t allocations = global_allocations;
+		timer.start();
+		for (int i = 0; i < count; i++) states += minimize(i);
+		timer.stop();
+		const double seconds = timer.elapsed().wall / 1e9;
+		cout << boost::format("%-12s %10.1f automatas/s %8.1f asignaciones/automata %10u estados") % name % (count / seconds) % (double(global_allocations - allocations) / count) % states << endl;
+	};
+
+	MinimizationHopcroft<TDfa> hopcroft;
+	run("Hopcroft", [&](int i)
+	{
+		MinimizationHopcroft<TDfa>::NumericPartition part;
+		hopcroft.Minimize(dfas[i], part);
+		return static_cast<size_t>(part.GetSize());
+	});
+
+	MinimizationAtomic<TDfa> atomic_min;
+	run("Atomic", [&](int i)
+	{
+		return static_cast<size_t>(atomic_min.Minimize(dfas[i]).GetStates());
+	});
+
+	MinimizationMoore<TDfa> moore;
+	run("Moore", [&](int i)
+	{
+		MinimizationMoore<TDfa>::NumericPartition part;
+		moore.Minimize(dfas[i], part);
+		return static_cast<size_t>(part.GetSize());
+	});
+
+	return 0;
+}
+
+int test507()
+{
+	using namespace boost::timer;
+
+	cout << "Mide la minimizacion de Hopcroft y Moore de DFA aleatorios con alfabetos grandes" << endl;
+
+	cpu_timer timer;
+
+	typedef uint16_t TState;
+	typedef uint16_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+
+	ofstream report("report_507.csv");
+	if (!report.is_open()) throw invalid_argument("No se pudo abrir el reporte");
+
+	report << "alg,n,k,t,states" << endl;
+
+	mt19937 rgen(507);
+	const TState n = 5000;
+	for (TSymbol k : { 2, 16, 64, 128, 256 })
+	{
+		uniform_int_distribution<TState> state_dist(0, n - 1);
+		TDfa dfa(k, n);
+		dfa.SetInitial(0);
+		for (TState s = 0; s < n; s++)
+		{
+			if (state_dist(rgen) < n / 10) dfa.SetFinal(s);
+			// pocos destinos por simbolo, los bloques se dividen a lo largo de muchas letras
+			for (TSymbol a = 0; a < k; a++) dfa.SetTransition(s, a, (s + a * (state_dist(rgen) % 3)) % n);
+		}
+		dfa.BuildPredecessors();
+
+		MinimizationHopcroft<TDfa> h;
+		MinimizationHopcroft<TDfa>::NumericPartition part;
+		timer.start();
+		h.Minimize(dfa, part);
+		timer.stop();
+		cout << "Hopcroft n=" << n << " k=" << k << ": " << timer.format() << " " << part.GetSize() << " estados" << endl;
+		report << "hopcroft," << n << "," << k << "," << timer.elapsed().wall << "," << part.GetSize() << endl;
+
+		MinimizationMoore<TDfa> m;
+		MinimizationMoore<TDfa>::NumericPartition mpart;
+		timer.start();
+		m.Minimize(dfa, mpart);
+		timer.stop();
+		assert(mpart.GetSize() == part.GetSize());
+		cout << "Moore n=" << n << " k=" << k << ": " << timer.format() << " " << mpart.GetSize() << " estados en " << m.Rounds << " rondas" << endl;
+		report << "moore," << n << "," << k << "," << timer.elapsed().wall << "," << mpart.GetSize() << endl;
+	}
+
+	report.close();
+
+	return 0;
+}
+
+int test508()
+{
+	using namespace boost::timer;
+
+	cout << "Escalamiento de Hopcroft paralelo de 1 a 32 hilos" << endl;
+
+	cpu_timer timer;
+
+	typedef uint32_t TState;
+	typedef uint16_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+	typedef MinimizationHopcroftParallel<TDfa> TMinimizer;
+
+	ofstream report("report_508.csv");
+	if (!report.is_open()) throw invalid_argument("No se pudo abrir el reporte");
+
+	report << "alg,n,k,threads,t,states" << endl;
+
+	mt19937 rgen(508);
+	const TState n = 200000;
+	for (TSymbol k : { 2, 64 })
+	{
+		uniform_int_distribution<TState> state_dist(0, n - 1);
+		TDfa dfa(k, n);
+		dfa.SetInitial(0);
+		for (TState s = 0; s < n; s++)
+		{
+			if (state_dist(rgen) < n / 10) dfa.SetFinal(s);
+			for (TSymbol a = 0; a < k; a++) dfa.SetTransition(s, a, state_dist(rgen));
+		}
+		dfa.BuildPredecessors();
+
+		// la numeracion de la particion no depende de la cantidad de hilos
+		TMinimizer::NumericPartition reference;
+		for (unsigned threads : { 1, 2, 4, 8, 16, 32 })
+		{
+			TMinimizer h;
+			h.Threads = threads;
+			TMinimizer::NumericPartition part;
+			timer.start();
+			h.Minimize(dfa, part);
+			timer.stop();
+			cout << "Hopcroft paralelo n=" << n << " k=" << k << " hilos=" << threads << ": " << timer.format() << " " << part.GetSize() << " estados" << endl;
+			report << "hopcroft-parallel," << n << "," << k << "," << threads << "," << timer.elapsed().wall << "," << part.GetSize() << endl;
+
+			if (threads == 1) reference = part;
+			assert(part.GetSize() == reference.GetSize());
+			for (TState s = 0; s < n; s++) assert(part.Find(s) == reference.Find(s));
+		}
+	}
+
+	report.close();
+
+	return 0;
+}
+
+int test509()
+{
+	using namespace boost::timer;
+
+	cout << "Comparacion de Valmari sobre DFA parciales y Hopcroft con sumidero" << endl;
+
+	cpu_timer timer;
+
+	typedef uint32_t TState;
+	typedef uint16_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+
+	ofstream report("report_509.csv");
+	if (!report.is_open()) throw invalid_argument("No se pudo abrir el reporte");
+
+	report << "alg,n,k,m,t,states" << endl;
+
+	// automatas tipo analizador lexico: pocas transiciones definidas por estado
+	mt19937 rgen(509);
+	const TState n = 100000;
+	const int degree = 3;
+	for (TSymbol k : { 16, 64, 128 })
+	{
+		uniform_int_distribution<TState> state_dist(0, n - 1);
+		uniform_int_distribution<int> symbol_dist(0, k - 1);
+		FsaBuilder<TDfa> builder(k, n);
+		builder.SetInitial(0);
+		for (TState s = 0; s < n; s++)
+		{
+			if (state_dist(rgen) < n / 10) builder.SetFinal(s);
+			for (int j = 0; j < degree; j++) builder.AddEdge(s, symbol_dist(rgen), state_dist(rgen));
+		}
+		TDfa dfa = builder.Build();
+		TDfa complete = dfa.Complete();
+		complete.BuildPredecessors();
+		const size_t m = dfa.GetTransitionCount();
+
+		MinimizationValmari<TDfa> valmari;
+		MinimizationValmari<TDfa>::NumericPartition pv;
+		timer.start();
+		valmari.Minimize(dfa, pv);
+		timer.stop();
+		cout << "Valmari n=" << n << " k=" << k << " m=" << m << ": " << timer.format() << " " << pv.GetSize() << " estados" << endl;
+		report << "valmari," << n << "," << k << "," << m << "," << timer.elapsed().wall << "," << pv.GetSize() << endl;
+
+		MinimizationHopcroft<TDfa> hopcroft;
+		MinimizationHopcroft<TDfa>::NumericPartition ph;
+		timer.start();
+		hopcroft.Minimize(complete, ph);
+		timer.stop();
+		cout << "Hopcroft con sumidero n=" << n << " k=" << k << ": " << timer.format() << " " << ph.GetSize() << " estados" << endl;
+		report << "hopcroft-sink," << n << "," << k << "," << m << "," << timer.elapsed().wall << "," << ph.GetSize() << endl;
+	}
+
+	report.close();
+
+	return 0;
+}
+
+int test510()
+{
+	using namespace boost::timer;
+
+	cout << "Escalamiento de Moore paralelo de 1 a 32 hilos" << endl;
+
+	cpu_timer timer;
+
+	typedef uint32_t TState;
+	typedef uint16_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+	typedef MinimizationMooreParallel<TDfa> TMinimizer;
+
+	ofstream report("report_510.csv");
+	if (!report.is_open()) throw invalid_argument("No se pudo abrir el reporte");
+
+	report << "alg,n,k,threads,t,rounds,states" << endl;
+
+	// del orden de 10M transiciones
+	mt19937 rgen(510);
+	const TState n = 1000000;
+	const TSymbol k = 10;
+	uniform_int_distribution<TState> state_dist(0, n - 1);
+	TDfa dfa(k, n);
+	dfa.SetInitial(0);
+	for (TState s = 0; s < n; s++)
+	{
+		if (state_dist(rgen) < n / 10) dfa.SetFinal(s);
+		for (TSymbol a = 0; a < k; a++) dfa.SetTransition(s, a, state_dist(rgen));
+	}
+
+	MinimizationMoore<TDfa> moore;
+	MinimizationMoore<TDfa>::NumericPartition pm;
+	timer.start();
+	moore.Minimize(dfa, pm);
+	timer.stop();
+	cout << "Moore n=" << n << " k=" << k << ": " << timer.format() << " " << pm.GetSize() << " estados" << endl;
+	report << "moore," << n << "," << k << ",1," << timer.elapsed().wall << "," << moore.Rounds << "," << pm.GetSize() << endl;
+
+	// la numeracion de la particion no depende de la cantidad de hilos
+	TMinimizer::NumericPartition reference;
+	for (unsigned threads : { 1, 2, 4, 8, 16, 32 })
+	{
+		TMinimizer m;
+		m.Threads = threads;
+		TMinimizer::NumericPartition part;
+		timer.start();
+		m.Minimize(dfa, part);
+		timer.stop();
+		cout << "Moore paralelo hilos=" << threads << ": " << timer.format() << " " << part.GetSize() << " estados" << endl;
+		report << "moore-parallel," << n << "," << k << "," << threads << "," << timer.elapsed().wall << "," << m.Rounds << "," << part.GetSize() << endl;
+
+		assert(part.GetSize() == pm.GetSize());
+		if (threads == 1) reference = part;
+		for (TState s = 0; s < n; s++) assert(part.Find(s) == reference.Find(s));
+	}
+
+	report.close();
+
+	return 0;
+}
+
+int test511()
+{
+	using namespace boost::timer;
+
+	cout << "Actualizacion dinamica contra Hopcroft desde cero tras lotes de ediciones" << endl;
+
+	cpu_timer timer;
+
+	typedef uint32_t TState;
+	typedef uint16_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+	typedef MinimizationDynamic<TDfa> TMinimizer;
+
+	ofstream report("report_511.csv");
+	if (!report.is_open()) throw invalid_argument("No se pudo abrir el reporte");
+
+	report << "alg,n,k,edits,t,affected,states" << endl;
+
+	// arbol de estados como un diccionario, el estado 0 es el sumidero
+	mt19937 rgen(511);
+	const TState n = 1000000;
+	const TSymbol k = 4;
+	TDfa dfa(k, n);
+	dfa.SetInitial(1);
+	for (TState s = 0; s < n; s++)
+	{
+		for (TSymbol a = 0; a < k; a++) dfa.SetTransition(s, a, 0);
+	}
+	for (TState s = 2; s < n; s++)
+	{
+		const TState parent = uniform_int_distribution<TState>(1, s - 1)(rgen);
+		dfa.SetTransition(parent, uniform_int_distribution<int>(0, k - 1)(rgen), s);
+		if (rgen() % 4 == 0) dfa.SetFinal(s);
+	}
+
+	MinimizationHopcroft<TDfa> hopcroft;
+	TMinimizer::NumericPartition ph;
+	timer.start();
+	hopcroft.Minimize(dfa, ph);
+	timer.stop();
+	cout << "Hopcroft n=" << n << " k=" << k << ": " << timer.format() << " " << ph.GetSize() << " estados" << endl;
+	report << "hopcroft," << n << "," << k << ",0," << timer.elapsed().wall << "," << n << "," << ph.GetSize() << endl;
+
+	TMinimizer dynamic(dfa, ph);
+	uniform_int_distribution<TState> state_dist(1, n - 1);
+	for (int edits : { 1, 10, 100, 1000 })
+	{
+		// hojas nuevas o redirigidas y finales invertidos
+		vector<TMinimizer::TEdge> transitions;
+		vector<pair<TState, bool>> finals;
+		for (int e = 0; e < edits; e++)
+		{
+			const TState s = state_dist(rgen);
+			if (e % 2 == 0) finals.emplace_back(s, !dynamic.IsFinal(s));
+			else transitions.emplace_back(s, uniform_int_distribution<int>(0, k - 1)(rgen), uniform_int_distribution<TState>(s, n - 1)(rgen));
+		}
+		timer.start();
+		auto dfa_min = dynamic.Update(transitions, finals);
+		timer.stop();
+		cout << "Dinamica ediciones=" << edits << ": " << timer.format() << " " << dynamic.LastAffected << " afectados " << dfa_min.GetStates() << " estados" << endl;
+		report << "dynamic," << n << "," << k << "," << edits << "," << timer.elapsed().wall << "," << dynamic.LastAffected << "," << dfa_min.GetStates() << endl;
+
+		auto edited = dynamic.GetDfa();
+		timer.start();
+		hopcroft.Minimize(edited, ph);
+		timer.stop();
+		cout << "Hopcroft ediciones=" << edits << ": " << timer.format() << " " << ph.GetSize() << " estados" << endl;
+		report << "hopcroft," << n << "," << k << "," << edits << "," << timer.elapsed().wall << "," << n << "," << ph.GetSize() << endl;
+
+		assert(dfa_min.GetStates() == ph.GetSize());
+	}
+
+	report.close();
+
+	return 0;
+}
+
+int test512()
+{
+	using namespace boost::timer;
+
+	cout << "Costo de la traza: sin traza contra buffer circular" << endl;
+
+	cpu_timer timer;
+
+	typedef uint32_t TState;
+	typedef uint16_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+	typedef TraceRing<1 << 16> TRing;
+
+	ofstream report("report_512.csv");
+	if (!report.is_open()) throw invalid_argument("No se pudo abrir el reporte");
+
+	report << "alg,trace,n,k,t,events,states" << endl;
+
+	auto generate = [](TState n, TSymbol k, TState targets, int seed)
+	{
+		mt19937 rgen(seed);
+		uniform_int_distribution<TState> target_dist(0, targets - 1);
+		TDfa dfa(k, n);
+		dfa.SetInitial(0);
+		for (TState s = 0; s < n; s++)
+		{
+			if (target_dist(rgen) % 3 == 0) dfa.SetFinal(s);
+			for (TSymbol a = 0; a < k; a++) dfa.SetTransition(s, a, target_dist(rgen));
+		}
+		return dfa;
+	};
+	// el mejor de cinco tiempos
+	auto measure = [&](const string& alg, const string& trace, TState n, TSymbol k, function<size_t()> run)
+	{
+		nanosecond_type best = numeric_limits<nanosecond_type>::max();
+		size_t states = 0;
+		for (int r = 0; r < 5; r++)
+		{
+			timer.start();
+			states = run();
+			timer.stop();
+			best = min(best, timer.elapsed().wall);
+		}
+		cout << alg << " " << trace << " n=" << n << " k=" << k << ": " << best / 1e6 << " ms " << states << " estados" << endl;
+		return best;
+	};
+
+	{
+		const TState n = 200000;
+		const TSymbol k = 8;
+		auto dfa = generate(n, k, n, 512);
+		MinimizationHopcroft<TDfa> none;
+		MinimizationHopcroft<TDfa, TRing> ring;
+		MinimizationHopcroft<TDfa>::NumericPartition p;
+		auto t = measure("hopcroft", "none", n, k, [&]() { none.Minimize(dfa, p); return p.GetSize(); });
+		report << "hopcroft,none," << n << "," << k << "," << t << ",0," << p.GetSize() << endl;
+		t = measure("hopcroft", "ring", n, k, [&]() { ring.Trace.Clear(); ring.Minimize(dfa, p); return p.GetSize(); });
+		report << "hopcroft,ring," << n << "," << k << "," << t << "," << ring.Trace.GetCount() << "," << p.GetSize() << endl;
+	}
+	{
+		const TState n = 1500;
+		const TSymbol k = 4;
+		auto dfa = generate(n, k, n, 513);
+		MinimizationIncremental<TDfa> none;
+		MinimizationIncremental<TDfa, TRing> ring;
+		MinimizationIncremental<TDfa>::NumericPartition p;
+		auto t = measure("incremental", "none", n, k, [&]() { none.Minimize(dfa, p); return p.GetSize(); });
+		report << "incremental,none," << n << "," << k << "," << t << ",0," << p.GetSize() << endl;
+		t = measure("incremental", "ring", n, k, [&]() { ring.Trace.Clear(); ring.Minimize(dfa, p); return p.GetSize(); });
+		report << "incremental,ring," << n << "," << k << "," << t << "," << ring.Trace.GetCount() << "," << p.GetSize() << endl;
+	}
+	{
+		const TState n = 250;
+		const TSymbol k = 4;
+		auto dfa = generate(n, k, n, 514);
+		MinimizationHybrid<TDfa> none;
+		MinimizationHybrid<TDfa, TRing> ring;
+		MinimizationHybrid<TDfa>::NumericPartition p;
+		auto t = measure("hybrid", "none", n, k, [&]() { none.Minimize(dfa, p); return p.GetSize(); });
+		report << "hybrid,none," << n << "," << k << "," << t << ",0," << p.GetSize() << endl;
+		t = measure("hybrid", "ring", n, k, [&]() { ring.Trace.Clear(); ring.Minimize(dfa, p); return p.GetSize(); });
+		report << "hybrid,ring," << n << "," << k << "," << t << "," << ring.Trace.GetCount() << "," << p.GetSize() << endl;
+	}
+
+	report.close();
+
+	return 0;
+}
+
+int test513()
+{
+	using namespace boost::timer;
+
+	cout << "Minimizacion con y sin poda previa de estados inaccesibles y muertos" << endl;
+
+	cpu_timer timer;
+
+	typedef uint32_t TState;
+	typedef uint16_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+
+	ofstream report("report_513.csv");
+	if (!report.is_open()) throw invalid_argument("No se pudo abrir el reporte");
+
+	report << "alg,trim,n,k,removed,t_trim,t_min,states" << endl;
+
+	// 60% vivos, 30% muertos alcanzables y 10% inaccesibles
+	auto generate = [](TState n, TSymbol k, int seed)
+	{
+		mt19937 rgen(seed);
+		const TState live = n / 10 * 6, dead = n / 10 * 9;
+		uniform_int_distribution<TState> live_dist(0, live - 1), dead_dist(live, dead - 1), any_dist(0, n - 1);
+		uniform_int_distribution<int> percent(0, 99);
+		TDfa dfa(k, n);
+		dfa.SetInitial(0);
+		for (TState s = 0; s < n; s++)
+		{
+			const bool is_live = s < live, is_dead = s >= live && s < dead;
+			if (!is_dead && percent(rgen) < 30) dfa.SetFinal(s);
+			for (TSymbol a = 0; a < k; a++)
+			{
+				TState t;
+				if (is_live) t = percent(rgen) < 90 ? live_dist(rgen) : dead_dist(rgen);
+				else if (is_dead) t = dead_dist(rgen);
+				else t = any_dist(rgen);
+				dfa.SetTransition(s, a, t);
+			}
+		}
+		return dfa;
+	};
+
+	const TSymbol k = 4;
+	for (TState n : { 100000u, 500000u })
+	{
+		auto dfa = generate(n, k, 513);
+		MinimizationHopcroft<TDfa> hopcroft;
+		MinimizationHopcroft<TDfa>::NumericPartition p;
+
+		timer.start();
+		hopcroft.Minimize(dfa, p);
+		timer.stop();
+		auto t_min = timer.elapsed().wall;
+		cout << "hopcroft n=" << n << ": " << t_min / 1e6 << " ms " << p.GetSize() << " bloques" << endl;
+		report << "hopcroft,0," << n << "," << k << ",0,0," << t_min << "," << p.GetSize() << endl;
+
+		DfaTrimming<TDfa> trimming;
+		timer.start();
+		auto trimmed = trimming.Trim(dfa);
+		timer.stop();
+		auto t_trim = timer.elapsed().wall;
+		timer.start();
+		hopcroft.Minimize(trimmed, p);
+		timer.stop();
+		t_min = timer.elapsed().wall;
+		cout << "poda + hopcroft n=" << n << ": " << t_trim / 1e6 << " + " << t_min / 1e6 << " ms, " << trimming.Removed << " estados removidos, " << p.GetSize() << " bloques" << endl;
+		report << "hopcroft,1," << n << "," << k << "," << trimming.Removed << "," << t_trim << "," << t_min << "," << p.GetSize() << endl;
+	}
+
+	report.close();
+
+	return 0;
+}
+
+int test514()
+{
+	using namespace boost::timer;
+
+	cout << "Lotes de automatas: minimizadores nuevos contra espacios de trabajo reutilizados" << endl;
+
+	cpu_timer timer;
+
+	typedef uint16_t TState;
+	typedef uint8_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+
+	ofstream report("report_514.csv");
+	if (!report.is_open()) throw invalid_argument("No se pudo abrir el reporte");
+
+	report << "alg,mode,dfas,n,k,t" << endl;
+
+	const TSymbol k = 2;
+	// aciclicos salvo el sumidero
+	auto generate = [&](size_t count, TState n)
+	{
+		mt19937 rgen(514);
+		vector<TDfa> batch;
+		batch.reserve(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			TDfa dfa(k, n);
+			dfa.SetInitial(0);
+			for (TState s = 0; s + 1 < n; s++)
+			{
+				if (uniform_int_distribution<int>(0, 3)(rgen) == 0) dfa.SetFinal(s);
+				for (TSymbol a = 0; a < k; a++)
+				{
+					const TState t = uniform_int_distribution<TState>(s + 1, n + n / 4)(rgen);
+					dfa.SetTransition(s, a, min<TState>(t, n - 1));
+				}
+			}
+			for (TSymbol a = 0; a < k; a++) dfa.SetTransition(n - 1, a, n - 1);
+			dfa.BuildPredecessors();
+			batch.push_back(dfa);
+		}
+		return batch;
+	};
+
+	// muchos pequenos y pocos medianos
+	const pair<size_t, TState> sizes[] = { make_pair(20000, 32), make_pair(100, 256) };
+	for (const auto& size : sizes)
+	{
+		const size_t count = size.first;
+		const TState n = size.second;
+		const auto batch = generate(count, n);
+
+		auto measure = [&](const string& alg, const string& mode, function<size_t(const TDfa&)> run)
+		{
+			size_t states = 0;
+			timer.start();
+			for (const auto& dfa : batch) states += run(dfa);
+			timer.stop();
+			cout << alg << " " << mode << " " << count << "x" << n << ": " << timer.elapsed().wall / 1e6 << " ms " << states << " estados" << endl;
+			report << alg << "," << mode << "," << count << "," << n << "," << static_cast<int>(k) << "," << timer.elapsed().wall << endl;
+		};
+
+		measure("hopcroft", "fresh", [](const TDfa& dfa)
+		{
+			MinimizationHopcroft<TDfa> min;
+			MinimizationHopcroft<TDfa>::NumericPartition p;
+			min.Minimize(dfa, p);
+			return p.GetSize();
+		});
+		{
+			const MinimizationHopcroft<TDfa> min;
+			MinimizationHopcroft<TDfa>::Workspace ws;
+			MinimizationHopcroft<TDfa>::NumericPartition p;
+			measure("hopcroft", "workspace", [&](const TDfa& dfa) { min.Minimize(dfa, p, ws); return p.GetSize(); });
+		}
+		measure("incremental", "fresh", [](const TDfa& dfa)
+		{
+			MinimizationIncremental<TDfa> min;
+			MinimizationIncremental<TDfa>::NumericPartition p;
+			min.Minimize(dfa, p);
+			return p.GetSize();
+		});
+		{
+			const MinimizationIncremental<TDfa> min;
+			MinimizationIncremental<TDfa>::Workspace ws;
+			MinimizationIncremental<TDfa>::NumericPartition p;
+			measure("incremental", "workspace", [&](const TDfa& dfa) { min.Minimize(dfa, p, ws); return p.GetSize(); });
+		}
+		measure("hybrid", "fresh", [](const TDfa& dfa)
+		{
+			MinimizationHybrid<TDfa> min;
+			MinimizationHybrid<TDfa>::NumericPartition p;
+			min.Minimize(dfa, p);
+			return p.GetSize();
+		});
+		{
+			const MinimizationHybrid<TDfa> min;
+			MinimizationHybrid<TDfa>::Workspace ws;
+			MinimizationHybrid<TDfa>::NumericPartition p;
+			measure("hybrid", "workspace", [&](const TDfa& dfa) { min.Minimize(dfa, p, ws); return p.GetSize(); });
+		}
+	}
+
+	report.close();
+
+	return 0;
+}
+
+int test515()
+{
+	using namespace boost::timer;
+
+	cout << "Barrido del minimizador incremental con muchos estados equivalentes y de su particion hasta 10^6 elementos" << endl;
+
+	cpu_timer timer;
+
+	typedef uint16_t TState;
+	typedef uint8_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+
+	ofstream report("report_515.csv");
+	if (!report.is_open()) throw invalid_argument("No se pudo abrir el reporte");
+
+	report << "alg,n,k,blocks,t" << endl;
+
+	mt19937 rgen(515);
+	const TSymbol k = 2;
+	for (int i : { 100, 200, 500, 1000, 2000, 5000, 10000 })
+	{
+		// cada estado de un DFA aleatorio de n/10 estados se copia 10 veces, las copias son equivalentes
+		const TState n = static_cast<TState>(i), m = n / 10;
+		vector<TState> target(static_cast<size_t>(m) * k);
+		vector<bool> final_state(m);
+		for (auto& t : target) t = uniform_int_distribution<TState>(0, m - 1)(rgen);
+		for (TState s = 0; s < m; s++) final_state[s] = uniform_int_distribution<int>(0, 1)(rgen) == 1;
+		vector<TState> shuffled(n);
+		for (TState s = 0; s < n; s++) shuffled[s] = s;
+		shuffle(shuffled.begin(), shuffled.end(), rgen);
+
+		TDfa dfa(k, n);
+		dfa.SetInitial(shuffled[0]);
+		for (TState s = 0; s < n; s++)
+		{
+			const TState c = s % m;
+			if (final_state[c]) dfa.SetFinal(shuffled[s]);
+			for (TSymbol a = 0; a < k; a++)
+			{
+				const TState copy = uniform_int_distribution<TState>(0, n / m - 1)(rgen);
+				dfa.SetTransition(shuffled[s], a, shuffled[target[c * k + a] + copy * m]);
+			}
+		}
+
+		MinimizationIncremental<TDfa> min;
+		MinimizationIncremental<TDfa>::NumericPartition part;
+		timer.start();
+		min.Minimize(dfa, part);
+		timer.stop();
+		cout << "Incremental " << n << ": " << timer.elapsed().wall / 1e6 << " ms " << part.GetSize() << " bloques" << endl;
+		report << "incremental," << n << "," << static_cast<int>(k) << "," << part.GetSize() << "," << timer.elapsed().wall << endl;
+
+		MinimizationHopcroft<TDfa> min_h;
+		MinimizationHopcroft<TDfa>::NumericPartition part_h;
+		min_h.Minimize(dfa, part_h);
+		assert(part.GetSize() == part_h.GetSize());
+	}
+
+	// solo la particion: uniones y busquedas aleatorias hasta pocos bloques
+	for (uint32_t n : { 10000u, 100000u, 1000000u })
+	{
+		uniform_int_distribution<uint32_t> element(0, n - 1);
+		MergeablePartition<uint32_t> part(n);
+		size_t found = 0;
+		timer.start();
+		for (uint32_t i = 0; i < 2 * n; i++)
+		{
+			const uint32_t a = element(rgen), b = element(rgen);
+			if (part.Find(a) == part.Find(b)) found++;
+			else part.Union(a, b);
+		}
+		part.Compact();
+		timer.stop();
+		cout << "MergeablePartition " << n << ": " << timer.elapsed().wall / 1e6 << " ms " << part.GetSize() << " bloques" << endl;
+		report << "partition," << n << ",0," << part.GetSize() << "," << timer.elapsed().wall << endl;
+	}
+
+	report.close();
+
+	return 0;
+}
+
+int test516()
+{
+	using namespace boost::timer;
+
+	cout << "Minimizadores incremental e hibrido con estados de 32 bits, conjuntos densos contra tablas de pares" << endl;
+
+	cpu_timer timer;
+
+	typedef uint32_t TState;
+	typedef uint8_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+
+	ofstream report("report_516.csv");
+	if (!report.is_open()) throw invalid_argument("No se pudo abrir el reporte");
+
+	report << "alg,mode,n,k,blocks,t" << endl;
+
+	mt19937 rgen(516);
+	const TSymbol k = 2;
+	for (TState n : { 5000u, 10000u, 20000u })
+	{
+		// aciclicos salvo el sumidero, como en test62
+		TDfa dfa(k, n);
+		dfa.SetInitial(0);
+		for (TState s = 0; s + 1 < n; s++)
+		{
+			if (uniform_int_distribution<int>(0, 1)(rgen) == 0) dfa.SetFinal(s);
+			for (TSymbol a = 0; a < k; a++) dfa.SetTransition(s, a, min<TState>(n - 1, uniform_int_distribution<TState>(s + 1, n + n / 4)(rgen)));
+		}
+		for (TSymbol a = 0; a < k; a++) dfa.SetTransition(n - 1, a, n - 1);
+		dfa.BuildPredecessors();
+
+		const MinimizationIncremental<TDfa> incremental;
+		TState blocks = 0;
+		for (bool dense : { true, false })
+		{
+			MinimizationIncremental<TDfa>::Workspace ws;
+			ws.DenseLimit = dense ? numeric_limits<uint64_t>::max() : 0;
+			MinimizationIncremental<TDfa>::NumericPartition p;
+			timer.start();
+			incremental.Minimize(dfa, p, ws);
+			timer.stop();
+			if (blocks == 0) blocks = p.GetSize();
+			assert(p.GetSize() == blocks);
+			const char* mode = dense ? "dense" : "tables";
+			cout << "Incremental " << mode << " " << n << ": " << timer.elapsed().wall / 1e6 << " ms " << p.GetSize() << " bloques" << endl;
+			report << "incremental," << mode << "," << n << "," << static_cast<int>(k) << "," << p.GetSize() << "," << timer.elapsed().wall << endl;
+		}
+
+		// sin bitsets de pares, la memoria sigue a los pares alcanzados
+		MinimizationHybrid<TDfa> hybrid;
+		MinimizationHybrid<TDfa>::NumericPartition py;
+		timer.start();
+		hybrid.Minimize(dfa, py);
+		timer.stop();
+		cout << "Hybrid " << n << ": " << timer.elapsed().wall / 1e6 << " ms " << py.GetSize() << " bloques" << endl;
+		report << "hybrid,tables," << n << "," << static_cast<int>(k) << "," << py.GetSize() << "," << timer.elapsed().wall << endl;
+	}
+
+	report.close();
+
+	return 0;
+}
+
+int test517()
+{
+	using namespace boost::timer;
+
+	cout << "Minimizador incremental en cadenas de hasta 50000 estados y en DFA aleatorios" << endl;
+
+	cpu_timer timer;
+
+	typedef uint16_t TState;
+	typedef uint8_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+
+	ofstream report("report_517.csv");
+	if (!report.is_open()) throw invalid_argument("No se pudo abrir el reporte");
+
+	report << "dfa,n,k,blocks,t" << endl;
+
+	auto measure = [&](const string& name, const TDfa& dfa)
+	{
+		MinimizationIncremental<TDfa> min;
+		MinimizationIncremental<TDfa>::NumericPartition part;
+		timer.start();
+		min.Minimize(dfa, part);
+		timer.stop();
+		cout << name << " " << dfa.GetStates() << ": " << timer.elapsed().wall / 1e6 << " ms " << part.GetSize() << " bloques" << endl;
+		report << name << "," << dfa.GetStates() << "," << static_cast<int>(dfa.GetAlphabetLength()) << "," << part.GetSize() << "," << timer.elapsed().wall << endl;
+	};
+
+	// estados equivalentes, la primera prueba recorre la cadena entera
+	for (TState n : { 10000, 20000, 30000, 40000, 50000 })
+	{
+		TDfa dfa(2, n);
+		dfa.SetInitial(0);
+		for (TState s = 0; s < n; s++)
+		{
+			dfa.SetFinal(s);
+			dfa.SetTransition(s, 0, s + 1 < n ? s + 1 : s);
+			dfa.SetTransition(s, 1, 0);
+		}
+		measure("chain", dfa);
+	}
+
+	// pruebas cortas y numerosas
+	mt19937 rgen(517);
+	for (TState n : { 1000, 2000, 4000 })
+	{
+		const TSymbol k = 2;
+		TDfa dfa(k, n);
+		dfa.SetInitial(0);
+		for (TState s = 0; s < n; s++)
+		{
+			if (uniform_int_distribution<int>(0, 1)(rgen) == 0) dfa.SetFinal(s);
+			for (TSymbol a = 0; a < k; a++) dfa.SetTransition(s, a, uniform_int_distribution<TState>(0, n - 1)(rgen));
+		}
+		measure("random", dfa);
+	}
+
+	report.close();
+
+	return 0;
+}
+
+int test518()
+{
+	using namespace boost::timer;
+
+	cout << "Calidad del minimizador incremental con presupuesto y plazo en DFA con muchos estados equivalentes" << endl;
+
+	cpu_timer timer;
+
+	typedef uint16_t TState;
+	typedef uint8_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+	typedef MinimizationIncremental<TDfa> TMin;
+
+	ofstream report("report_518.csv");
+	if (!report.is_open()) throw invalid_argument("No se pudo abrir el reporte");
+
+	report << "limit,value,n,k,blocks,minimal,t" << endl;
+
+	// cada estado de un DFA aleatorio de n/10 estados se copia 10 veces, las copias son equivalentes
+	mt19937 rgen(518);
+	const TSymbol k = 2;
+	const TState n = 5000, m = n / 10;
+	vector<TState> target(static_cast<size_t>(m) * k);
+	vector<bool> final_state(m);
+	for (auto& t : target) t = uniform_int_distribution<TState>(0, m - 1)(rgen);
+	for (TState s = 0; s < m; s++) final_state[s] = uniform_int_distribution<int>(0, 1)(rgen) == 1;
+	vector<TState> shuffled(n);
+	for (TState s = 0; s < n; s++) shuffled[s] = s;
+	shuffle(shuffled.begin(), shuffled.end(), rgen);
+
+	TDfa dfa(k, n);
+	dfa.SetInitial(shuffled[0]);
+	for (TState s = 0; s < n; s++)
+	{
+		const TState c = s % m;
+		if (final_state[c]) dfa.SetFinal(shuffled[s]);
+		for (TSymbol a = 0; a < k; a++)
+		{
+			const TState copy = uniform_int_distribution<TState>(0, n / m - 1)(rgen);
+			dfa.SetTransition(shuffled[s], a, shuffled[target[c * k + a] + copy * m]);
+		}
+	}
+
+	TMin min;
+	TMin::Workspace ws;
+	auto measure = [&](const string& limit, uint64_t value, const TMin::Budget& budget)
+	{
+		TMin::NumericPartition part;
+		timer.start();
+		const bool minimal = min.Minimize(dfa, part, ws, budget);
+		timer.stop();
+		cout << limit << " " << value << ": " << timer.elapsed().wall / 1e6 << " ms " << part.GetSize() << " bloques" << (minimal ? " minimo" : "") << endl;
+		report << limit << "," << value << "," << n << "," << static_cast<int>(k) << "," << part.GetSize() << "," << minimal << "," << timer.elapsed().wall << endl;
+	};
+
+	// pasos de las busquedas
+	for (uint64_t steps = 1000; steps <= 100000000; steps *= 10)
+	{
+		TMin::Budget budget;
+		budget.Steps = steps;
+		measure("steps", steps, budget);
+	}
+
+	// plazos en milisegundos
+	for (uint64_t ms : { 1, 10, 50, 100, 500, 1000, 5000 })
+	{
+		TMin::Budget budget;
+		budget.Deadline = chrono::steady_clock::now() + chrono::milliseconds(ms);
+		measure("deadline", ms, budget);
+	}
+
+	report.close();
+
+	return 0;
+}
+
+// Test Set 50-65
+
+int test50()
+{
+	cout << "Prueba de Set" << endl;
+	Set<int> s(3);
+	s.Add(0);
+	s.Add(3);
+	assert(s.Contains(0));
+	assert(!s.Contains(1));
+	assert(!s.Contains(2));
+	assert(s.Contains(3));
+
+	auto r = s.GetIterator();
+	assert(!r.IsEnd());
+	assert(r.GetCurrent() == 0);
+	r.MoveNext();
+
+	assert(!r.IsEnd());
+	assert(r.GetCurrent() == 3);
+	r.MoveNext();
+
+	assert(r.IsEnd());
+
+	cout << "Prueba de BitSet" << endl;
+	BitSet<int> s2(10);
+	s2.Add(0);
+	s2.Add(3);
+	assert(s2.Contains(0));
+	assert(!s2.Contains(1));
 	assert(!s2.Contains(2));
 	assert(s2.Contains(3));
 
-	auto r2 = s2.GetIterator();
-	assert(!r2.IsEnd());
-	assert(r2.GetCurrent() == 0);
-	r2.MoveNext();
+	auto r2 = s2.GetIterator();
+	assert(!r2.IsEnd());
+	assert(r2.GetCurrent() == 0);
+	r2.MoveNext();
+
+	assert(!r2.IsEnd());
+	assert(r2.GetCurrent() == 3);
+	r2.MoveNext();
+
+	assert(r2.IsEnd());
+
+	return 0;
+}
+
+int test51()
+{
+	cout << "Prueba de la funcion inversa del DFA" << endl;
+
+	typedef uint16_t TState;
+	typedef uint8_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+
+	mt19937 rgen(51);
+	uniform_int_distribution<int> state_dist(0, 199);
+	TDfa dfa(3, 200);
+	for (TState s = 0; s < 200; s++)
+		for (TSymbol a = 0; a < 3; a++)
+			dfa.SetTransition(s, a, state_dist(rgen));
+
+	for (int round = 0; round < 2; round++)
+	{
+		for (TSymbol a = 0; a < 3; a++)
+		{
+			size_t total = 0;
+			for (TState t = 0; t < 200; t++)
+			{
+				auto pred = dfa.GetPredecessors(t, a);
+				total += pred.Count();
+				TState last = 0;
+				for (auto s : pred)
+				{
+					assert(dfa.GetSuccessor(s, a) == t);
+					assert(last <= s);
+					last = s;
+				}
+			}
+			assert(total == 200);
+		}
+		// the inverse function must follow later modifications
+		dfa.SetTransition(0, 0, 199);
+		dfa.SetTransition(199, 2, 0);
+	}
+	assert(dfa.GetPredecessors(199, 0)[0] == 0);
+
+	return 0;
+}
+
+
+int test52()
+{
+	cout << "Prueba de construccion por lotes de transiciones desde varios hilos" << endl;
+
+	typedef uint16_t TState;
+	typedef uint8_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+	typedef Nfa<TState, TSymbol> TNfa;
+	typedef SparseNfa<TState, TSymbol> TSparseNfa;
+
+	const TState states = 500;
+	const TSymbol alpha = 4;
+	mt19937 rgen(52);
+	uniform_int_distribution<int> state_dist(0, states - 1);
+
+	TDfa dfa(alpha, states);
+	dfa.SetInitial(0);
+	FsaBuilder<TDfa>::TEdgeBatch all;
+	for (TState s = 0; s < states; s++)
+	{
+		if (s % 7 == 0) dfa.SetFinal(s);
+		for (TSymbol a = 0; a < alpha; a++)
+		{
+			TState t = state_dist(rgen);
+			dfa.SetTransition(s, a, t);
+			all.emplace_back(s, a, t);
+		}
+	}
+	shuffle(all.begin(), all.end(), rgen);
+
+	// el numero de estados y simbolos crece con las transiciones
+	FsaBuilder<TDfa> builder;
+	vector<thread> workers;
+	const size_t batches = 4;
+	for (size_t k = 0; k < batches; k++)
+	{
+		workers.emplace_back([&builder, &all, k, batches]()
+		{
+			FsaBuilder<TDfa>::TEdgeBatch batch(all.begin() + all.size() * k / batches, all.begin() + all.size() * (k + 1) / batches);
+			builder.AddEdges(move(batch));
+		});
+	}
+	for (auto& w : workers) w.join();
+	builder.SetInitial(0);
+	for (TState s = 0; s < states; s += 7) builder.SetFinal(s);
+	assert(builder.GetStates() == states);
+	assert(builder.GetAlphabetLength() == alpha);
+
+	TDfa built = builder.Build();
+	assert(built.GetStates() == states);
+	assert(built.GetAlphabetLength() == alpha);
+	for (TState s = 0; s < states; s++)
+	{
+		assert(built.IsFinal(s) == dfa.IsFinal(s));
+		assert(built.IsInitial(s) == dfa.IsInitial(s));
+		for (TSymbol a = 0; a < alpha; a++)
+		{
+			assert(built.GetSuccessor(s, a) == dfa.GetSuccessor(s, a));
+			auto p1 = built.GetPredecessors(s, a);
+			auto p2 = dfa.GetPredecessors(s, a);
+			assert(p1.Count() == p2.Count() && equal(p1.begin(), p1.end(), p2.begin()));
+		}
+	}
+	// el constructor queda vacio tras construir
+	assert(builder.Build().GetStates() == states);
+
+	// constructores por lotes de los NFA
+	FsaBuilder<TNfa> nbuilder(alpha, 3);
+	FsaBuilder<TSparseNfa> sbuilder(alpha, 3);
+	nbuilder.AddEdge(0, 1, 2);
+	sbuilder.AddEdge(0, 1, 2);
+	nbuilder.AddEdges(all);
+	sbuilder.AddEdges(all);
+	TNfa nfa = nbuilder.Build();
+	TSparseNfa snfa = sbuilder.Build();
+	assert(nfa.GetStates() == states && snfa.GetStates() == states);
+	assert(snfa.GetEdgeCount() == all.size() + 1);
+	for (TState s = 0; s < states; s++)
+	{
+		for (TSymbol a = 0; a < alpha; a++)
+		{
+			TState t = dfa.GetSuccessor(s, a);
+			assert(nfa.IsSuccessor(s, a, t) && snfa.IsSuccessor(s, a, t));
+			assert(nfa.GetPredecessors(t, a).Contains(s) && snfa.GetPredecessors(t, a).Contains(s));
+		}
+	}
+	assert(nfa.IsSuccessor(0, 1, 2) && snfa.IsSuccessor(0, 1, 2));
+
+	return 0;
+}
+
+int test53()
+{
+	cout << "Prueba de los kernels vectorizados de conjuntos contra la version escalar" << endl;
+
+	typedef BitSet<uint32_t> TSet;
+
+	mt19937 rgen(53);
+	const bitset_isa isas[] = { bitset_isa::scalar, bitset_isa::avx2, bitset_isa::avx512 };
+	// longitudes con colas parciales de todos los tamanos
+	for (uint32_t bits = 1; bits < 64 * 20; bits += 37)
+	{
+		uniform_int_distribution<uint32_t> bit_dist(0, bits - 1);
+		TSet a(bits), b(bits), empty(bits);
+		for (uint32_t i = 0; i < bits / 4 + 1; i++) a.Add(bit_dist(rgen));
+		for (uint32_t i = 0; i < bits / 4 + 1; i++) b.Add(bit_dist(rgen));
+		TSet last(bits);
+		last.Add(bits - 1);
+
+		bitset_kernels::select(bitset_isa::scalar);
+		auto u = TSet::Union(a, b);
+		auto n = TSet::Intersect(a, b);
+		auto d = TSet::Difference(a, b);
+		auto ca = a.Count(), cu = u.Count();
+
+		for (auto isa : isas)
+		{
+			if (!bitset_kernels::select(isa)) continue;
+			assert(TSet::Union(a, b) == u);
+			assert(TSet::Intersect(a, b) == n);
+			assert(TSet::Difference(a, b) == d);
+			assert(a.Count() == ca && u.Count() == cu);
+			assert(empty.IsEmpty() && !last.IsEmpty() && !a.IsEmpty());
+			assert(a == a && (a == b) == (TSet::Difference(a, b).IsEmpty() && TSet::Difference(b, a).IsEmpty()));
+			assert(!(last == empty));
+			for (uint32_t i = 0; i < bits; i++)
+			{
+				assert(u.Contains(i) == (a.Contains(i) || b.Contains(i)));
+				assert(d.Contains(i) == (a.Contains(i) && !b.Contains(i)));
+			}
+		}
+	}
+	bitset_kernels::select(bitset_kernels::supported());
+	cout << "Kernels: " << bitset_kernels::active().name << endl;
+
+	return 0;
+}
+
+int test54()
+{
+	cout << "Prueba de la union de muchos conjuntos en una pasada contra uniones sucesivas" << endl;
+
+	typedef BitSet<uint32_t> TSet;
+
+	mt19937 rgen(54);
+	const bitset_isa isas[] = { bitset_isa::scalar, bitset_isa::avx2, bitset_isa::avx512 };
+	for (uint32_t bits = 1; bits < 64 * 40; bits += 131)
+	{
+		uniform_int_distribution<uint32_t> bit_dist(0, bits - 1);
+		vector<TSet> sets;
+		// cantidades que cruzan el tamano del lote
+		for (uint32_t k = 0; k < 40; k++)
+		{
+			TSet s(bits);
+			for (uint32_t i = 0; i < bits / 16 + 1; i++) s.Add(bit_dist(rgen));
+			sets.push_back(s);
+		}
+		TSet seed(bits);
+		for (uint32_t i = 0; i < bits / 8 + 1; i++) seed.Add(bit_dist(rgen));
+
+		for (size_t k = 0; k <= sets.size(); k += 3)
+		{
+			TSet expected(bits), expected_acc(seed);
+			for (size_t i = 0; i < k; i++)
+			{
+				expected.UnionWith(sets[i]);
+				expected_acc.UnionWith(sets[i]);
+			}
+			vector<const TSet*> ptrs;
+			for (size_t i = 0; i < k; i++) ptrs.push_back(&sets[i]);
+
+			for (auto isa : isas)
+			{
+				if (!bitset_kernels::select(isa)) continue;
+				TSet u(seed);
+				auto c = u.UnionOf(sets.begin(), sets.begin() + k, true);
+				assert(u == expected && c == expected.Count());
+				TSet v(bits);
+				v.UnionOf(ptrs.begin(), ptrs.end());
+				assert(v == expected);
+				TSet w(seed);
+				w.UnionWithMany(ptrs.begin(), ptrs.end());
+				assert(w == expected_acc);
+			}
+			bitset_kernels::select(bitset_kernels::supported());
+		}
+	}
+
+	// sucesores de un conjunto de estados en ambas representaciones
+	typedef Nfa<uint16_t, uint8_t> TNfa;
+	typedef SparseNfa<uint16_t, uint8_t> TSparseNfa;
+	const uint16_t states = 300;
+	const uint8_t alpha = 2;
+	TNfa nfa(alpha, states);
+	TSparseNfa snfa(alpha, states);
+	uniform_int_distribution<uint16_t> state_dist(0, states - 1);
+	for (uint16_t q = 0; q < states; q++)
+	{
+		// filas densas y dispersas
+		int n = q % 3 == 0 ? 40 : 2;
+		for (int i = 0; i < n; i++)
+		{
+			auto t = state_dist(rgen);
+			nfa.SetTransition(q, q % alpha, t);
+			snfa.SetTransition(q, q % alpha, t);
+		}
+	}
+	for (int r = 0; r < 50; r++)
+	{
+		TNfa::TSet sources(states);
+		for (int i = 0; i < r; i++) sources.Add(state_dist(rgen));
+		for (uint8_t a = 0; a < alpha; a++)
+		{
+			TNfa::TSet expected(states), dense(states), sparse(states);
+			for (auto s = sources.GetIterator(); !s.IsEnd(); s.MoveNext()) nfa.UnionSuccessors(s.GetCurrent(), a, expected);
+			dense.Add(0);
+			sparse.Add(0);
+			nfa.GatherSuccessors(sources, a, dense);
+			snfa.GatherSuccessors(sources, a, sparse);
+			assert(dense == expected);
+			assert(sparse == expected);
+		}
+	}
+
+	return 0;
+}
+
+int test55()
+{
+	cout << "Prueba de BitSet con almacenamiento en linea y en el heap" << endl;
+
+	typedef BitSet<uint32_t, uint64_t, 2> TSet;
+
+	mt19937 rgen(55);
+	// tamanos a ambos lados del limite de 128 elementos en linea
+	const uint32_t sizes[] = { 1, 64, 127, 128, 129, 300 };
+	for (auto bits : sizes)
+	{
+		uniform_int_distribution<uint32_t> bit_dist(0, bits - 1);
+		TSet a(bits);
+		for (uint32_t i = 0; i < bits / 3 + 1; i++) a.Add(bit_dist(rgen));
+		auto expected = a.to_string();
+
+		TSet copy(a);
+		assert(copy == a && copy.to_string() == expected);
+		copy.Add(bits - 1);
+		a.Remove(bits - 1);
+		assert(!(copy == a) && TSet::Difference(copy, a).Count() == 1);
+
+		TSet moved(move(copy));
+		assert(moved.Contains(bits - 1));
+		TSet target(bits);
+		target = move(moved);
+		assert(target.Contains(bits - 1));
+
+		for (auto other : sizes)
+		{
+			TSet b(other);
+			b.Add(other - 1);
+			b = a;
+			assert(b == a && b.Count() == a.Count());
+			TSet c(other);
+			c = TSet(a);
+			assert(c == a);
+		}
+
+		vector<TSet> many(10, a);
+		many.resize(100, a);
+		for (const auto& s : many) assert(s == a);
+	}
+
+	return 0;
+}
+
+int test56()
+{
+	cout << "Prueba de CompressedSet contra BitSet en los tres tipos de contenedor" << endl;
+
+	typedef uint32_t TElement;
+	typedef BitSet<TElement> TBitSet;
+	typedef CompressedSet<TElement> TSet;
+
+	mt19937 rgen(56);
+	const TElement n = 200000;
+	auto check = [&](const TSet& c, const TBitSet& b)
+	{
+		assert(c.Count() == b.Count());
+		auto j = b.GetIterator();
+		for (auto i = c.GetIterator(); !i.IsEnd(); i.MoveNext(), j.MoveNext())
+		{
+			assert(!j.IsEnd() && i.GetCurrent() == j.GetCurrent());
+		}
+		assert(j.IsEnd());
+	};
+
+	// contenedores dispersos (arreglo), densos (mapa de bits) y corridas
+	const int modes = 3;
+	vector<TSet> sets;
+	vector<TBitSet> bitsets;
+	for (int m = 0; m < modes * 3; m++)
+	{
+		TSet c(n);
+		TBitSet b(n);
+		uniform_int_distribution<TElement> dist(0, n - 1);
+		switch (m % modes)
+		{
+		case 0:
+			for (int i = 0; i < 500; i++) { auto e = dist(rgen); c.Add(e); b.Add(e); }
+			break;
+		case 1:
+			for (int i = 0; i < 60000; i++) { auto e = dist(rgen) % 70000; c.Add(e); b.Add(e); }
+			break;
+		default:
+			for (int r = 0; r < 20; r++)
+			{
+				auto s = dist(rgen) % (n - 3000);
+				for (TElement e = s; e < s + 2000; e++) { c.Add(e); b.Add(e); }
+			}
+			// las operaciones en bloque guardan las corridas
+			c = TSet::Union(c, c);
+			break;
+		}
+		check(c, b);
+		sets.push_back(c);
+		bitsets.push_back(b);
+	}
+
+	for (size_t i = 0; i < sets.size(); i++)
+	{
+		for (size_t j = 0; j < sets.size(); j++)
+		{
+			check(TSet::Union(sets[i], sets[j]), TBitSet::Union(bitsets[i], bitsets[j]));
+			check(TSet::Intersect(sets[i], sets[j]), TBitSet::Intersect(bitsets[i], bitsets[j]));
+			check(TSet::Difference(sets[i], sets[j]), TBitSet::Difference(bitsets[i], bitsets[j]));
+			assert((sets[i] == sets[j]) == (i == j));
+		}
+	}
+
+	// igualdad y hash no dependen del tipo de contenedor
+	TSet a(n), b(n);
+	for (TElement e = 0; e < 3000; e++) a.Add(e);
+	b.UnionWith(a);
+	a.Add(5000);
+	a.Remove(5000);
+	assert(a == b && TSet::hash()(a) == TSet::hash()(b));
+	for (TElement e = 0; e < 3000; e += 2) { a.Remove(e); b.Remove(e); }
+	assert(a == b && a.Count() == 1500 && !a.Contains(0) && a.Contains(1));
+	TSet u(n);
+	assert(u.UnionOf(sets.begin(), sets.end(), true) == u.Count());
+	TBitSet ub(n);
+	ub.UnionOf(bitsets.begin(), bitsets.end());
+	check(u, ub);
+
+	// memoria de subconjuntos pequenos de un universo grande
+	TSet small(n);
+	for (int i = 0; i < 10; i++) small.Add(uniform_int_distribution<TElement>(0, n - 1)(rgen));
+	cout << "Bytes de un subconjunto de 10 elementos: " << small.GetMemoryUsage() << " comprimido, " << n / 8 << " BitSet" << endl;
+	assert(small.GetMemoryUsage() < n / 8 / 10);
+
+	return 0;
+}
+
+template<typename TElement>
+void check_extract(mt19937& rgen)
+{
+	typedef BitSet<TElement> TSet;
+	const size_t max_bits = std::min<size_t>(numeric_limits<TElement>::max(), 64 * 20);
+	for (size_t bits = 1; bits <= max_bits; bits += bits < 130 ? 1 : 61)
+	{
+		// densidades desde casi vacio hasta lleno
+		for (size_t density : { 0, 1, 8, 50, 100 })
+		{
+			TSet s(static_cast<TElement>(bits));
+			for (size_t i = 0; i < bits; i++) if (rgen() % 100 < density) s.Add(static_cast<TElement>(i));
+
+			vector<TElement> expected;
+			for (auto i = s.GetIterator(); !i.IsEnd(); i.MoveNext()) expected.push_back(i.GetCurrent());
+			assert(expected.size() == s.Count());
+			for (size_t i = 0; i < expected.size(); i++)
+			{
+				assert(s.Contains(expected[i]));
+				assert(i == 0 || expected[i - 1] < expected[i]);
+			}
+
+			// un centinela al final detecta escrituras fuera del conjunto
+			vector<TElement> out(expected.size() + 1, static_cast<TElement>(0x5a));
+			auto n = s.ExtractTo(out.data());
+			assert(n == expected.size());
+			assert(equal(expected.begin(), expected.end(), out.begin()));
+			assert(out.back() == static_cast<TElement>(0x5a));
+		}
+	}
+}
+
+int test57()
+{
+	cout << "Prueba de la extraccion de elementos contra el iterador" << endl;
 
-	assert(!r2.IsEnd());
-	assert(r2.GetCurrent() == 3);
-	r2.MoveNext();
+	mt19937 rgen(57);
+	const bitset_isa isas[] = { bitset_isa::scalar, bitset_isa::avx2, bitset_isa::avx512 };
+	for (auto isa : isas)
+	{
+		if (!bitset_kernels::select(isa)) continue;
+		cout << "isa=" << bitset_kernels::active().name << endl;
+		check_extract<uint8_t>(rgen);
+		check_extract<uint16_t>(rgen);
+		check_extract<uint32_t>(rgen);
+		check_extract<uint64_t>(rgen);
+	}
+	bitset_kernels::select(bitset_kernels::supported());
+
+	// CompressedSet con contenedores de arreglo, mapa de bits y rachas
+	typedef CompressedSet<uint32_t> TCompressed;
+	const uint32_t n = 200000;
+	TCompressed c(n);
+	for (uint32_t i = 0; i < n; i += 1000) c.Add(i);
+	for (uint32_t i = 70000; i < 75000; i += 3) c.Add(i);
+	for (uint32_t i = 140000; i < 150000; i++) c.Add(i);
+	c = TCompressed::Union(c, c);
+	vector<uint32_t> expected;
+	for (auto i = c.GetIterator(); !i.IsEnd(); i.MoveNext()) expected.push_back(i.GetCurrent());
+	vector<uint32_t> out(c.Count());
+	assert(c.ExtractTo(out.data()) == expected.size());
+	assert(out == expected);
+	return 0;
+}
 
-	assert(r2.IsEnd());
+int test58()
+{
+	cout << "Prueba de RefinablePartition contra una particion de referencia" << endl;
+
+	typedef uint16_t TElement;
+	mt19937 rgen(58);
+	const TElement n = 300;
+	RefinablePartition<TElement> part;
+	part.Clear(n);
+	assert(part.GetSize() == 1);
+	assert(part.GetBlockSize(0) == n);
+
+	// referencia: bloque de cada elemento, separado por la marca de cada ronda
+	vector<TElement> reference(n, 0);
+	for (int round = 0; round < 50; round++)
+	{
+		vector<bool> marked(n, false);
+		for (int i = 0; i < 40; i++)
+		{
+			auto e = uniform_int_distribution<TElement>(0, n - 1)(rgen);
+			assert(part.Mark(e) == !marked[e]);
+			marked[e] = true;
+			assert(part.IsMarked(e));
+		}
+		const TElement before = part.GetSize();
+		part.Split([&](TElement block, TElement new_block)
+		{
+			assert(block < new_block);
+			assert(part.GetBlockSize(new_block) <= part.GetBlockSize(block));
+		});
+		assert(part.GetSize() >= before);
+
+		// dos elementos comparten bloque si y solo si compartian bloque y marca
+		map<pair<TElement, bool>, TElement> renamed;
+		for (TElement e = 0; e < n; e++)
+		{
+			auto key = make_pair(reference[e], static_cast<bool>(marked[e]));
+			auto r = renamed.insert(make_pair(key, part.Find(e)));
+			assert(r.first->second == part.Find(e));
+			assert(!part.IsMarked(e));
+		}
+		assert(renamed.size() == part.GetSize());
+		for (TElement e = 0; e < n; e++) reference[e] = part.Find(e);
+
+		size_t total = 0;
+		for (TElement b = 0; b < part.GetSize(); b++)
+		{
+			assert(part.GetMarkedCount(b) == 0);
+			for (auto e : part.GetBlock(b)) assert(part.Find(e) == b);
+			assert(part.Find(part.GetFirst(b)) == b);
+			total += part.GetBlockSize(b);
+		}
+		assert(total == n);
+	}
+
+	cout << "Prueba de MergeablePartition contra una particion de referencia" << endl;
+	MergeablePartition<TElement> merge(n);
+	assert(merge.GetSize() == n);
+	vector<TElement> ref(n);
+	for (TElement e = 0; e < n; e++) ref[e] = e;
+	for (int i = 0; i < 250; i++)
+	{
+		auto a = uniform_int_distribution<TElement>(0, n - 1)(rgen);
+		auto b = uniform_int_distribution<TElement>(0, n - 1)(rgen);
+		auto r = merge.Union(a, b);
+		assert(merge.Find(a) == r && merge.Find(b) == r);
+		const TElement from = ref[b], to = ref[a];
+		replace(ref.begin(), ref.end(), from, to);
+	}
+	merge.Compact();
+	size_t total = 0;
+	for (TElement b = 0; b < merge.GetSize(); b++)
+	{
+		assert(!merge.IsEmpty(b));
+		size_t count = 0;
+		merge.ForEach(b, [&](TElement e) { assert(merge.Find(e) == b); count++; });
+		assert(count == merge.GetBlockSize(b));
+		total += count;
+	}
+	assert(total == n);
+	for (TElement e = 0; e < n; e++)
+	{
+		for (TElement f = 0; f < n; f++) assert((ref[e] == ref[f]) == (merge.Find(e) == merge.Find(f)));
+	}
+
+	// uniones despues de compactar, los bloques conservan su numero
+	for (int i = 0; i < 100; i++)
+	{
+		auto a = uniform_int_distribution<TElement>(0, n - 1)(rgen);
+		auto b = uniform_int_distribution<TElement>(0, n - 1)(rgen);
+		const TElement fa = merge.Find(a), fb = merge.Find(b);
+		auto r = merge.Union(a, b);
+		assert(r == fa || r == fb);
+		assert(merge.Find(a) == r && merge.Find(b) == r);
+		const TElement from = ref[b], to = ref[a];
+		replace(ref.begin(), ref.end(), from, to);
+	}
+	merge.Compact();
+	for (TElement b = 0; b < merge.GetSize(); b++) merge.ForEach(b, [&](TElement e) { assert(merge.Find(e) == b); });
+	for (TElement e = 0; e < n; e++)
+	{
+		for (TElement f = 0; f < n; f++) assert((ref[e] == ref[f]) == (merge.Find(e) == merge.Find(f)));
+	}
+	return 0;
+}
+
+int test59()
+{
+	cout << "Prueba de DFA parciales y minimizacion de Valmari" << endl;
+
+	typedef uint16_t TState;
+	typedef uint8_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+
+	// transiciones indefinidas
+	TDfa partial(2, 3, true);
+	assert(!partial.IsComplete());
+	assert(partial.GetTransitionCount() == 0);
+	partial.SetInitial(0);
+	partial.SetFinal(2);
+	partial.SetTransition(0, 0, 1);
+	partial.SetTransition(1, 1, 2);
+	assert(partial.GetTransitionCount() == 2);
+	assert(partial.GetSuccessor(0, 1) == TDfa::None);
+	assert(partial.GetPredecessors(1, 0).Count() == 1);
+	assert(partial.GetPredecessors(0, 0).Count() == 0);
+	partial.SetTransition(1, 1, TDfa::None);
+	assert(partial.GetTransitionCount() == 1);
+	partial.SetTransition(1, 1, 2);
+
+	// el completado agrega un sumidero al final
+	TDfa complete = partial.Complete();
+	assert(complete.IsComplete());
+	assert(complete.GetStates() == 4);
+	assert(complete.GetSuccessor(0, 1) == 3 && complete.GetSuccessor(3, 0) == 3);
+	assert(complete.IsInitial(0) && complete.IsFinal(2) && !complete.IsFinal(3));
+
+	// los minimizadores de DFA completos rechazan los parciales tambien sin asserts
+	auto rejects = [](function<void()> minimize) -> bool
+	{
+		try
+		{
+			minimize();
+		}
+		catch (const invalid_argument&)
+		{
+			return true;
+		}
+		return false;
+	};
+	assert(rejects([&]() { CompactDfa<TState, TSymbol> compact(partial); }));
+	assert(rejects([&]() { MinimizationHopcroft<TDfa> min; MinimizationHopcroft<TDfa>::NumericPartition p; min.Minimize(partial, p); }));
+	assert(rejects([&]() { MinimizationIncremental<TDfa> min; MinimizationIncremental<TDfa>::NumericPartition p; min.Minimize(partial, p); }));
+	assert(rejects([&]() { MinimizationHybrid<TDfa> min; MinimizationHybrid<TDfa>::NumericPartition p; min.Minimize(partial, p); }));
+	assert(rejects([&]() { MinimizationMoore<TDfa> min; MinimizationMoore<TDfa>::NumericPartition p; min.Minimize(partial, p); }));
+	assert(rejects([&]() { MinimizationMooreParallel<TDfa> min; MinimizationMooreParallel<TDfa>::NumericPartition p; min.Minimize(partial, p); }));
+	assert(rejects([&]() { MinimizationDynamic<TDfa> dynamic(partial); }));
+
+	// la escritura y lectura en texto conservan las transiciones indefinidas
+	stringstream text;
+	FsaPlainTextWriter<TDfa> writer;
+	writer.Write(partial, text);
+	FsaPlainTextReader<TDfa> reader;
+	TDfa read = reader.Read(text);
+	assert(read.GetStates() == 3 && read.GetTransitionCount() == 2);
+	for (TState s = 0; s < 3; s++)
+	{
+		for (TSymbol a = 0; a < 2; a++) assert(read.GetSuccessor(s, a) == partial.GetSuccessor(s, a));
+	}
+
+	// Valmari sobre el parcial separa lo mismo que Hopcroft sobre el completado
+	mt19937 rgen(59);
+	for (int i = 0; i < 2000; i++)
+	{
+		const TState n = uniform_int_distribution<TState>(1, 40)(rgen);
+		const TSymbol k = uniform_int_distribution<int>(1, 4)(rgen);
+		const int density = uniform_int_distribution<int>(1, 10)(rgen);
+		uniform_int_distribution<TState> state_dist(0, n - 1);
+		FsaBuilder<TDfa> builder(k, n);
+		builder.SetInitial(0);
+		for (TState s = 0; s < n; s++)
+		{
+			if (state_dist(rgen) < n / 4) builder.SetFinal(s);
+			for (TSymbol a = 0; a < k; a++)
+			{
+				if (uniform_int_distribution<int>(0, 9)(rgen) < density) builder.AddEdge(s, a, state_dist(rgen));
+			}
+		}
+		TDfa dfa = builder.Build();
+
+		MinimizationValmari<TDfa> valmari;
+		MinimizationValmari<TDfa>::NumericPartition pv;
+		valmari.Minimize(dfa, pv);
+		MinimizationHopcroft<TDfa> hopcroft;
+		MinimizationHopcroft<TDfa>::NumericPartition ph;
+		hopcroft.Minimize(dfa.Complete(), ph);
+		for (TState p = 0; p < n; p++)
+		{
+			for (TState q = 0; q < n; q++) assert((pv.Find(p) == pv.Find(q)) == (ph.Find(p) == ph.Find(q)));
+		}
+
+		// el cociente no tiene transiciones hacia los estados muertos
+		TDfa min = valmari.BuildDfa(dfa, pv);
+		assert(min.GetStates() == pv.GetSize());
+		for (TState s = 0; s < n; s++)
+		{
+			for (TSymbol a = 0; a < k; a++)
+			{
+				TState t = dfa.GetSuccessor(s, a);
+				TState mt = min.GetSuccessor(pv.Find(s), a);
+				assert(mt == TDfa::None || (t != TDfa::None && mt == pv.Find(t)));
+			}
+		}
+	}
+	return 0;
+}
+
+int test60()
+{
+	cout << "Prueba de las politicas de traza de los minimizadores" << endl;
+
+	typedef uint16_t TState;
+	typedef uint8_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+
+	mt19937 rgen(60);
+	const TState n = 300;
+	const TSymbol k = 3;
+	uniform_int_distribution<TState> target_dist(0, 40);
+	TDfa dfa(k, n);
+	dfa.SetInitial(0);
+	for (TState s = 0; s < n; s++)
+	{
+		if (target_dist(rgen) % 3 == 0) dfa.SetFinal(s);
+		for (TSymbol a = 0; a < k; a++) dfa.SetTransition(s, a, target_dist(rgen));
+	}
+
+	MinimizationHopcroft<TDfa> none;
+	MinimizationHopcroft<TDfa>::NumericPartition pn;
+	none.Minimize(dfa, pn);
+
+	// todos los eventos caben en el buffer
+	MinimizationHopcroft<TDfa, TraceRing<1 << 16>> ring;
+	MinimizationHopcroft<TDfa>::NumericPartition pr;
+	ring.Minimize(dfa, pr);
+	assert(pr.GetSize() == pn.GetSize());
+	for (TState s = 0; s < n; s++) assert(pr.Find(s) == pn.Find(s));
+	assert(ring.Trace.GetSize() == ring.Trace.GetCount());
+	assert(ring.Trace[0].Event == TraceEvent::Initial && ring.Trace[0].B == n);
+	size_t splits = 0;
+	for (size_t i = 0; i < ring.Trace.GetSize(); i++)
+	{
+		if (ring.Trace[i].Event == TraceEvent::Split) splits++;
+	}
+	// cada division agrega un bloque a los dos iniciales
+	assert(splits + ring.Trace[0].A == pn.GetSize());
+
+	// un buffer pequeno conserva los ultimos eventos
+	MinimizationHopcroft<TDfa, TraceRing<8>> small;
+	small.Minimize(dfa, pr);
+	assert(small.Trace.GetCount() == ring.Trace.GetCount());
+	assert(small.Trace.GetSize() == 8);
+	for (size_t i = 0; i < 8; i++)
+	{
+		const auto& e = small.Trace[i];
+		const auto& f = ring.Trace[ring.Trace.GetSize() - 8 + i];
+		assert(e.Event == f.Event && e.A == f.A && e.B == f.B && e.C == f.C);
+	}
+	assert(small.Trace[7].Event == TraceEvent::Finished && small.Trace[7].A == pn.GetSize());
+	small.Trace.Write(cout);
+
+	MinimizationIncremental<TDfa, TraceRing<1 << 16>> incremental;
+	MinimizationIncremental<TDfa>::NumericPartition pi;
+	incremental.Minimize(dfa, pi);
+	assert(pi.GetSize() == pn.GetSize());
+	const auto& last = incremental.Trace[incremental.Trace.GetSize() - 1];
+	assert(last.Event == TraceEvent::Finished && last.A == pn.GetSize());
+
+	return 0;
+}
+
+int test61()
+{
+	cout << "Prueba de la poda de estados inaccesibles y muertos" << endl;
+
+	typedef uint16_t TState;
+	typedef uint8_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+	typedef Nfa<TState, TSymbol> TNfa;
+	typedef SparseNfa<TState, TSymbol> TSparseNfa;
+
+	// 4 es inaccesible, 2 y 3 no alcanzan al final
+	TDfa fixed(2, 5);
+	fixed.SetInitial(0);
+	fixed.SetFinal(1);
+	fixed.SetTransition(0, 0, 1);
+	fixed.SetTransition(0, 1, 2);
+	fixed.SetTransition(1, 0, 1);
+	fixed.SetTransition(1, 1, 3);
+	fixed.SetTransition(2, 0, 3);
+	fixed.SetTransition(2, 1, 2);
+	fixed.SetTransition(3, 0, 2);
+	fixed.SetTransition(3, 1, 3);
+	fixed.SetTransition(4, 0, 1);
+	fixed.SetTransition(4, 1, 0);
+	DfaTrimming<TDfa> dtrim;
+	TDfa trimmed = dtrim.Trim(fixed);
+	assert(dtrim.Removed == 2 && trimmed.GetStates() == 3 && trimmed.IsComplete());
+	assert(dtrim.Map[0] == 0 && dtrim.Map[1] == 1 && dtrim.Map[2] == 2 && dtrim.Map[3] == 2 && dtrim.Map[4] == TDfa::None);
+	assert(trimmed.IsInitial(0) && trimmed.IsFinal(1) && !trimmed.IsFinal(2));
+	assert(trimmed.GetSuccessor(0, 1) == 2 && trimmed.GetSuccessor(1, 1) == 2);
+	assert(trimmed.GetSuccessor(2, 0) == 2 && trimmed.GetSuccessor(2, 1) == 2);
+
+	// sin sumidero en el parcial, las transiciones a los muertos quedan indefinidas
+	TDfa partial(2, 4, true);
+	partial.SetInitial(0);
+	partial.SetFinal(1);
+	partial.SetTransition(0, 0, 1);
+	partial.SetTransition(0, 1, 2);
+	partial.SetTransition(2, 0, 2);
+	trimmed = dtrim.Trim(partial);
+	assert(dtrim.Removed == 2 && trimmed.GetStates() == 2 && !trimmed.IsComplete());
+	assert(trimmed.GetSuccessor(0, 0) == 1 && trimmed.GetSuccessor(0, 1) == TDfa::None);
+
+	mt19937 rgen(61);
+	for (int i = 0; i < 2000; i++)
+	{
+		const TState n = uniform_int_distribution<TState>(1, 40)(rgen);
+		const TSymbol k = uniform_int_distribution<int>(1, 3)(rgen);
+		const bool complete = i % 2 == 0;
+		uniform_int_distribution<TState> state_dist(0, n - 1);
+		FsaBuilder<TDfa> builder(k, n);
+		builder.SetInitial(0);
+		for (TState s = 0; s < n; s++)
+		{
+			if (state_dist(rgen) < n / 8) builder.SetFinal(s);
+			for (TSymbol a = 0; a < k; a++)
+			{
+				if (complete || uniform_int_distribution<int>(0, 9)(rgen) < 7) builder.AddEdge(s, a, state_dist(rgen));
+			}
+		}
+		TDfa dfa = builder.Build();
+		if (complete) dfa = dfa.Complete();
+
+		trimmed = dtrim.Trim(dfa);
+		assert(!dfa.IsComplete() || trimmed.IsComplete());
+		assert(static_cast<TState>(dtrim.Removed + trimmed.GetStates()) == n);
+
+		// los estados conservados reconocen lo mismo que en el original
+		MinimizationValmari<TDfa> valmari;
+		MinimizationValmari<TDfa>::NumericPartition po, pt;
+		valmari.Minimize(dfa, po);
+		valmari.Minimize(trimmed, pt);
+		for (TState p = 0; p < n; p++)
+		{
+			if (dtrim.Map[p] == TDfa::None) continue;
+			for (TState q = 0; q < n; q++)
+			{
+				if (dtrim.Map[q] == TDfa::None) continue;
+				assert((po.Find(p) == po.Find(q)) == (pt.Find(dtrim.Map[p]) == pt.Find(dtrim.Map[q])));
+			}
+		}
+
+		// una segunda poda no encuentra nada
+		DfaTrimming<TDfa> again;
+		assert(again.Trim(trimmed).GetStates() == trimmed.GetStates() && again.Removed == 0);
+	}
+
+	for (int i = 0; i < 300; i++)
+	{
+		const TState n = uniform_int_distribution<TState>(1, 12)(rgen);
+		const int edges = uniform_int_distribution<int>(0, 2 * n)(rgen);
+		uniform_int_distribution<TState> state_dist(0, n - 1);
+		TNfa nfa(2, n);
+		TSparseNfa snfa(2, n);
+		nfa.SetInitial(0);
+		snfa.SetInitial(0);
+		for (TState s = 0; s < n; s++)
+		{
+			if (state_dist(rgen) < 2) { nfa.SetInitial(s); snfa.SetInitial(s); }
+			if (state_dist(rgen) < 2) { nfa.SetFinal(s); snfa.SetFinal(s); }
+		}
+		for (int e = 0; e < edges; e++)
+		{
+			const TState s = state_dist(rgen), t = state_dist(rgen);
+			const TSymbol a = uniform_int_distribution<int>(0, 1)(rgen);
+			nfa.SetTransition(s, a, t);
+			snfa.SetTransition(s, a, t);
+		}
+
+		NfaTrimming<TNfa> ntrim;
+		NfaTrimming<TSparseNfa> strim;
+		TNfa tnfa = ntrim.Trim(nfa);
+		TSparseNfa tsnfa = strim.Trim(snfa);
+		assert(ntrim.Removed == strim.Removed && ntrim.Map == strim.Map);
+		assert(tsnfa.GetEdgeCount() <= snfa.GetEdgeCount());
+
+		// el lenguaje no cambia, los minimos tienen el mismo tamano
+		Determinization<TDfa, TNfa> det;
+		Determinization<TDfa, TSparseNfa> sdet;
+		MinimizationHopcroft<TDfa> hopcroft;
+		const TState original = hopcroft.Minimize(det.Determinize(nfa)).GetStates();
+		assert(hopcroft.Minimize(det.Determinize(tnfa)).GetStates() == original);
+		assert(hopcroft.Minimize(sdet.Determinize(tsnfa)).GetStates() == original);
+	}
+
+	return 0;
+}
+
+int test62()
+{
+	cout << "Prueba de la reutilizacion de los espacios de trabajo, en serie y con varios hilos" << endl;
+
+	typedef uint16_t TState;
+	typedef uint8_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+
+	// la mitad aciclicos salvo el sumidero, la otra mitad con ciclos y muchos estados equivalentes
+	mt19937 rgen(62);
+	vector<TDfa> batch;
+	for (int i = 0; i < 400; i++)
+	{
+		const TState n = uniform_int_distribution<TState>(2, i % 50 == 0 ? 150 : 40)(rgen);
+		const TSymbol k = uniform_int_distribution<int>(1, 3)(rgen);
+		TDfa dfa(k, n);
+		dfa.SetInitial(0);
+		if (i % 2 == 0)
+		{
+			for (TState s = 0; s + 1 < n; s++)
+			{
+				if (uniform_int_distribution<int>(0, 3)(rgen) == 0) dfa.SetFinal(s);
+				for (TSymbol a = 0; a < k; a++)
+				{
+					const TState t = uniform_int_distribution<TState>(s + 1, n + n / 4)(rgen);
+					dfa.SetTransition(s, a, min<TState>(t, n - 1));
+				}
+			}
+			for (TSymbol a = 0; a < k; a++) dfa.SetTransition(n - 1, a, n - 1);
+		}
+		else
+		{
+			// cada estado de un DFA aleatorio de n/4 estados se copia, las copias son equivalentes
+			const TState m = max<TState>(1, n / 4);
+			vector<TState> target(static_cast<size_t>(m) * k);
+			for (auto& t : target) t = uniform_int_distribution<TState>(0, m - 1)(rgen);
+			for (TState s = 0; s < n; s++)
+			{
+				const TState c = s % m;
+				if (c % 3 == 0) dfa.SetFinal(s);
+				for (TSymbol a = 0; a < k; a++)
+				{
+					const TState t = target[c * k + a] + uniform_int_distribution<TState>(0, n / m - 1)(rgen) * m;
+					dfa.SetTransition(s, a, t < n ? t : target[c * k + a]);
+				}
+			}
+		}
+		dfa.BuildPredecessors();
+		batch.push_back(dfa);
+	}
+
+	// referencias de Hopcroft con un minimizador nuevo en cada automata
+	vector<vector<TState>> reference;
+	for (const auto& dfa : batch)
+	{
+		MinimizationHopcroft<TDfa> hopcroft;
+		MinimizationHopcroft<TDfa>::NumericPartition p;
+		hopcroft.Minimize(dfa, p);
+		vector<TState> blocks(dfa.GetStates());
+		for (TState s = 0; s < dfa.GetStates(); s++) blocks[s] = p.Find(s);
+		reference.push_back(blocks);
+	}
+	auto same = [&](size_t i, function<TState(TState)> find)
+	{
+		const auto& blocks = reference[i];
+		for (TState p = 0; p < blocks.size(); p++)
+		{
+			for (TState q = 0; q < blocks.size(); q++)
+			{
+				if ((blocks[p] == blocks[q]) != (find(p) == find(q))) return false;
+			}
+		}
+		return true;
+	};
+
+	const MinimizationHopcroft<TDfa> hopcroft;
+	const MinimizationIncremental<TDfa> incremental;
+	const MinimizationHybrid<TDfa> hybrid;
+	auto run = [&](size_t first, size_t step)
+	{
+		// los espacios crecen con el mayor automata y se reutilizan con los menores
+		MinimizationHopcroft<TDfa>::Workspace wh;
+		MinimizationIncremental<TDfa>::Workspace wi;
+		MinimizationHybrid<TDfa>::Workspace wy;
+		MinimizationHopcroft<TDfa>::NumericPartition ph;
+		MinimizationIncremental<TDfa>::NumericPartition pi;
+		MinimizationHybrid<TDfa>::NumericPartition py;
+		bool ok = true;
+		for (size_t i = first; i < batch.size(); i += step)
+		{
+			hopcroft.Minimize(batch[i], ph, wh);
+			incremental.Minimize(batch[i], pi, wi);
+			hybrid.Minimize(batch[i], py, wy);
+			ok = ok && same(i, [&](TState s) { return ph.Find(s); });
+			ok = ok && same(i, [&](TState s) { return pi.Find(s); });
+			ok = ok && same(i, [&](TState s) { return py.Find(s); });
+		}
+		return ok;
+	};
+	assert(run(0, 1));
+
+	const size_t threads = 4;
+	vector<thread> pool;
+	vector<char> results(threads, 0);
+	for (size_t t = 0; t < threads; t++)
+	{
+		pool.emplace_back([&, t]() { results[t] = run(t, threads); });
+	}
+	for (auto& t : pool) t.join();
+	for (auto r : results) assert(r);
+
+	// el minimizador sin espacio explicito reutiliza el suyo
+	MinimizationIncremental<TDfa> own;
+	for (size_t i = 0; i < batch.size(); i++)
+	{
+		MinimizationIncremental<TDfa>::NumericPartition p;
+		own.Minimize(batch[i], p);
+		assert(same(i, [&](TState s) { return p.Find(s); }));
+	}
+
+	return 0;
+}
+
+int test63()
+{
+	cout << "Prueba de la numeracion exacta de pares y de las tablas de pares" << endl;
+
+	typedef uint32_t TState;
+	typedef PairIndexing::TPairIndex TPairIndex;
+	mt19937 rgen(63);
+
+	// filas pequenas, filas cerca de 2^16 y de 2^32
+	vector<uint64_t> rows = { 1, 2, 3, 1000, 46340, 46341, 65535, 65536, 100000, 3037000499ULL, 4294967295ULL };
+	for (int i = 0; i < 1000; i++) rows.push_back(uniform_int_distribution<uint64_t>(1, 4294967295ULL)(rgen));
+	for (auto q : rows)
+	{
+		for (uint64_t p : { uint64_t(0), q / 2, q - 1, uniform_int_distribution<uint64_t>(0, q - 1)(rgen) })
+		{
+			const TPairIndex index = PairIndexing::GetIndex(p, q);
+			assert(index == q * (q - 1) / 2 + p);
+			TState p2, q2;
+			tie(p2, q2) = PairIndexing::GetPair<TState>(index);
+			assert(p2 == p && q2 == q);
+		}
+		// las filas son consecutivas
+		if (q < 4294967295ULL) assert(PairIndexing::GetIndex(q - 1, q) + 1 == PairIndexing::GetIndex(0, q + 1));
+	}
+	for (TPairIndex index = 0; index < 100000; index++)
+	{
+		TState p, q;
+		tie(p, q) = PairIndexing::GetPair<TState>(index);
+		assert(PairIndexing::GetIndex(p, q) == index);
+	}
+
+	// tabla contra un mapa de referencia, se reutiliza tras cada Clear
+	PairTable<uint32_t> table;
+	for (int round = 0; round < 5; round++)
+	{
+		map<TPairIndex, uint32_t> reference;
+		uniform_int_distribution<TPairIndex> key(0, round % 2 ? 1000 : ~TPairIndex(0) - 1);
+		for (int i = 0; i < 20000; i++)
+		{
+			const TPairIndex k = key(rgen);
+			bool inserted;
+			uint32_t& value = table.Insert(k, inserted);
+			assert(inserted == (reference.count(k) == 0));
+			if (inserted) assert(value == 0);
+			value += i;
+			reference[k] += i;
+			const TPairIndex absent = key(rgen);
+			assert(table.Contains(absent) == (reference.count(absent) > 0));
+		}
+		assert(table.GetSize() == reference.size());
+		assert(table.GetCapacity() >= 2 * table.GetSize());
+		for (auto& r : reference)
+		{
+			assert(table.Find(r.first) && *table.Find(r.first) == r.second);
+			assert(table.TestAndAdd(r.first));
+		}
+		table.Clear();
+		assert(table.GetSize() == 0);
+		for (auto& r : reference) assert(!table.Contains(r.first) && table.Find(r.first) == nullptr);
+	}
+
+	// los minimizadores con estados de 32 bits dan lo mismo que con 16 bits
+	typedef Dfa<uint16_t, uint8_t> TDfa16;
+	typedef Dfa<TState, uint8_t> TDfa32;
+	for (int i = 0; i < 100; i++)
+	{
+		const uint16_t n = uniform_int_distribution<uint16_t>(2, 150)(rgen);
+		const uint8_t k = uniform_int_distribution<int>(1, 3)(rgen);
+		TDfa16 dfa16(k, n);
+		TDfa32 dfa32(k, n);
+		dfa16.SetInitial(0);
+		dfa32.SetInitial(0);
+		// la mitad aciclicos salvo el sumidero, la otra mitad con ciclos
+		const bool acyclic = i % 2 == 0;
+		for (uint16_t s = 0; s < n; s++)
+		{
+			if ((!acyclic || s + 1 < n) && uniform_int_distribution<int>(0, 2)(rgen) == 0)
+			{
+				dfa16.SetFinal(s);
+				dfa32.SetFinal(s);
+			}
+			for (uint8_t a = 0; a < k; a++)
+			{
+				const uint16_t t = !acyclic ? uniform_int_distribution<uint16_t>(0, n - 1)(rgen) : s + 1 < n ? min<int>(n - 1, uniform_int_distribution<int>(s + 1, n + n / 4)(rgen)) : n - 1;
+				dfa16.SetTransition(s, a, t);
+				dfa32.SetTransition(s, a, t);
+			}
+		}
+		dfa16.BuildPredecessors();
+		dfa32.BuildPredecessors();
+
+		MinimizationHopcroft<TDfa16> hopcroft;
+		MinimizationHopcroft<TDfa16>::NumericPartition ph;
+		hopcroft.Minimize(dfa16, ph);
+
+		MinimizationIncremental<TDfa32> incremental;
+		MinimizationIncremental<TDfa32>::NumericPartition pi;
+		incremental.Minimize(dfa32, pi);
+		assert(pi.GetSize() == ph.GetSize());
+		for (uint16_t p = 0; p < n; p++)
+		{
+			for (uint16_t q = 0; q < n; q++) assert((pi.Find(p) == pi.Find(q)) == (ph.Find(p) == ph.Find(q)));
+		}
+
+		// solo tablas de pares, la misma particion con la misma numeracion
+		MinimizationIncremental<TDfa32>::Workspace sparse;
+		sparse.DenseLimit = 0;
+		MinimizationIncremental<TDfa32>::NumericPartition ps;
+		incremental.Minimize(dfa32, ps, sparse);
+		assert(ps.GetSize() == pi.GetSize());
+		for (uint16_t s = 0; s < n; s++) assert(ps.Find(s) == pi.Find(s));
+
+		MinimizationHybrid<TDfa16> hybrid16;
+		MinimizationHybrid<TDfa16>::NumericPartition py16;
+		hybrid16.Minimize(dfa16, py16);
+		assert(py16.GetSize() == ph.GetSize());
+		for (uint16_t p = 0; p < n; p++)
+		{
+			for (uint16_t q = 0; q < n; q++) assert((py16.Find(p) == py16.Find(q)) == (ph.Find(p) == ph.Find(q)));
+		}
+		MinimizationHybrid<TDfa32> hybrid32;
+		MinimizationHybrid<TDfa32>::NumericPartition py32;
+		hybrid32.Minimize(dfa32, py32);
+		assert(py32.GetSize() == py16.GetSize());
+		for (uint16_t s = 0; s < n; s++) assert(py32.Find(s) == py16.Find(s));
+	}
 
 	return 0;
 }
 
+int test64()
+{
+	cout << "Prueba de EquivP sin recursion en cadenas profundas y DFA aleatorios" << endl;
+
+	typedef uint16_t TState;
+	typedef uint8_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+
+	auto check = [](const TDfa& dfa)
+	{
+		MinimizationHopcroft<TDfa> hopcroft;
+		MinimizationHopcroft<TDfa>::NumericPartition ph;
+		hopcroft.Minimize(dfa, ph);
+		MinimizationIncremental<TDfa> incremental;
+		MinimizationIncremental<TDfa>::NumericPartition pi;
+		incremental.Minimize(dfa, pi);
+		assert(pi.GetSize() == ph.GetSize());
+		// cada bloque de Hopcroft es un bloque del incremental
+		vector<TState> block(ph.GetSize(), TDfa::None);
+		for (TState s = 0; s < dfa.GetStates(); s++)
+		{
+			if (block[ph.Find(s)] == TDfa::None) block[ph.Find(s)] = pi.Find(s);
+			assert(block[ph.Find(s)] == pi.Find(s));
+		}
+		return pi.GetSize();
+	};
+
+	// cadena de 50000 estados finales, la letra 1 vuelve al inicio: todos son equivalentes
+	// y la primera prueba recorre los 50000 pares (i, i+1) de una vez
+	{
+		const TState n = 50000;
+		TDfa dfa(2, n);
+		dfa.SetInitial(0);
+		for (TState s = 0; s < n; s++)
+		{
+			dfa.SetFinal(s);
+			dfa.SetTransition(s, 0, s + 1 < n ? s + 1 : s);
+			dfa.SetTransition(s, 1, 0);
+		}
+		assert(check(dfa) == 1);
+	}
+
+	// cadena con un solo final al fondo: cada prueba falla tras recorrer la cadena entera
+	{
+		const TState n = 3000;
+		TDfa dfa(2, n);
+		dfa.SetInitial(0);
+		dfa.SetFinal(n - 1);
+		for (TState s = 0; s < n; s++)
+		{
+			dfa.SetTransition(s, 0, s + 1 < n ? s + 1 : s);
+			dfa.SetTransition(s, 1, s);
+		}
+		assert(check(dfa) == n);
+	}
+
+	mt19937 rgen(64);
+	for (int i = 0; i < 200; i++)
+	{
+		const TState n = uniform_int_distribution<TState>(1, 200)(rgen);
+		const TSymbol k = uniform_int_distribution<int>(1, 3)(rgen);
+		TDfa dfa(k, n);
+		dfa.SetInitial(0);
+		// la mitad son cadenas con saltos cortos, profundas y con muchos pares equivalentes
+		const bool deep = i % 2 == 0;
+		for (TState s = 0; s < n; s++)
+		{
+			if (uniform_int_distribution<int>(0, 3)(rgen) == 0) dfa.SetFinal(s);
+			for (TSymbol a = 0; a < k; a++)
+			{
+				const TState t = deep ? min<int>(n - 1, s + uniform_int_distribution<int>(0, 2)(rgen)) : uniform_int_distribution<TState>(0, n - 1)(rgen);
+				dfa.SetTransition(s, a, t);
+			}
+		}
+		check(dfa);
+	}
+
+	return 0;
+}
+
+int test65()
+{
+	cout << "Prueba del minimizador incremental con presupuesto, plazo y cancelacion" << endl;
+
+	typedef uint16_t TState;
+	typedef uint8_t TSymbol;
+	typedef Dfa<TState, TSymbol> TDfa;
+	typedef MinimizationIncremental<TDfa> TMin;
+
+	// el cociente de un DFA por la particion de una minimizacion detenida reconoce el mismo lenguaje
+	auto minimal_size = [](const TDfa& dfa)
+	{
+		MinimizationHopcroft<TDfa> hopcroft;
+		MinimizationHopcroft<TDfa>::NumericPartition part;
+		hopcroft.Minimize(dfa, part);
+		return part.GetSize();
+	};
+
+	mt19937 rgen(65);
+	for (int i = 0; i < 100; i++)
+	{
+		// la mitad son cinco copias de un DFA aleatorio, con muchos estados equivalentes
+		const TState copies = i % 2 == 0 ? 5 : 1;
+		const TState m = uniform_int_distribution<TState>(1, 30)(rgen), n = m * copies;
+		const TSymbol k = uniform_int_distribution<int>(1, 3)(rgen);
+		vector<TState> target(static_cast<size_t>(m) * k);
+		for (auto& t : target) t = uniform_int_distribution<TState>(0, m - 1)(rgen);
+		vector<bool> final_state(m);
+		for (TState c = 0; c < m; c++) final_state[c] = uniform_int_distribution<int>(0, 2)(rgen) == 0;
+		TDfa dfa(k, n);
+		dfa.SetInitial(0);
+		for (TState s = 0; s < n; s++)
+		{
+			const TState c = s % m;
+			if (final_state[c]) dfa.SetFinal(s);
+			for (TSymbol a = 0; a < k; a++)
+			{
+				const TState copy = uniform_int_distribution<TState>(0, copies - 1)(rgen);
+				dfa.SetTransition(s, a, target[c * k + a] + copy * m);
+			}
+		}
+
+		TMin min;
+		TMin::Workspace ws;
+		TMin::NumericPartition full;
+		assert(min.Minimize(dfa, full, ws, TMin::Budget()));
+		const TState blocks = minimal_size(dfa);
+		assert(full.GetSize() == blocks);
+
+		// presupuestos crecientes: cada particion junta solo estados equivalentes y no tiene mas bloques que la anterior
+		TState last = n;
+		for (uint64_t steps : { 0, 1, 10, 100, 1000, 10000, 1000000 })
+		{
+			TMin::Budget budget;
+			budget.Steps = steps;
+			TMin::NumericPartition part;
+			const bool minimal = min.Minimize(dfa, part, ws, budget);
+			assert(part.GetSize() >= blocks && part.GetSize() <= last);
+			assert(!minimal || part.GetSize() == blocks);
+			// sin pasos solo se saltan los pares de finalidad distinta
+			if (steps == 0) assert(part.GetSize() == n);
+			for (TState p = 0; p < n; p++)
+			{
+				for (TState q = p + 1; q < n; q++)
+				{
+					if (part.SameBlock(p, q)) assert(full.SameBlock(p, q));
+				}
+			}
+			last = part.GetSize();
+
+			TMin::NumericPartition seq = part;
+			const TDfa quotient = min.BuildDfa(dfa, seq);
+			assert(quotient.GetStates() == part.GetSize());
+			assert(minimal_size(quotient) == blocks);
+		}
+
+		// el espacio de trabajo de una minimizacion detenida sirve para la siguiente
+		TMin::NumericPartition again;
+		min.Minimize(dfa, again, ws);
+		for (TState s = 0; s < n; s++) assert(again.Find(s) == full.Find(s));
+	}
+
+	// cancelacion previa y plazo vencido: ninguna prueba llega a hacerse
+	{
+		const TState n = 3000;
+		TDfa dfa(2, n);
+		dfa.SetInitial(0);
+		for (TState s = 0; s < n; s++)
+		{
+			dfa.SetFinal(s);
+			dfa.SetTransition(s, 0, s + 1 < n ? s + 1 : s);
+			dfa.SetTransition(s, 1, 0);
+		}
+
+		TMin min;
+		TMin::Workspace ws;
+		TMin::NumericPartition part;
+		atomic<bool> cancel(true);
+		TMin::Budget cancelled;
+		cancelled.Cancel = &cancel;
+		assert(!min.Minimize(dfa, part, ws, cancelled));
+		assert(part.GetSize() == n);
+
+		TMin::Budget expired;
+		expired.Deadline = chrono::steady_clock::now() - chrono::seconds(1);
+		min.Limits = expired;
+		min.Minimize(dfa, part);
+		assert(!min.Minimal && part.GetSize() == n);
+
+		min.Limits = TMin::Budget();
+		min.Minimize(dfa, part);
+		assert(min.Minimal && part.GetSize() == 1);
+	}
+
+	return 0;
+}
 
 int main(int argc, char** argv)
 {
@@ -2188,17 +4986,35 @@ int main(int argc, char** argv)
 		switch (i)
 		{
 			MACRO_TEST(50);
+			MACRO_TEST(51);
+			MACRO_TEST(52);
+			MACRO_TEST(53);
+			MACRO_TEST(54);
+			MACRO_TEST(55);
+			MACRO_TEST(56);
+			MACRO_TEST(57);
+			MACRO_TEST(58);
+			MACRO_TEST(59);
+			MACRO_TEST(60);
+			MACRO_TEST(61);
+			MACRO_TEST(62);
+			MACRO_TEST(63);
+			MACRO_TEST(64);
+			MACRO_TEST(65);
 
 			MACRO_TEST(100);
 			MACRO_TEST(101);
 			MACRO_TEST(102);
 			MACRO_TEST(103);
 			MACRO_TEST(104);
+			MACRO_TEST(105);
 
 			MACRO_TEST(200);
 			MACRO_TEST(201);
 			MACRO_TEST(202);
 			MACRO_TEST(203);
+			MACRO_TEST(204);
+			MACRO_TEST(205);
 
 			MACRO_TEST(300);
 			MACRO_TEST(301);
@@ -2215,6 +5031,13 @@ int main(int argc, char** argv)
 			MACRO_TEST(612);
 			MACRO_TEST(613);
 
+			MACRO_TEST(700);
+			MACRO_TEST(701);
+			MACRO_TEST(702);
+
+			MACRO_TEST(800);
+			MACRO_TEST(801);
+
 			MACRO_TEST(400);
 			MACRO_TEST(401);
 
@@ -2222,6 +5045,20 @@ int main(int argc, char** argv)
 			MACRO_TEST(502);
 			MACRO_TEST(503);
 			MACRO_TEST(504);
+			MACRO_TEST(505);
+			MACRO_TEST(506);
+			MACRO_TEST(507);
+			MACRO_TEST(508);
+			MACRO_TEST(509);
+			MACRO_TEST(510);
+			MACRO_TEST(511);
+			MACRO_TEST(512);
+			MACRO_TEST(513);
+			MACRO_TEST(514);
+			MACRO_TEST(515);
+			MACRO_TEST(516);
+			MACRO_TEST(517);
+			MACRO_TEST(518);
 		default:
 			cout << "La prueba indicada no existe" << endl;
 			throw invalid_argument("La prueba no existe");
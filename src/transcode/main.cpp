@@ -10,6 +10,7 @@
 #include "../FsaPlainTextReader.h"
 #include "../FsaPlainTextWriter.h"
 #include "../FsaFormat.h"
+#include "../WidthDispatch.h"
 #include <boost/timer/timer.hpp>
 #include <boost/format.hpp>
 #include <boost/filesystem/fstream.hpp>
@@ -45,12 +46,13 @@ namespace transcode
 	};
 
 	// TODO: Take advantage of polymorph code when it is available
-	void Transcode(Options opt)
+	template<typename TState, typename TSymbol>
+	void Transcode(const Options& opt)
 	{
 		ifstream input_file(opt.InputFile);
 		ofstream output_file(opt.OutputFile);
 
-		typedef Nfa<uint32_t, uint32_t> TFsa;
+		typedef Nfa<TState, TSymbol> TFsa;
 
 		if(opt.InputFormat == FsaFormat::GraphViz) 
 			throw invalid_argument("GraphViz in not supported as input format");
@@ -97,6 +99,33 @@ namespace transcode
 		}
 	}
 
+	class TranscodeDispatch
+	{
+	public:
+		const Options& opt;
+
+		explicit TranscodeDispatch(const Options& o) : opt(o)
+		{
+		}
+
+		template<typename TState, typename TSymbol>
+		int Run()
+		{
+			Transcode<TState, TSymbol>(opt);
+			return 0;
+		}
+	};
+
+	void Transcode(const Options& opt)
+	{
+		if(opt.InputFormat == FsaFormat::GraphViz) 
+			throw invalid_argument("GraphViz in not supported as input format");
+
+		auto dims = WidthDispatch::Peek(opt.InputFile, opt.InputFormat);
+		TranscodeDispatch dispatch(opt);
+		WidthDispatch::Dispatch(dims.States, dims.Symbols, dispatch);
+	}
+
 }
 
 using namespace transcode;